@@ -0,0 +1,90 @@
+#include "animation.hpp"
+#include "io.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+void
+Animation::setKeyFrameInterval(size_t interval) {
+    keyFrameInterval_ = interval;
+    keyFrames_.clear();
+}
+
+Image
+Animation::getFrame(size_t frame_index) {
+    const auto frame_count = getFrameCount();
+    if (frame_index >= frame_count) {
+        throw std::out_of_range("frame index out of range");
+    }
+
+    const auto cache_key_frame = [this] {
+        if (keyFrameInterval_ > 0
+                && frameIndex_ % keyFrameInterval_ == 0
+                && frameIndex_/keyFrameInterval_ == keyFrames_.size()) {
+            keyFrames_.push_back(frame_);
+        }
+    };
+
+    const auto &loop_frame = frames_.back();
+    const auto key_frame_slot = keyFrameInterval_ > 0
+        ? std::min(frame_index/keyFrameInterval_ + 1, keyFrames_.size())
+        : 0;
+    const auto key_frame_index = key_frame_slot > 0
+        ? (key_frame_slot - 1)*keyFrameInterval_
+        : 0;
+
+    if (frameValid_ && frameIndex_ == frame_count - 1 && frame_index == 0 && loop_frame.size > 0) {
+        // Wrap around using the loop delta.
+        applyFrame(loop_frame);
+        frameIndex_ = 0;
+        cache_key_frame();
+    } else if (key_frame_slot > 0
+            && (!frameValid_ || frame_index < frameIndex_ || key_frame_index > frameIndex_)) {
+        // Jump to the closest key frame.
+        frame_ = keyFrames_[key_frame_slot - 1];
+        frameIndex_ = key_frame_index;
+        frameValid_ = true;
+    } else if (!frameValid_ || frame_index < frameIndex_) {
+        // Restart from the first frame.
+        reset();
+        applyFrame(frames_.front());
+        frameValid_ = true;
+        cache_key_frame();
+    }
+
+    while (frameIndex_ < frame_index) {
+        applyFrame(frames_[++frameIndex_]);
+        cache_key_frame();
+    }
+
+    return Image(width_, height_, frame_);
+}
+
+void
+Animation::reset() {
+    frame_.assign(width_*height_, '\0');
+    frameIndex_ = 0;
+    frameValid_ = false;
+}
+
+void
+Animation::applyFrame(const Frame &frame) {
+    if (frame.size == 0) {
+        return;
+    }
+
+    io::IMemoryStream input(data_.data() + frame.offset, frame.size);
+    input.exceptions(std::ios::failbit);
+
+    const auto delta = io::readLCWData(input, frame.size, deltaSize_);
+    io::applyFormat40Data(
+        delta.data(),
+        delta.size(),
+        reinterpret_cast<std::uint8_t *>(frame_.data()),
+        frame_.size()
+    );
+}
+
+} // namespace nr::dune2
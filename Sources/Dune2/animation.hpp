@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Dune2/image.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class nr::dune2::Animation
+/// An animation loaded from a `.wsa` file.
+///
+/// Frames are stored compressed and decoded on demand against a running
+/// frame buffer: each frame is a Format40 delta of the previous one,
+/// compressed with LCW. Reading frames in order costs one delta per frame,
+/// seeking backward restarts from the closest key frame, or from the first
+/// frame when key frames are disabled.
+///
+/// The decoding state is not synchronized, an `Animation` must not be used
+/// from several threads at the same time.
+class Animation {
+public:
+    /// ### method `nr::dune2::Animation::loadFromWSA`
+    /// Load animation from the given `.wsa` file.
+    /// #### Parameters
+    /// - `const std::filesystem::path &wsa_path` - a path to `*.wsa` file
+    void loadFromWSA(const std::filesystem::path &);
+
+    /// ### method `nr::dune2::Animation::loadFromWSA`
+    /// Load animation from the given `.wsa` data stream.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    void loadFromWSA(std::istream &);
+
+public:
+    /// ### method `nr::dune2::Animation.getWidth`
+    /// #### Return
+    /// `size_t` - the frames width in pixels.
+    size_t getWidth() const
+    { return width_; }
+
+    /// ### method `nr::dune2::Animation.getHeight`
+    /// #### Return
+    /// `size_t` - the frames height in pixels.
+    size_t getHeight() const
+    { return height_; }
+
+    /// ### method `nr::dune2::Animation.getFrameCount`
+    /// #### Return
+    /// `size_t` - the number of frames.
+    size_t getFrameCount() const
+    { return frames_.empty() ? 0 : frames_.size() - 1; }
+
+    /// ### method `nr::dune2::Animation.setKeyFrameInterval`
+    /// Keep a copy of every _interval_-th decoded frame so that seeking
+    /// never applies more than _interval - 1_ deltas. An interval of `1`
+    /// caches every frame, `0` disables the cache. Changing the interval
+    /// drops the cached frames.
+    /// #### Parameters
+    /// - `size_t interval` - the key frame interval
+    void setKeyFrameInterval(size_t);
+
+    /// ### method `nr::dune2::Animation.getFrame`
+    /// Decode a frame.
+    /// #### Parameters
+    /// - `size_t frame_index` - the frame index.
+    /// #### Return
+    /// `nr::dune2::Image` - the frame image.
+    Image getFrame(size_t frame_index);
+
+private:
+    // Range of a frame compressed data in data_.
+    struct Frame {
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
+
+    void reset();
+    void applyFrame(const Frame &);
+
+private:
+    size_t width_{0};
+    size_t height_{0};
+    size_t deltaSize_{0};
+    std::string data_;
+    // The frames followed by the loop frame, a delta from the last frame to
+    // the first one, which is empty when the animation does not loop.
+    std::vector<Frame> frames_;
+
+    size_t keyFrameInterval_{0};
+    std::vector<std::string> keyFrames_;
+
+    std::string frame_;
+    size_t frameIndex_{0};
+    bool frameValid_{false};
+};
+} // namespace nr::dune2
@@ -0,0 +1,104 @@
+#include "animation.hpp"
+#include "io.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+namespace {
+
+// The header is made of the frame count, the frames width and height, the
+// size of the delta buffer then, since v1.07, a 16 bits flags field. It is
+// followed by a table of _frame_count + 2_ offsets: one per frame, the loop
+// frame offset and the file size. The loop offset is `0` when the animation
+// does not loop, and some files end the table with `0` instead of the file
+// size.
+std::optional<std::vector<std::uint32_t>>
+wsa_read_offsets(const std::string &data, size_t header_size, size_t frame_count) {
+    const auto table_size = 4*(frame_count + 2);
+    if (header_size + table_size > data.size()) {
+        return std::nullopt;
+    }
+
+    io::IMemoryStream input(data.data() + header_size, table_size);
+    std::vector<std::uint32_t> offsets(frame_count + 2);
+    for (auto &offset: offsets) {
+        offset = io::readLEInteger<4>(input);
+    }
+
+    if (offsets.back() != 0 && offsets.back() != data.size()) {
+        return std::nullopt;
+    }
+
+    // Offsets which are not null point past the table, in order.
+    auto previous = header_size + table_size;
+    for (auto offset: offsets) {
+        if (offset == 0) {
+            continue;
+        }
+        if (offset < previous || offset > data.size()) {
+            return std::nullopt;
+        }
+        previous = offset;
+    }
+    return offsets;
+}
+} // namespace
+
+void
+Animation::loadFromWSA(const std::filesystem::path &wsa_path) {
+    std::ifstream input(wsa_path, std::ios::binary);
+    input.exceptions(std::ios::failbit|std::ios::badbit);
+    loadFromWSA(input);
+}
+
+void
+Animation::loadFromWSA(std::istream &input) {
+    auto data = io::readAll(input);
+
+    io::IMemoryStream header(data);
+    header.exceptions(std::ios::failbit);
+
+    const auto frame_count = io::readLEInteger<2>(header);
+    const auto width = io::readLEInteger<2>(header);
+    const auto height = io::readLEInteger<2>(header);
+    const auto delta_size = io::readLEInteger<2>(header);
+
+    auto table = wsa_read_offsets(data, 10, frame_count);
+    if (!table) {
+        table = wsa_read_offsets(data, 8, frame_count);
+    }
+    if (!table || frame_count == 0) {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    // Offsets of missing frames are null, a frame ends at the next offset
+    // which is not, or at the end of the file.
+    const auto &offsets = *table;
+    std::vector<Frame> frames;
+    for (auto i = 0u; i <= frame_count; ++i) {
+        const auto first = offsets[i];
+        if (first == 0) {
+            frames.push_back(Frame{0, 0});
+            continue;
+        }
+        const auto next = std::find_if(offsets.begin() + i + 1, offsets.end(), [](auto offset) {
+            return offset != 0;
+        });
+        const size_t last = next != offsets.end() ? *next : data.size();
+        frames.push_back(Frame{first, static_cast<std::uint32_t>(last - first)});
+    }
+
+    width_ = width;
+    height_ = height;
+    deltaSize_ = delta_size;
+    data_ = std::move(data);
+    frames_ = std::move(frames);
+    keyFrames_.clear();
+    reset();
+}
+
+} // namespace nr::dune2
@@ -0,0 +1,70 @@
+#include "band_renderer.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+BandRenderer::BandRenderer(
+    const Surface &surface,
+    const Palette &palette,
+    size_t band_height
+)
+    : surface_{surface}
+    , palette_{palette}
+    , bandHeight_{band_height} {
+    if (bandHeight_ == 0) {
+        throw std::invalid_argument("band height must not be null");
+    }
+}
+
+size_t
+BandRenderer::getBandCount() const {
+    return (surface_.getHeight() + bandHeight_ - 1)/bandHeight_;
+}
+
+size_t
+BandRenderer::renderBand(size_t band_index, Band &band) const {
+    trace::Span span("render.band");
+
+    const auto width = surface_.getWidth();
+    const auto first_row = band_index*bandHeight_;
+    const auto row_count = std::min(bandHeight_, surface_.getHeight() - first_row);
+
+    band.resize(width*row_count);
+
+    auto it = band.begin();
+    for (auto y = first_row; y < first_row + row_count; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            *it++ = palette_[surface_.getPixel(x, y)];
+        }
+    }
+    return row_count;
+}
+
+void
+BandRenderer::render(const BandWriter &writer, Executor &executor) const {
+    const auto band_count = getBandCount();
+    const auto batch_size = std::clamp<size_t>(
+        executor.getThreadCount(),
+        1,
+        std::max<size_t>(band_count, 1)
+    );
+
+    std::vector<Band> bands(batch_size);
+    std::vector<size_t> row_counts(batch_size);
+
+    for (size_t first = 0; first < band_count; first += batch_size) {
+        const auto count = std::min(batch_size, band_count - first);
+
+        executor.parallelFor(count, [&](size_t i) {
+            row_counts[i] = renderBand(first + i, bands[i]);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            writer(bands[i].data(), row_counts[i]);
+        }
+    }
+}
+
+} // namespace nr::dune2
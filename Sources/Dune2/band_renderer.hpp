@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Dune2/executor.hpp>
+#include <Dune2/palette.hpp>
+#include <Dune2/surface.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::BandRenderer`
+/// Render a surface band by band, a band being a fixed number of full rows.
+/// Only a bounded number of bands are held in memory at once, which allows
+/// rendering surfaces much larger than the available memory.
+class BandRenderer {
+public:
+    using Band = std::vector<Palette::Color>;
+
+    /// ### type `nr::dune2::BandRenderer::BandWriter`
+    /// A callback receiving the rendered bands in order, from top to bottom,
+    /// as _width*row_count_ pixels.
+    using BandWriter = std::function<void(const Palette::Color *, size_t row_count)>;
+
+public:
+    /// ### constructor `nr::dune2::BandRenderer`
+    /// The surface and the palette must outlive the renderer.
+    /// #### Parameters
+    /// - `const Surface &surface` - the surface to render
+    /// - `const Palette &palette` - the palette
+    /// - `size_t band_height` - the number of rows of a band
+    BandRenderer(const Surface &, const Palette &, size_t band_height = 64);
+
+public:
+    /// ### method `nr::dune2::BandRenderer.getBandCount`
+    /// #### Return
+    /// `size_t` - the number of bands.
+    size_t getBandCount() const;
+
+    /// ### method `nr::dune2::BandRenderer.renderBand`
+    /// Render one band. The last band may be shorter than the others.
+    /// #### Parameters
+    /// - `size_t band_index` - the band index
+    /// - `Band &band` - the band pixels, resized as needed
+    /// #### Return
+    /// `size_t` - the number of rows of the band.
+    size_t renderBand(size_t band_index, Band &) const;
+
+    /// ### method `nr::dune2::BandRenderer.render`
+    /// Render all the bands. As many bands as the executor has threads are
+    /// rendered concurrently, so memory usage stays in
+    /// _O(width*band_height*thread_count)_.
+    /// #### Parameters
+    /// - `const BandWriter &writer` - the callback receiving the bands
+    /// - `Executor &executor` - the executor rendering the bands
+    void render(const BandWriter &, Executor &) const;
+
+private:
+    const Surface &surface_;
+    const Palette &palette_;
+    size_t bandHeight_;
+};
+} // namespace nr::dune2
@@ -1,16 +1,15 @@
 #include "bmp.hpp"
 #include "io.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
 
-#include <cmath>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
 #include <fstream>
-
-namespace std {
-std::ostream &
-operator<<(std::ostream &output, const nr::dune2::Palette::Color &c) {
-    return output.put(c.blue).put(c.green).put(c.red);
-}
-} // namespace std
-
+#include <limits>
+#include <stdexcept>
 
 namespace nr::dune2 {
 
@@ -24,12 +23,93 @@ constexpr long long unsigned
 operator"" _ppm(long long unsigned res) {
     return res;
 }
+
+// Bitmap file header (14 bytes) followed by the info header (40 bytes).
+constexpr size_t bmp_header_size = 54;
+
+// Rows of pixels are padded to a multiple of 4 bytes.
+constexpr size_t
+bmp_row_size(size_t width) {
+    return (3*width + 3) & ~size_t{3};
+}
+
+constexpr size_t
+bmp_file_size(size_t width, size_t height) {
+    return bmp_header_size + bmp_row_size(width)*height;
+}
+
+// Rows are stored bottom-up when the height is positive and top-down when
+// the height is negative.
+void
+write_bmp_header(std::ostream &output, size_t width, std::int32_t height) {
+    const size_t rows = height < 0 ? -std::int64_t{height} : height;
+
+    // Bitmap file header
+    output.write("BM", 2);                // BMP signature
+    io::writeInteger<4>(output, bmp_file_size(width, rows));
+    io::writeInteger<4>(output, 0u);      // reserved 1, reserved 2
+    io::writeInteger<4>(output, bmp_header_size);
+
+    // Bitmap information
+    io::writeInteger<4>(output, 40u);     // size of the info header (=40)
+    io::writeInteger<4>(output, width);   // width
+    io::writeInteger<4>(output, height);  // height
+    io::writeInteger<2>(output, 1u);      // count of color plan (=1)
+    io::writeInteger<2>(output, 24u);     // number of bits per pixel (=24)
+    io::writeInteger<4>(output, 0u);      // compression method (=0)
+    io::writeInteger<4>(output, 0u);      // image size
+    io::writeInteger<4>(output, 300_ppi); // horizontal resolution of the image
+    io::writeInteger<4>(output, 300_ppi); // vertical resolution of the image
+    io::writeInteger<4>(output, 0u);      // number of colors in the palette
+    io::writeInteger<4>(output, 0u);      // number of important colors used
+}
+
+static_assert(sizeof(Palette::Color) == 3, "colors are expanded as 3 bytes");
+
+// The colors of the 256 indexes after remapping, for the expandPalette
+// kernel which reads one byte past the last color.
+using ColorTable = std::array<std::uint8_t, 3*256 + 1>;
+
+template <typename Remap>
+ColorTable
+make_color_table(const Palette &palette, Remap &&remap) {
+    ColorTable table{};
+    for (auto i = 0u; i < 256; ++i) {
+        const auto &color = palette.at(remap(std::uint8_t(i)));
+        table[3*i + 0] = color.red;
+        table[3*i + 1] = color.green;
+        table[3*i + 2] = color.blue;
+    }
+    return table;
+}
+
+void
+write_bmp_row(
+    std::ostream &output,
+    const Palette::Color *pixels,
+    size_t width,
+    std::vector<char> &row_data
+) {
+    auto it = row_data.begin();
+    std::for_each(
+        pixels,
+        pixels + width,
+        [&](const Palette::Color &c) {
+            *it++ = c.blue;
+            *it++ = c.green;
+            *it++ = c.red;
+        }
+    );
+    output.write(row_data.data(), row_data.size());
+}
 } // namespace
 
 BMP::BMP(size_t width, size_t height)
     : width_{width}
-    , height_{height}
-    , pixels_(width_*height_, Palette::Color{0, 0, 0}) {
+    , height_{height} {
+    trace::Span span("bmp.create");
+
+    pixels_.assign(width_*height_, Palette::Color{0, 0, 0});
 }
 
 void
@@ -57,6 +137,8 @@ BMP::drawSurface(
     size_t x, size_t y,
     const Surface &surface,
     const Palette &palette) {
+    trace::Span span("bmp.draw");
+
     const auto w = std::min(surface.getWidth(), width_ - x);
     const auto h = std::min(surface.getHeight(), height_ - y);
     for (auto sx = 0; sx < w; ++sx) {
@@ -67,64 +149,109 @@ BMP::drawSurface(
 }
 
 void
-BMP::store(const std::filesystem::path &filepath) const {
-    std::fstream output(filepath, std::ofstream::binary|std::ofstream::out);
-
-    // Bitmap file header
-    output.write("BM", 2);                // BMP signature
+BMP::drawSurface(
+    size_t x, size_t y,
+    const Image &image,
+    const Palette &palette) {
+    trace::Span span("bmp.draw");
 
-    const auto header_file_size_offset = output.tellp();
-    io::writeInteger<4>(output, 0u);       // file size
+    if (x >= width_ || y >= height_) {
+        return;
+    }
 
-    io::writeInteger<4>(output, 0u);      // reserved 1, reserved 2
+    const auto &remap_table = image.getRemapTableData();
+    const auto remap = [&](std::uint8_t c) -> std::uint8_t {
+        return c < remap_table.size() ? std::uint8_t(remap_table[c]) : c;
+    };
 
-    const auto header_pixels_offset = output.tellp();
-    io::writeInteger<4>(output, 0u);      // offset to pixels array
+    if (image.isTrimmed()) {
+        fillRect(x, y, image.getWidth(), image.getHeight(), palette.at(remap(0)));
+    }
 
-    // Bitmap information
-    io::writeInteger<4>(output, 40u);     // size of the info header (=40)
-    io::writeInteger<4>(output, width_);  // width
-    io::writeInteger<4>(output, height_); // height
-    io::writeInteger<2>(output, 1u);      // count of color plan (=1)
-    io::writeInteger<2>(output, 24u);     // number of bits per pixel (=24)
-    io::writeInteger<4>(output, 0u);      // compression method (=0)
-    io::writeInteger<4>(output, 0u);      // image size
-    io::writeInteger<4>(output, 300_ppi); // horizontal resolution of the image
-    io::writeInteger<4>(output, 300_ppi); // vertical resolution of the image
-    io::writeInteger<4>(output, 0u);      // number of colors in the palette
-    io::writeInteger<4>(output, 0u);      // number of important colors used
+    const auto left = x + image.getLeft();
+    const auto top = y + image.getTop();
+    if (left >= width_ || top >= height_) {
+        return;
+    }
 
-    // write pixels array offset
-    {
-        const auto pixels_array_offset = std::streamoff(output.tellp());
-        io::OPosOffsetGuard _(output);
-        io::writeInteger<4>(output.seekp(header_pixels_offset), pixels_array_offset);
+    const auto &kernels = simd::getKernels();
+    const auto colors = make_color_table(palette, remap);
+    const auto data = reinterpret_cast<const std::uint8_t *>(image.getData().data());
+    const auto w = std::min(image.getDataWidth(), width_ - left);
+    const auto h = std::min(image.getDataHeight(), height_ - top);
+    for (auto sy = 0u; sy < h; ++sy) {
+        const auto row = data + sy*image.getDataWidth();
+        const auto out = pixels_.data() + (top + sy)*width_ + left;
+        kernels.expandPalette(row, w, colors.data(), reinterpret_cast<std::uint8_t *>(out));
     }
+}
 
-    // write pixels
-    const auto row_size = static_cast<unsigned int>(std::ceilf(3.*width_/4.)*4);
+void
+BMP::drawSprite(
+    std::ptrdiff_t x, std::ptrdiff_t y,
+    const Sprite &sprite,
+    const Palette &palette) {
+    trace::Span span("bmp.draw");
+
+    const auto &remap_table = sprite.getRemapTable();
+    const auto remap = [&](std::uint8_t c) -> std::uint8_t {
+        return c < remap_table.size() ? std::uint8_t(remap_table[c]) : c;
+    };
+
+    const auto &kernels = simd::getKernels();
+    const auto colors = make_color_table(palette, remap);
+    sprite.forEachSpan(x, y, width_, height_, [&](size_t x, size_t y, const std::uint8_t *pixels, size_t count) {
+        const auto out = pixels_.data() + y*width_ + x;
+        kernels.expandPalette(pixels, count, colors.data(), reinterpret_cast<std::uint8_t *>(out));
+    });
+}
+
+size_t
+BMP::getFileSize() const {
+    return bmp_file_size(width_, height_);
+}
+
+void
+BMP::store(std::ostream &output) const {
+    trace::Span span("bmp.write");
+
+    write_bmp_header(output, width_, height_);
+
+    // write pixels, rows are stored bottom-up
+    std::vector<char> row_data(bmp_row_size(width_), 0);
     for (auto row = height_; row > 0; --row) {
-        // Write row pixels
-        std::copy_n(
-            pixels_.begin() + (row - 1)*width_,
-            width_,
-            std::ostream_iterator<Palette::Color>(output)
-        );
-        // Write row padding
-        std::fill_n(
-            std::ostream_iterator<char>(output),
-            row_size - 3*width_,
-            0
-        );
+        write_bmp_row(output, pixels_.data() + (row - 1)*width_, width_, row_data);
     }
+}
 
-    // write file size in bitmap file header
-    {
-        const auto file_size = std::streamoff(output.tellp());
-        io::OPosOffsetGuard _(output);
-        io::writeInteger<4>(output.seekp(header_file_size_offset), file_size);
+void
+BMP::store(const std::filesystem::path &filepath) const {
+    std::ofstream output(filepath, std::ofstream::binary);
+    store(output);
+}
+
+BMPBandWriter::BMPBandWriter(std::ostream &output, size_t width, size_t height)
+    : output_{output}
+    , width_{width}
+    , height_{height}
+    , rowData_(bmp_row_size(width), 0) {
+    if (height > size_t(std::numeric_limits<std::int32_t>::max())) {
+        throw std::length_error("bitmap too large");
     }
+    write_bmp_header(output_, width_, -static_cast<std::int32_t>(height_));
+}
+
+void
+BMPBandWriter::write(const Palette::Color *pixels, size_t row_count) {
+    trace::Span span("bmp.write");
 
+    if (rowCount_ + row_count > height_) {
+        throw std::out_of_range("too many rows");
+    }
+    for (auto row = 0u; row < row_count; ++row) {
+        write_bmp_row(output_, pixels + row*width_, width_, rowData_);
+    }
+    rowCount_ += row_count;
 }
 
 } // namespace nr::dune2
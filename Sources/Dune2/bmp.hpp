@@ -1,10 +1,14 @@
 #pragma once
 
+#include <Dune2/image.hpp>
 #include <Dune2/palette.hpp>
+#include <Dune2/sprite.hpp>
 #include <Dune2/surface.hpp>
 
 #include <filesystem>
+#include <cstddef>
 #include <cstdint>
+#include <ostream>
 #include <vector>
 
 namespace nr::dune2 {
@@ -22,7 +26,43 @@ public:
     void fillRect(size_t x, size_t y, size_t w, size_t h, const Palette::Color &);
     void drawSurface(size_t x, size_t y, const Surface &, const Palette &);
 
+    /// ### method `nr::dune2::BMP.drawSurface`
+    /// Draw an image at its full size. Only the data box of a trimmed image
+    /// is read, the pixels around it get the color `0` after remapping.
+    /// #### Parameters
+    /// - `size_t x` - the column of the image left side
+    /// - `size_t y` - the row of the image top side
+    /// - `const Image &image` - the image
+    /// - `const Palette &palette` - the palette
+    void drawSurface(size_t x, size_t y, const Image &, const Palette &);
+
+    /// ### method `nr::dune2::BMP.drawSprite`
+    /// Draw the opaque pixels of a sprite. The sprite can be partially or
+    /// completely outside of the bitmap, it is clipped.
+    /// #### Parameters
+    /// - `std::ptrdiff_t x` - the column of the sprite left side
+    /// - `std::ptrdiff_t y` - the row of the sprite top side
+    /// - `const Sprite &sprite` - the sprite
+    /// - `const Palette &palette` - the palette
+    void drawSprite(std::ptrdiff_t x, std::ptrdiff_t y, const Sprite &, const Palette &);
+
 public:
+    /// ### method `nr::dune2::BMP.getFileSize`
+    /// #### Return
+    /// `size_t` - the number of bytes written by `store`.
+    size_t getFileSize() const;
+
+    /// ### method `nr::dune2::BMP.store`
+    /// Write the bitmap on the given output stream. The output stream does
+    /// not need to be seekable.
+    /// #### Parameters
+    /// - `std::ostream &output` - an output stream
+    void store(std::ostream &) const;
+
+    /// ### method `nr::dune2::BMP.store`
+    /// Write the bitmap to the given file.
+    /// #### Parameters
+    /// - `const std::filesystem::path &filepath` - a path to a `*.bmp` file
     void store(const std::filesystem::path &) const;
 
 private:
@@ -31,4 +71,39 @@ private:
     std::vector<Palette::Color> pixels_;
 };
 
+/// ### class `nr::dune2::BMPBandWriter`
+/// Write a top-down bitmap band by band so that the whole image never needs
+/// to be held in memory.
+class BMPBandWriter {
+public:
+    /// ### constructor `nr::dune2::BMPBandWriter`
+    /// Write the bitmap header on the given output stream.
+    /// #### Parameters
+    /// - `std::ostream &output` - an output stream
+    /// - `size_t width` - the bitmap width
+    /// - `size_t height` - the bitmap height
+    BMPBandWriter(std::ostream &, size_t width, size_t height);
+
+public:
+    /// ### method `nr::dune2::BMPBandWriter.write`
+    /// Append rows to the bitmap.
+    /// #### Parameters
+    /// - `const Palette::Color *pixels` - _width*row_count_ pixels
+    /// - `size_t row_count` - the number of rows
+    void write(const Palette::Color *, size_t row_count);
+
+    /// ### method `nr::dune2::BMPBandWriter.getRowCount`
+    /// #### Return
+    /// `size_t` - the number of rows written so far.
+    size_t getRowCount() const
+    { return rowCount_; }
+
+private:
+    std::ostream &output_;
+    size_t width_;
+    size_t height_;
+    size_t rowCount_{0};
+    std::vector<char> rowData_;
+};
+
 } // namespace nr::dune2
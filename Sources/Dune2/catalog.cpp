@@ -0,0 +1,640 @@
+#include "catalog.hpp"
+#include "animation.hpp"
+#include "icon_set.hpp"
+#include "image.hpp"
+#include "image_set.hpp"
+#include "io.hpp"
+#include "pak.hpp"
+#include "palette.hpp"
+#include "sound.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DUNE2_CATALOG_MMAP
+#endif
+
+namespace fs = std::filesystem;
+
+namespace nr::dune2 {
+
+namespace {
+// Catalog file layout, integers are little endian.
+//
+// header (64 bytes)
+//   0  char[8] magic
+//   8  u32     version
+//   12 u32     archive count
+//   16 u32     entry count
+//   20 u32     slot count, a power of 2
+//   24 u32     root path offset in the string table
+//   28 u32     root path size
+//   32 u64     archive table offset
+//   40 u64     entry table offset
+//   48 u64     slot table offset
+//   56 u64     string table offset
+//
+// archive (32 bytes)
+//   0  u32     path offset in the string table
+//   4  u32     path size
+//   8  u32     first entry index
+//   12 u32     entry count
+//   16 i64     modification time in nanoseconds
+//   24 u64     file size
+//
+// entry (40 bytes)
+//   0  u32     archive index
+//   4  u32     name offset in the string table
+//   8  u32     offset in the archive
+//   12 u32     size
+//   16 u32     frame count
+//   20 u16     width
+//   22 u16     height
+//   24 u16     name size
+//   26 u8      format
+//   27 u8[5]   reserved
+//   32 u64     content hash
+//
+// slot (4 bytes)
+//   0  u32     entry index + 1, 0 for an empty slot
+//
+// Slots are an open addressing hash table of the upper case entry names.
+constexpr char Magic[8] = {'D', 'U', 'N', 'E', '2', 'C', 'A', 'T'};
+constexpr std::uint32_t Version = 1;
+
+constexpr std::size_t HeaderSize = 64;
+constexpr std::size_t ArchiveSize = 32;
+constexpr std::size_t EntrySize = 40;
+constexpr std::size_t SlotSize = 4;
+
+template <typename T>
+T
+get(const char *data, std::size_t pos) {
+    std::uint64_t value = 0;
+    for (auto i = 0u; i < sizeof(T); ++i) {
+        value |= std::uint64_t(std::uint8_t(data[pos + i])) << (8*i);
+    }
+    return static_cast<T>(value);
+}
+
+template <typename T>
+void
+put(std::string &data, std::size_t pos, T value) {
+    for (auto i = 0u; i < sizeof(T); ++i) {
+        data[pos + i] = char((std::uint64_t(value) >> (8*i)) & 0xff);
+    }
+}
+
+std::uint64_t
+fnv1a(std::string_view data, bool upper_case = false) {
+    auto hash = std::uint64_t{14695981039346656037ull};
+    for (auto c: data) {
+        hash ^= upper_case ? std::toupper(std::uint8_t(c)) : std::uint8_t(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool
+iequal(std::string_view a, std::string_view b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](auto a, auto b) {
+        return std::toupper(std::uint8_t(a)) == std::toupper(std::uint8_t(b));
+    });
+}
+
+bool
+has_extension(std::string_view name, std::string_view extension) {
+    return name.size() >= extension.size()
+        && iequal(name.substr(name.size() - extension.size()), extension);
+}
+
+std::int64_t
+get_mtime(const fs::path &filepath) {
+    using namespace std::chrono;
+    const auto mtime = fs::last_write_time(filepath).time_since_epoch();
+    return duration_cast<nanoseconds>(mtime).count();
+}
+
+struct ScannedEntry {
+    std::string name;
+    std::size_t offset{0};
+    std::size_t size{0};
+    Catalog::Format format{Catalog::Format::Unknown};
+    std::size_t width{0};
+    std::size_t height{0};
+    std::size_t frameCount{0};
+    std::uint64_t hash{0};
+};
+
+struct ScannedArchive {
+    std::string path;
+    std::int64_t mtime{0};
+    std::uint64_t size{0};
+    std::vector<ScannedEntry> entries;
+};
+
+// Detect the format of an entry from its name and fill its properties by
+// decoding it.
+void
+probe_entry(ScannedEntry &entry, std::string_view data) {
+    using Format = Catalog::Format;
+
+    const auto probe_images = [&](const ImageSet &images) {
+        entry.frameCount = images.getImageCount();
+        for (auto i = 0u; i < images.getImageCount(); ++i) {
+            const auto &image = images.getImage(i);
+            entry.width = std::max(entry.width, image.getWidth());
+            entry.height = std::max(entry.height, image.getHeight());
+        }
+    };
+
+    io::IMemoryStream input(data);
+    input.exceptions(std::ios::failbit);
+
+    try {
+        if (has_extension(entry.name, ".PAL")) {
+            if (data.size() != 768) {
+                return;
+            }
+            Palette palette;
+            palette.loadFromPAL(input);
+            entry.frameCount = palette.size();
+            entry.format = Format::PAL;
+        } else if (has_extension(entry.name, ".CPS")) {
+            Image image;
+            image.loadFromCPS(input);
+            entry.width = image.getWidth();
+            entry.height = image.getHeight();
+            entry.frameCount = 1;
+            entry.format = Format::CPS;
+        } else if (has_extension(entry.name, ".SHP")) {
+            ImageSet images;
+            images.loadFromSHP(input);
+            probe_images(images);
+            entry.format = Format::SHP;
+        } else if (has_extension(entry.name, ".ICN")) {
+            ImageSet images;
+            images.loadFromICN(input);
+            probe_images(images);
+            entry.format = Format::ICN;
+        } else if (has_extension(entry.name, ".MAP")) {
+            IconSet icons;
+            icons.loadFromMAP(input);
+            entry.frameCount = icons.getIconCount();
+            entry.format = Format::MAP;
+        } else if (has_extension(entry.name, ".WSA")) {
+            Animation animation;
+            animation.loadFromWSA(input);
+            entry.width = animation.getWidth();
+            entry.height = animation.getHeight();
+            entry.frameCount = animation.getFrameCount();
+            entry.format = Format::WSA;
+        } else if (has_extension(entry.name, ".VOC")) {
+            Sound sound;
+            sound.loadFromVOC(input);
+            entry.frameCount = sound.getSamples().size();
+            entry.format = Format::VOC;
+        }
+    } catch (const std::exception &) {
+        entry.format = Format::Unknown;
+        entry.width = entry.height = entry.frameCount = 0;
+    }
+}
+
+ScannedArchive
+scan_archive(const fs::path &root, const fs::path &relative_path) {
+    trace::Span span("catalog.scan");
+
+    const auto filepath = root/relative_path;
+
+    ScannedArchive archive;
+    archive.path = relative_path.generic_string();
+    archive.mtime = get_mtime(filepath);
+    archive.size = fs::file_size(filepath);
+
+    std::ifstream input(filepath, std::ios::binary);
+    const auto data = io::readAll(input);
+
+    PAK pak;
+    try {
+        io::IMemoryStream pak_input(data);
+        pak.load(pak_input, filepath);
+    } catch (const std::exception &) {
+        // Not a PAK file after all, keep it without entries so that it is
+        // not read again until it changes.
+        return archive;
+    }
+
+    for (const auto &pak_entry: pak) {
+        if (pak_entry.offset > data.size() || pak_entry.size > data.size() - pak_entry.offset) {
+            archive.entries.clear();
+            break;
+        }
+        const auto content = std::string_view(data).substr(pak_entry.offset, pak_entry.size);
+
+        auto &entry = archive.entries.emplace_back();
+        entry.name = pak_entry.name;
+        entry.offset = pak_entry.offset;
+        entry.size = pak_entry.size;
+        entry.hash = fnv1a(content);
+        probe_entry(entry, content);
+    }
+    return archive;
+}
+
+// List the `.pak` files of a directory tree, relative to its root and sorted.
+std::vector<fs::path>
+list_archives(const fs::path &root) {
+    std::vector<fs::path> archives;
+    for (const auto &item: fs::recursive_directory_iterator(root)) {
+        if (item.is_regular_file() && has_extension(item.path().filename().string(), ".PAK")) {
+            archives.push_back(item.path().lexically_relative(root));
+        }
+    }
+    std::sort(archives.begin(), archives.end());
+    return archives;
+}
+
+std::string
+build_catalog(const std::string &root, const std::vector<ScannedArchive> &archives) {
+    std::size_t entry_count = 0;
+    for (const auto &archive: archives) {
+        entry_count += archive.entries.size();
+    }
+
+    std::size_t slot_count = 1;
+    while (slot_count < 2*entry_count) {
+        slot_count *= 2;
+    }
+
+    const auto archives_offset = HeaderSize;
+    const auto entries_offset = archives_offset + archives.size()*ArchiveSize;
+    const auto slots_offset = entries_offset + entry_count*EntrySize;
+    const auto strings_offset = slots_offset + slot_count*SlotSize;
+
+    std::string data(strings_offset, '\0');
+    std::string strings;
+
+    const auto add_string = [&](std::string_view str) {
+        const auto offset = strings.size();
+        strings.append(str);
+        return std::uint32_t(offset);
+    };
+
+    std::memcpy(data.data(), Magic, sizeof(Magic));
+    put<std::uint32_t>(data, 8, Version);
+    put<std::uint32_t>(data, 12, archives.size());
+    put<std::uint32_t>(data, 16, entry_count);
+    put<std::uint32_t>(data, 20, slot_count);
+    put<std::uint32_t>(data, 24, add_string(root));
+    put<std::uint32_t>(data, 28, root.size());
+    put<std::uint64_t>(data, 32, archives_offset);
+    put<std::uint64_t>(data, 40, entries_offset);
+    put<std::uint64_t>(data, 48, slots_offset);
+    put<std::uint64_t>(data, 56, strings_offset);
+
+    std::size_t entry_index = 0;
+    for (auto archive_index = 0u; archive_index < archives.size(); ++archive_index) {
+        const auto &archive = archives[archive_index];
+        const auto pos = archives_offset + archive_index*ArchiveSize;
+
+        put<std::uint32_t>(data, pos, add_string(archive.path));
+        put<std::uint32_t>(data, pos + 4, archive.path.size());
+        put<std::uint32_t>(data, pos + 8, entry_index);
+        put<std::uint32_t>(data, pos + 12, archive.entries.size());
+        put<std::int64_t>(data, pos + 16, archive.mtime);
+        put<std::uint64_t>(data, pos + 24, archive.size);
+
+        for (const auto &entry: archive.entries) {
+            const auto pos = entries_offset + entry_index*EntrySize;
+
+            put<std::uint32_t>(data, pos, archive_index);
+            put<std::uint32_t>(data, pos + 4, add_string(entry.name));
+            put<std::uint32_t>(data, pos + 8, entry.offset);
+            put<std::uint32_t>(data, pos + 12, entry.size);
+            put<std::uint32_t>(data, pos + 16, entry.frameCount);
+            put<std::uint16_t>(data, pos + 20, std::min<std::size_t>(entry.width, 0xffff));
+            put<std::uint16_t>(data, pos + 22, std::min<std::size_t>(entry.height, 0xffff));
+            put<std::uint16_t>(data, pos + 24, entry.name.size());
+            put<std::uint8_t>(data, pos + 26, static_cast<std::uint8_t>(entry.format));
+            put<std::uint64_t>(data, pos + 32, entry.hash);
+
+            // Keep the first entry of a given name.
+            auto slot = fnv1a(entry.name, true) & (slot_count - 1);
+            for (;; slot = (slot + 1) & (slot_count - 1)) {
+                const auto slot_pos = slots_offset + slot*SlotSize;
+                const auto value = get<std::uint32_t>(data.data(), slot_pos);
+                if (value == 0) {
+                    put<std::uint32_t>(data, slot_pos, entry_index + 1);
+                    break;
+                }
+                const auto other_pos = entries_offset + (value - 1)*EntrySize;
+                const auto other_name = std::string_view(
+                    strings.data() + get<std::uint32_t>(data.data(), other_pos + 4),
+                    get<std::uint16_t>(data.data(), other_pos + 24)
+                );
+                if (iequal(other_name, entry.name)) {
+                    break;
+                }
+            }
+            ++entry_index;
+        }
+    }
+
+    return data + strings;
+}
+
+std::shared_ptr<const char>
+make_data(std::string data) {
+    auto buffer = std::make_shared<std::string>(std::move(data));
+    return std::shared_ptr<const char>(buffer, buffer->data());
+}
+
+// Check that a buffer holds a catalog and that its tables are in bounds.
+void
+check_catalog(const char *data, std::size_t size) {
+    const auto check = [](bool condition) {
+        if (!condition) {
+            throw std::invalid_argument("corrupted file");
+        }
+    };
+
+    check(size >= HeaderSize);
+    check(std::memcmp(data, Magic, sizeof(Magic)) == 0);
+    check(get<std::uint32_t>(data, 8) == Version);
+
+    const auto archive_count = get<std::uint32_t>(data, 12);
+    const auto entry_count = get<std::uint32_t>(data, 16);
+    const auto slot_count = get<std::uint32_t>(data, 20);
+    const auto archives_offset = get<std::uint64_t>(data, 32);
+    const auto entries_offset = get<std::uint64_t>(data, 40);
+    const auto slots_offset = get<std::uint64_t>(data, 48);
+    const auto strings_offset = get<std::uint64_t>(data, 56);
+
+    check(slot_count > entry_count && (slot_count & (slot_count - 1)) == 0);
+    check(archives_offset + std::uint64_t(archive_count)*ArchiveSize <= entries_offset);
+    check(entries_offset + std::uint64_t(entry_count)*EntrySize <= slots_offset);
+    check(slots_offset + std::uint64_t(slot_count)*SlotSize <= strings_offset);
+    check(strings_offset <= size);
+
+    const auto strings_size = size - strings_offset;
+    const auto check_string = [&](std::uint64_t offset, std::uint64_t count) {
+        check(offset <= strings_size && count <= strings_size - offset);
+    };
+
+    check_string(get<std::uint32_t>(data, 24), get<std::uint32_t>(data, 28));
+    for (auto i = 0u; i < archive_count; ++i) {
+        const auto pos = archives_offset + i*ArchiveSize;
+        check_string(get<std::uint32_t>(data, pos), get<std::uint32_t>(data, pos + 4));
+        check(
+            std::uint64_t(get<std::uint32_t>(data, pos + 8)) + get<std::uint32_t>(data, pos + 12)
+                <= entry_count
+        );
+    }
+    for (auto i = 0u; i < entry_count; ++i) {
+        const auto pos = entries_offset + i*EntrySize;
+        check(get<std::uint32_t>(data, pos) < archive_count);
+        check_string(get<std::uint32_t>(data, pos + 4), get<std::uint16_t>(data, pos + 24));
+        check(get<std::uint8_t>(data, pos + 26) <= std::uint8_t(Catalog::Format::VOC));
+    }
+    // Lookups stop on an empty slot.
+    auto empty_slot_count = 0u;
+    for (auto i = 0u; i < slot_count; ++i) {
+        const auto value = get<std::uint32_t>(data, slots_offset + i*SlotSize);
+        check(value <= entry_count);
+        empty_slot_count += value == 0;
+    }
+    check(empty_slot_count > 0);
+}
+} // namespace
+
+Catalog::Catalog() {
+    auto data = build_catalog({}, {});
+    size_ = data.size();
+    data_ = make_data(std::move(data));
+}
+
+void
+Catalog::load(const fs::path &filepath) {
+#if defined(DUNE2_CATALOG_MMAP)
+    const auto fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::invalid_argument("cannot open file");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::invalid_argument("corrupted file");
+    }
+
+    const auto size = static_cast<std::size_t>(st.st_size);
+    const auto addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::invalid_argument("cannot map file");
+    }
+
+    std::shared_ptr<const char> data(
+        static_cast<const char *>(addr),
+        [size](const char *addr) { ::munmap(const_cast<char *>(addr), size); }
+    );
+#else
+    std::ifstream input(filepath, std::ios::binary);
+    if (!input) {
+        throw std::invalid_argument("cannot open file");
+    }
+    auto buffer = io::readAll(input);
+    const auto size = buffer.size();
+    auto data = make_data(std::move(buffer));
+#endif
+
+    check_catalog(data.get(), size);
+
+    data_ = std::move(data);
+    size_ = size;
+}
+
+void
+Catalog::store(const fs::path &filepath) const {
+    auto tmp_filepath = filepath;
+    tmp_filepath += ".tmp";
+    {
+        std::ofstream output;
+        output.exceptions(std::ios::failbit | std::ios::badbit);
+        output.open(tmp_filepath, std::ios::binary | std::ios::trunc);
+        output.write(data_.get(), size_);
+    }
+    fs::rename(tmp_filepath, filepath);
+}
+
+std::size_t
+Catalog::update(const fs::path &root, Executor &executor) {
+    const auto root_path = fs::absolute(root).lexically_normal();
+    const auto relative_paths = list_archives(root_path);
+
+    // Archives of the previous scan which can be kept as is.
+    std::unordered_map<std::string, std::size_t> previous;
+    if (getRoot() == root_path) {
+        for (auto i = 0u; i < getArchiveCount(); ++i) {
+            previous.emplace(std::string(getArchive(i).path), i);
+        }
+    }
+
+    std::vector<ScannedArchive> archives(relative_paths.size());
+    std::vector<std::size_t> changed;
+
+    for (auto i = 0u; i < relative_paths.size(); ++i) {
+        const auto filepath = root_path/relative_paths[i];
+        const auto it = previous.find(relative_paths[i].generic_string());
+
+        if (it != previous.end()) {
+            const auto archive = getArchive(it->second);
+            if (archive.mtime == get_mtime(filepath) && archive.size == fs::file_size(filepath)) {
+                archives[i].path = archive.path;
+                archives[i].mtime = archive.mtime;
+                archives[i].size = archive.size;
+                for (auto j = 0u; j < archive.entryCount; ++j) {
+                    const auto entry = getEntry(archive.firstEntry + j);
+                    archives[i].entries.push_back(ScannedEntry{
+                        std::string(entry.name),
+                        entry.offset,
+                        entry.size,
+                        entry.format,
+                        entry.width,
+                        entry.height,
+                        entry.frameCount,
+                        entry.hash
+                    });
+                }
+                continue;
+            }
+        }
+        changed.push_back(i);
+    }
+
+    executor.parallelFor(changed.size(), [&](std::size_t i) {
+        archives[changed[i]] = scan_archive(root_path, relative_paths[changed[i]]);
+    });
+
+    auto data = build_catalog(root_path.string(), archives);
+    size_ = data.size();
+    data_ = make_data(std::move(data));
+
+    return changed.size();
+}
+
+fs::path
+Catalog::getRoot() const {
+    const auto data = data_.get();
+    const auto strings = data + get<std::uint64_t>(data, 56);
+    return std::string(strings + get<std::uint32_t>(data, 24), get<std::uint32_t>(data, 28));
+}
+
+std::size_t
+Catalog::getArchiveCount() const {
+    return get<std::uint32_t>(data_.get(), 12);
+}
+
+Catalog::Archive
+Catalog::getArchive(std::size_t archive_index) const {
+    const auto data = data_.get();
+    const auto strings = data + get<std::uint64_t>(data, 56);
+    const auto pos = get<std::uint64_t>(data, 32) + archive_index*ArchiveSize;
+
+    return Archive{
+        std::string_view(strings + get<std::uint32_t>(data, pos), get<std::uint32_t>(data, pos + 4)),
+        get<std::int64_t>(data, pos + 16),
+        get<std::uint64_t>(data, pos + 24),
+        get<std::uint32_t>(data, pos + 8),
+        get<std::uint32_t>(data, pos + 12),
+    };
+}
+
+std::size_t
+Catalog::getEntryCount() const {
+    return get<std::uint32_t>(data_.get(), 16);
+}
+
+Catalog::Entry
+Catalog::getEntry(std::size_t entry_index) const {
+    const auto data = data_.get();
+    const auto strings = data + get<std::uint64_t>(data, 56);
+    const auto pos = get<std::uint64_t>(data, 40) + entry_index*EntrySize;
+
+    return Entry{
+        std::string_view(strings + get<std::uint32_t>(data, pos + 4), get<std::uint16_t>(data, pos + 24)),
+        get<std::uint32_t>(data, pos),
+        get<std::uint32_t>(data, pos + 8),
+        get<std::uint32_t>(data, pos + 12),
+        static_cast<Format>(get<std::uint8_t>(data, pos + 26)),
+        get<std::uint16_t>(data, pos + 20),
+        get<std::uint16_t>(data, pos + 22),
+        get<std::uint32_t>(data, pos + 16),
+        get<std::uint64_t>(data, pos + 32),
+    };
+}
+
+std::optional<Catalog::Entry>
+Catalog::find(std::string_view name) const {
+    const auto data = data_.get();
+    const auto slot_count = get<std::uint32_t>(data, 20);
+    const auto slots_offset = get<std::uint64_t>(data, 48);
+
+    // A valid catalog always has an empty slot, the probe is bounded anyway
+    // so that a corrupted one can not loop forever.
+    auto slot = fnv1a(name, true) & (slot_count - 1);
+    for (auto probe = 0u; probe < slot_count; ++probe, slot = (slot + 1) & (slot_count - 1)) {
+        const auto value = get<std::uint32_t>(data, slots_offset + slot*SlotSize);
+        if (value == 0) {
+            return std::nullopt;
+        }
+        const auto entry = getEntry(value - 1);
+        if (iequal(entry.name, name)) {
+            return entry;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string
+Catalog::read(const Entry &entry) const {
+    const auto filepath = getRoot()/std::string(getArchive(entry.archive).path);
+
+    std::ifstream input;
+    input.exceptions(std::ios::failbit);
+    input.open(filepath, std::ios::binary);
+    input.seekg(entry.offset);
+
+    std::string data(entry.size, '\0');
+    input.read(data.data(), data.size());
+    return data;
+}
+
+const char *
+Catalog::getFormatName(Format format) {
+    switch (format) {
+    case Format::PAL: return "pal";
+    case Format::CPS: return "cps";
+    case Format::SHP: return "shp";
+    case Format::ICN: return "icn";
+    case Format::MAP: return "map";
+    case Format::WSA: return "wsa";
+    case Format::VOC: return "voc";
+    default: return "?";
+    }
+}
+
+} // namespace nr::dune2
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <Dune2/executor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::Catalog`
+/// An index of the entries of the `.pak` files found in a directory tree.
+///
+/// For each entry the catalog records its archive, offset and size, its
+/// detected format, its dimensions and frame count and a hash of its content.
+/// The catalog is stored in a compact binary file which is memory mapped
+/// when loaded, entries are then found by name in constant time without
+/// reading any `.pak` file.
+///
+/// All the data of a catalog live in a single read-only buffer, copying a
+/// catalog is cheap.
+class Catalog {
+public:
+    /// ### enum `nr::dune2::Catalog::Format`
+    /// The format of an entry, detected from its extension and validated by
+    /// decoding its content. A corrupted entry is `Unknown`.
+    enum class Format : std::uint8_t {
+        Unknown,
+        PAL,
+        CPS,
+        SHP,
+        ICN,
+        MAP,
+        WSA,
+        VOC,
+    };
+
+    struct Archive {
+        std::string_view path;
+        std::int64_t mtime{0};
+        std::uint64_t size{0};
+        std::size_t firstEntry{0};
+        std::size_t entryCount{0};
+    };
+
+    /// ### struct `nr::dune2::Catalog::Entry`
+    /// - `width`, `height` - the image or animation size, the largest frame
+    ///   size for `.shp` files,
+    /// - `frameCount` - the number of images, icons, frames or samples,
+    /// - `hash` - the 64 bits FNV-1a hash of the entry content.
+    struct Entry {
+        std::string_view name;
+        std::size_t archive{0};
+        std::size_t offset{0};
+        std::size_t size{0};
+        Format format{Format::Unknown};
+        std::size_t width{0};
+        std::size_t height{0};
+        std::size_t frameCount{0};
+        std::uint64_t hash{0};
+    };
+
+public:
+    Catalog();
+
+public:
+    /// ### method `nr::dune2::Catalog.load`
+    /// Map the given catalog file in memory. Throw `std::invalid_argument`
+    /// if the file is not a valid catalog.
+    /// #### Parameters
+    /// - `const std::filesystem::path &filepath` - a path to a catalog file
+    void load(const std::filesystem::path &);
+
+    /// ### method `nr::dune2::Catalog.store`
+    /// Write the catalog to the given file. The file is replaced atomically.
+    /// #### Parameters
+    /// - `const std::filesystem::path &filepath` - a path to a catalog file
+    void store(const std::filesystem::path &) const;
+
+    /// ### method `nr::dune2::Catalog.update`
+    /// Scan the `.pak` files of the given directory tree. Archives whose
+    /// size and modification time did not change since the last scan of the
+    /// same directory are not read again.
+    /// #### Parameters
+    /// - `const std::filesystem::path &root` - the directory to scan
+    /// - `Executor &executor` - the executor reading the archives
+    /// #### Return
+    /// `std::size_t` - the number of archives read.
+    std::size_t update(const std::filesystem::path &root, Executor &);
+
+public:
+    /// ### method `nr::dune2::Catalog.getRoot`
+    /// #### Return
+    /// `std::filesystem::path` - the scanned directory, archive paths are
+    /// relative to it.
+    std::filesystem::path getRoot() const;
+
+    std::size_t getArchiveCount() const;
+    Archive getArchive(std::size_t archive_index) const;
+
+    std::size_t getEntryCount() const;
+    Entry getEntry(std::size_t entry_index) const;
+
+    /// ### method `nr::dune2::Catalog.find`
+    /// Find an entry by name. Names are compared case insensitively. When
+    /// several archives hold the same name, the first archive in path order
+    /// wins.
+    /// #### Parameters
+    /// - `std::string_view name` - the entry name
+    /// #### Return
+    /// `std::optional<Entry>` - the entry if found.
+    std::optional<Entry> find(std::string_view name) const;
+
+    /// ### method `nr::dune2::Catalog.read`
+    /// Read the content of an entry from its archive.
+    /// #### Parameters
+    /// - `const Entry &entry` - an entry of this catalog
+    /// #### Return
+    /// `std::string` - the entry content.
+    std::string read(const Entry &) const;
+
+public:
+    /// ### static method `nr::dune2::Catalog::getFormatName`
+    /// #### Return
+    /// `const char *` - the usual file extension of the format, `"?"` for
+    /// unknown formats.
+    static const char *getFormatName(Format);
+
+private:
+    std::shared_ptr<const char> data_;
+    std::size_t size_;
+};
+} // namespace nr::dune2
@@ -0,0 +1,135 @@
+#include "color_stats.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+ColorStats::ColorStats()
+    : histogram_{} {
+}
+
+ColorStats::ColorStats(const Image &image)
+    : histogram_{} {
+    trace::Span span("stats.count");
+
+    const auto &data = image.getData();
+    const auto pixels = reinterpret_cast<const std::uint8_t *>(data.data());
+    const auto count = data.size();
+
+    // Consecutive pixels are often of the same color, counting them in four
+    // histograms avoids waiting on the previous increment of the same
+    // counter.
+    std::array<std::array<std::uint32_t, 256>, 4> histograms{};
+    auto i = std::size_t{0};
+    for (; i + 4 <= count; i += 4) {
+        ++histograms[0][pixels[i + 0]];
+        ++histograms[1][pixels[i + 1]];
+        ++histograms[2][pixels[i + 2]];
+        ++histograms[3][pixels[i + 3]];
+    }
+    for (; i < count; ++i) {
+        ++histograms[0][pixels[i]];
+    }
+
+    // Pixels outside of the data box of a trimmed image are 0.
+    histograms[0][0] += image.getWidth()*image.getHeight() - count;
+
+    // Remap colors once per color instead of once per pixel.
+    const auto &remap_table = image.getRemapTableData();
+    for (auto color = 0u; color < 256; ++color) {
+        const auto n = histograms[0][color]
+            + histograms[1][color]
+            + histograms[2][color]
+            + histograms[3][color];
+        const auto remapped = color < remap_table.size()
+            ? std::uint8_t(remap_table[color])
+            : color;
+        histogram_[remapped] += n;
+    }
+}
+
+ColorStats &
+ColorStats::operator+=(const ColorStats &other) {
+    for (auto color = 0u; color < 256; ++color) {
+        histogram_[color] += other.histogram_[color];
+    }
+    return *this;
+}
+
+std::size_t
+ColorStats::getPixelCount() const {
+    return std::accumulate(histogram_.begin(), histogram_.end(), std::size_t{0});
+}
+
+std::uint8_t
+ColorStats::getDominantColor() const {
+    return std::max_element(histogram_.begin(), histogram_.end()) - histogram_.begin();
+}
+
+Palette::Color
+ColorStats::getMeanColor(const Palette &palette) const {
+    const auto count = getPixelCount();
+    if (count == 0) {
+        return Palette::Color{};
+    }
+
+    std::uint64_t red = 0, green = 0, blue = 0;
+    for (auto color = 0u; color < std::min<std::size_t>(256, palette.size()); ++color) {
+        red += std::uint64_t(histogram_[color])*palette[color].red;
+        green += std::uint64_t(histogram_[color])*palette[color].green;
+        blue += std::uint64_t(histogram_[color])*palette[color].blue;
+    }
+    return Palette::Color{
+        Palette::Color::Channel((red + count/2)/count),
+        Palette::Color::Channel((green + count/2)/count),
+        Palette::Color::Channel((blue + count/2)/count),
+    };
+}
+
+std::vector<ColorStats>
+computeTileColorStats(const ImageSet &images, Executor &executor) {
+    return parallelTransform(executor, images.getImageCount(), [&](std::size_t i) {
+        return ColorStats(images.getImage(i));
+    }, 16);
+}
+
+std::vector<ColorStats>
+computeIconColorStats(const IconSet &icons, const std::vector<ColorStats> &tile_stats) {
+    std::vector<ColorStats> icon_stats(icons.getIconCount());
+    for (auto i = 0u; i < icons.getIconCount(); ++i) {
+        for (auto tile: icons.getIcon(i).getTileIndexList()) {
+            icon_stats[i] += tile_stats.at(tile);
+        }
+    }
+    return icon_stats;
+}
+
+std::vector<std::uint8_t>
+createLandscapeLUT(
+    const IconSet &icons,
+    const std::vector<ColorStats> &icon_stats,
+    const Palette &palette,
+    LUTColor color
+) {
+    if (icons.getGroupCount() <= IconSet::LandscapeGroup) {
+        throw std::invalid_argument("icon set has no landscape group");
+    }
+
+    const auto offset = icons.getGroupOffset(IconSet::LandscapeGroup);
+    const auto count = icons.getGroupSize(IconSet::LandscapeGroup);
+
+    std::vector<std::uint8_t> lut;
+    for (auto i = offset; i < offset + count; ++i) {
+        const auto &stats = icon_stats.at(i);
+        lut.push_back(color == LUTColor::Dominant
+            ? stats.getDominantColor()
+            : palette.findNearestColor(stats.getMeanColor(palette))
+        );
+    }
+    return lut;
+}
+
+} // namespace nr::dune2
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Dune2/executor.hpp>
+#include <Dune2/icon_set.hpp>
+#include <Dune2/image.hpp>
+#include <Dune2/image_set.hpp>
+#include <Dune2/palette.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::ColorStats`
+/// The histogram of the color indexes of an image, remap table applied, and
+/// the statistics derived from it. Statistics of several images are merged
+/// by adding their histograms.
+class ColorStats {
+public:
+    using Histogram = std::array<std::uint32_t, 256>;
+
+public:
+    ColorStats();
+
+    /// ### constructor `nr::dune2::ColorStats`
+    /// Count the colors of an image.
+    /// #### Parameters
+    /// - `const Image &image` - an image
+    explicit ColorStats(const Image &);
+
+public:
+    ColorStats &operator+=(const ColorStats &);
+
+public:
+    const Histogram &getHistogram() const
+    { return histogram_; }
+
+    /// ### method `nr::dune2::ColorStats.getPixelCount`
+    /// #### Return
+    /// `std::size_t` - the number of pixels counted.
+    std::size_t getPixelCount() const;
+
+    /// ### method `nr::dune2::ColorStats.getDominantColor`
+    /// #### Return
+    /// `std::uint8_t` - the most frequent color index, the lowest one on
+    /// ties.
+    std::uint8_t getDominantColor() const;
+
+    /// ### method `nr::dune2::ColorStats.getMeanColor`
+    /// #### Parameters
+    /// - `const Palette &palette` - the palette of the counted images
+    /// #### Return
+    /// `Palette::Color` - the mean color, rounded to the nearest.
+    Palette::Color getMeanColor(const Palette &) const;
+
+private:
+    Histogram histogram_;
+};
+
+/// ### function `nr::dune2::computeTileColorStats`
+/// Count the colors of each image of an image set. Images are decoded and
+/// counted on the executor.
+/// #### Parameters
+/// - `const ImageSet &images` - an image set
+/// - `Executor &executor` - the executor
+/// #### Return
+/// `std::vector<ColorStats>` - the statistics of each image.
+std::vector<ColorStats> computeTileColorStats(const ImageSet &, Executor &);
+
+/// ### function `nr::dune2::computeIconColorStats`
+/// Merge the statistics of the tiles of each icon of an icon set.
+/// #### Parameters
+/// - `const IconSet &icons` - an icon set
+/// - `const std::vector<ColorStats> &tile_stats` - the statistics of the
+///   tiles, as returned by `computeTileColorStats`
+/// #### Return
+/// `std::vector<ColorStats>` - the statistics of each icon.
+std::vector<ColorStats> computeIconColorStats(const IconSet &, const std::vector<ColorStats> &);
+
+/// ### enum `nr::dune2::LUTColor`
+/// - `Dominant` - the most frequent color of an icon,
+/// - `Mean` - the palette color nearest to the mean color of an icon.
+enum class LUTColor {
+    Dominant,
+    Mean,
+};
+
+/// ### function `nr::dune2::createLandscapeLUT`
+/// Create the table of the representative color index of each landscape
+/// icon, as expected by `Map::Minimap`. Throw `std::invalid_argument` if
+/// the icon set has no landscape group.
+/// #### Parameters
+/// - `const IconSet &icons` - icons loaded from `ICON.MAP`
+/// - `const std::vector<ColorStats> &icon_stats` - the statistics of the
+///   icons, as returned by `computeIconColorStats`
+/// - `const Palette &palette` - the palette
+/// - `LUTColor color` - how colors are chosen
+/// #### Return
+/// `std::vector<std::uint8_t>` - a color index per landscape icon.
+std::vector<std::uint8_t> createLandscapeLUT(
+    const IconSet &,
+    const std::vector<ColorStats> &,
+    const Palette &,
+    LUTColor = LUTColor::Dominant
+);
+} // namespace nr::dune2
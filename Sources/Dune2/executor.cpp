@@ -0,0 +1,167 @@
+#include "executor.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace nr::dune2 {
+
+namespace {
+// The executor and the queue of the running thread, if it is a worker.
+thread_local const Executor *current_executor{nullptr};
+thread_local size_t current_queue_index{0};
+} // namespace
+
+Executor::Executor(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::generate_n(std::back_inserter(queues_), thread_count, [] {
+        return std::make_unique<Queue>();
+    });
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads_.emplace_back([this, i] { work(i); });
+    }
+}
+
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeUp_.notify_all();
+    std::for_each(threads_.begin(), threads_.end(), [](auto &thread) {
+        thread.join();
+    });
+}
+
+size_t
+Executor::getQueueIndex() const {
+    return current_executor == this ? current_queue_index : 0;
+}
+
+void
+Executor::submit(size_t queue_index, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+    {
+        auto &queue = *queues_[queue_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    wakeUp_.notify_one();
+}
+
+bool
+Executor::runOne(size_t queue_index) {
+    Task task;
+
+    const auto queue_count = queues_.size();
+    for (size_t i = 0; i < queue_count && !task; ++i) {
+        auto &queue = *queues_[(queue_index + i)%queue_count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        // Newest task from our own queue, oldest task from the others.
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    --pending_;
+    task();
+    return true;
+}
+
+void
+Executor::work(size_t queue_index) {
+    current_executor = this;
+    current_queue_index = queue_index;
+
+    while (true) {
+        if (runOne(queue_index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        wakeUp_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if (stop_ && pending_ == 0) {
+            return;
+        }
+    }
+}
+
+void
+Executor::parallelFor(size_t count, const std::function<void(size_t)> &fn, size_t grain_size) {
+    struct Group {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+        std::atomic<bool> cancelled{false};
+        std::exception_ptr error;
+    };
+
+    grain_size = std::max<size_t>(grain_size, 1);
+
+    Group group;
+    group.remaining = (count + grain_size - 1)/grain_size;
+
+    const auto run_chunk = [&](size_t first) {
+        const auto last = std::min(first + grain_size, count);
+        for (auto i = first; i < last && !group.cancelled; ++i) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(group.mutex);
+                if (!group.error) {
+                    group.error = std::current_exception();
+                }
+                group.cancelled = true;
+            }
+        }
+        // The group lives on the stack of the waiting thread, it must not be
+        // touched once the lock is released.
+        std::lock_guard<std::mutex> lock(group.mutex);
+        if (--group.remaining == 0) {
+            group.done.notify_all();
+        }
+    };
+
+    if (threads_.empty() || group.remaining <= 1) {
+        for (size_t first = 0; first < count; first += grain_size) {
+            run_chunk(first);
+        }
+    } else {
+        const auto queue_index = getQueueIndex();
+
+        for (size_t first = 0; first < count; first += grain_size) {
+            submit(queue_index, [&run_chunk, first] { run_chunk(first); });
+        }
+
+        // Help until the queues are drained, then wait for the chunks still
+        // running on other threads.
+        while (runOne(queue_index)) {
+            std::unique_lock<std::mutex> lock(group.mutex);
+            if (group.remaining == 0) {
+                break;
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(group.mutex);
+    group.done.wait(lock, [&] { return group.remaining == 0; });
+
+    if (group.error) {
+        std::rethrow_exception(group.error);
+    }
+}
+
+} // namespace nr::dune2
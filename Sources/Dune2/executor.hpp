@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::Executor`
+/// A pool of threads running tasks with a work-stealing scheduler: each
+/// thread owns a queue, pushes and pops its own tasks at the back, and steals
+/// tasks at the front of the other queues when its queue is empty.
+///
+/// The thread calling `parallelFor` takes part in the work, so an executor
+/// of `n` threads starts `n - 1` workers and an executor of one thread runs
+/// everything on the calling thread. Calls to `parallelFor` can be nested.
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+public:
+    /// ### constructor `nr::dune2::Executor`
+    /// #### Parameters
+    /// - `size_t thread_count` - the number of threads, `0` for one thread
+    ///   per hardware thread
+    explicit Executor(size_t thread_count = 0);
+
+    Executor(const Executor &) = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    ~Executor();
+
+public:
+    /// ### method `nr::dune2::Executor.getThreadCount`
+    /// #### Return
+    /// `size_t` - the number of threads, the calling thread included.
+    size_t getThreadCount() const
+    { return threads_.size() + 1; }
+
+    /// ### method `nr::dune2::Executor.parallelFor`
+    /// Call `fn(i)` for each _i_ in _[0, count)_ and wait for all the calls
+    /// to complete. Indexes are dispatched in chunks of `grain_size`
+    /// consecutive indexes.
+    ///
+    /// When a call throws, the indexes not started yet are cancelled and the
+    /// first exception is rethrown once the running calls complete.
+    /// #### Parameters
+    /// - `size_t count` - the number of indexes
+    /// - `const std::function<void(size_t)> &fn` - the function to call
+    /// - `size_t grain_size` - the number of indexes of a task
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn, size_t grain_size = 1);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    size_t getQueueIndex() const;
+    void submit(size_t queue_index, Task);
+    bool runOne(size_t queue_index);
+    void work(size_t queue_index);
+
+private:
+    // queues_[0] is shared by the threads not belonging to the executor,
+    // queues_[i] belongs to threads_[i - 1].
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    std::atomic<size_t> pending_{0};
+    bool stop_{false};
+};
+
+/// ### function `nr::dune2::parallelTransform`
+/// Call `fn(i)` for each _i_ in _[0, count)_ on the given executor and
+/// collect the results in index order. Errors are handled as in
+/// `Executor.parallelFor`.
+/// #### Parameters
+/// - `Executor &executor` - the executor
+/// - `size_t count` - the number of indexes
+/// - `F &&fn` - the function to call
+/// - `size_t grain_size` - the number of indexes of a task
+/// #### Return
+/// `std::vector<R>` - the results where `R` is the type returned by `fn`.
+template<typename F>
+auto
+parallelTransform(Executor &executor, size_t count, F &&fn, size_t grain_size = 1) {
+    using R = std::decay_t<std::invoke_result_t<F &, size_t>>;
+
+    std::vector<std::optional<R>> results(count);
+    executor.parallelFor(count, [&](size_t i) {
+        results[i].emplace(fn(i));
+    }, grain_size);
+
+    std::vector<R> values;
+    values.reserve(count);
+    for (auto &result: results) {
+        values.push_back(std::move(*result));
+    }
+    return values;
+}
+} // namespace nr::dune2
@@ -0,0 +1,308 @@
+#include "gif.hpp"
+#include "io.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr unsigned min_code_size = 8;
+constexpr unsigned clear_code = 1u << min_code_size;
+constexpr unsigned end_code = clear_code + 1;
+constexpr unsigned max_code_size = 12;
+constexpr unsigned max_code = 1u << max_code_size;
+
+// Pack variable length codes least significant bit first in sub-blocks of at
+// most 255 bytes.
+class CodeWriter {
+public:
+    explicit CodeWriter(std::string &output)
+        : output_{output} {
+    }
+
+public:
+    void write(unsigned code, unsigned size) {
+        bits_ |= std::uint32_t(code) << bitCount_;
+        bitCount_ += size;
+        while (bitCount_ >= 8) {
+            push(bits_ & 0xff);
+            bits_ >>= 8;
+            bitCount_ -= 8;
+        }
+    }
+
+    void flush() {
+        if (bitCount_ > 0) {
+            push(bits_ & 0xff);
+            bits_ = 0;
+            bitCount_ = 0;
+        }
+        if (blockSize_ > 0) {
+            output_.push_back(char(blockSize_));
+            output_.append(reinterpret_cast<const char *>(block_.data()), blockSize_);
+            blockSize_ = 0;
+        }
+        output_.push_back('\0');
+    }
+
+private:
+    void push(std::uint8_t byte) {
+        block_[blockSize_++] = byte;
+        if (blockSize_ == block_.size()) {
+            output_.push_back(char(blockSize_));
+            output_.append(reinterpret_cast<const char *>(block_.data()), blockSize_);
+            blockSize_ = 0;
+        }
+    }
+
+private:
+    std::string &output_;
+    std::uint32_t bits_{0};
+    unsigned bitCount_{0};
+    std::array<std::uint8_t, 255> block_;
+    size_t blockSize_{0};
+};
+
+// The string table maps a (prefix code, next byte) pair to its code with
+// open addressing. With at most 4096 codes in 8192 slots probes stay short.
+class StringTable {
+public:
+    static constexpr size_t Size = 2*max_code;
+
+public:
+    void clear() {
+        std::fill(keys_.begin(), keys_.end(), 0);
+    }
+
+    // Return the slot of the given pair, its key is 0 if the pair is not in
+    // the table.
+    size_t find(unsigned prefix, std::uint8_t byte) const {
+        const auto key = make_key(prefix, byte);
+        auto slot = (key*2654435761u) >> (32 - 13);
+        while (keys_[slot] != 0 && keys_[slot] != key) {
+            slot = (slot + 1) & (Size - 1);
+        }
+        return slot;
+    }
+
+    bool contains(size_t slot) const
+    { return keys_[slot] != 0; }
+
+    unsigned code(size_t slot) const
+    { return codes_[slot]; }
+
+    void insert(size_t slot, unsigned prefix, std::uint8_t byte, unsigned code) {
+        keys_[slot] = make_key(prefix, byte);
+        codes_[slot] = code;
+    }
+
+private:
+    // Keys are never 0 so that 0 marks empty slots.
+    static std::uint32_t make_key(unsigned prefix, std::uint8_t byte)
+    { return ((std::uint32_t(prefix) << 8) | byte) + 1; }
+
+private:
+    std::array<std::uint32_t, Size> keys_{};
+    std::array<std::uint16_t, Size> codes_{};
+};
+
+static_assert(StringTable::Size == 1u << 13, "hash shift mismatch");
+
+// Compress color indexes with the variable length LZW of the GIF format.
+void
+lzw_encode(const std::uint8_t *pixels, size_t count, std::string &output) {
+    output.push_back(char(min_code_size));
+
+    CodeWriter writer(output);
+    auto table = std::make_unique<StringTable>();
+
+    auto code_size = min_code_size + 1;
+    auto next_code = end_code + 1;
+
+    writer.write(clear_code, code_size);
+    if (count == 0) {
+        writer.write(end_code, code_size);
+        writer.flush();
+        return;
+    }
+
+    unsigned prefix = pixels[0];
+    for (size_t i = 1; i < count; ++i) {
+        const auto byte = pixels[i];
+        const auto slot = table->find(prefix, byte);
+        if (table->contains(slot)) {
+            prefix = table->code(slot);
+            continue;
+        }
+
+        writer.write(prefix, code_size);
+        table->insert(slot, prefix, byte, next_code);
+        // The decoder adds its entries one code late, the code size grows
+        // once the new code does not fit anymore.
+        if (next_code == (1u << code_size) && code_size < max_code_size) {
+            ++code_size;
+        }
+        if (++next_code == max_code) {
+            writer.write(clear_code, code_size);
+            table->clear();
+            code_size = min_code_size + 1;
+            next_code = end_code + 1;
+        }
+        prefix = byte;
+    }
+    writer.write(prefix, code_size);
+    // The decoder adds an entry for the last code as well.
+    if (next_code == (1u << code_size) && code_size < max_code_size) {
+        ++code_size;
+    }
+    writer.write(end_code, code_size);
+    writer.flush();
+}
+} // namespace
+
+GIFWriter::GIFWriter(
+    std::ostream &output,
+    size_t width,
+    size_t height,
+    const Palette &palette,
+    bool loop
+)
+    : output_{output}
+    , width_{width}
+    , height_{height} {
+    if (width > std::numeric_limits<std::uint16_t>::max()
+            || height > std::numeric_limits<std::uint16_t>::max()) {
+        throw std::invalid_argument("gif too large");
+    }
+
+    // Header and logical screen descriptor with a 256 colors global table.
+    output_.write("GIF89a", 6);
+    io::writeInteger<2>(output_, width_);
+    io::writeInteger<2>(output_, height_);
+    io::writeInteger<1>(output_, 0xf7u);  // global table, 8 bits colors
+    io::writeInteger<1>(output_, 0u);     // background color
+    io::writeInteger<1>(output_, 0u);     // pixel aspect ratio
+
+    for (auto i = 0u; i < 256; ++i) {
+        const auto color = i < palette.size() ? palette[i] : Palette::Color{};
+        io::writeInteger<1>(output_, color.red);
+        io::writeInteger<1>(output_, color.green);
+        io::writeInteger<1>(output_, color.blue);
+    }
+
+    if (loop) {
+        // NETSCAPE2.0 application extension, loop forever.
+        output_.write("\x21\xff\x0b" "NETSCAPE2.0" "\x03\x01", 16);
+        io::writeInteger<2>(output_, 0u);
+        io::writeInteger<1>(output_, 0u);
+    }
+}
+
+GIFWriter::~GIFWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void
+GIFWriter::write(const Image &image, std::uint16_t delay, bool transparent, size_t x, size_t y) {
+    if (image.isTrimmed()) {
+        const Image untrimmed(
+            image.getWidth(),
+            image.getHeight(),
+            image.getUntrimmedData(),
+            image.getRemapTableData()
+        );
+        write(untrimmed, delay, transparent, x, y);
+        return;
+    }
+
+    const auto &data = image.getData();
+    if (!image.hasRemapTable()) {
+        write(
+            reinterpret_cast<const std::uint8_t *>(data.data()),
+            image.getWidth(),
+            image.getHeight(),
+            delay,
+            transparent,
+            x,
+            y
+        );
+        return;
+    }
+
+    const auto &remap_table = image.getRemapTableData();
+    std::string pixels(data.size(), '\0');
+    std::transform(data.begin(), data.end(), pixels.begin(), [&](char c) {
+        return remap_table[static_cast<std::uint8_t>(c)];
+    });
+    write(
+        reinterpret_cast<const std::uint8_t *>(pixels.data()),
+        image.getWidth(),
+        image.getHeight(),
+        delay,
+        transparent,
+        x,
+        y
+    );
+}
+
+void
+GIFWriter::write(
+    const std::uint8_t *pixels,
+    size_t width,
+    size_t height,
+    std::uint16_t delay,
+    bool transparent,
+    size_t x,
+    size_t y
+) {
+    trace::Span span("gif.write");
+
+    if (closed_) {
+        throw std::logic_error("gif closed");
+    }
+    if (x + width > width_ || y + height > height_) {
+        throw std::invalid_argument("frame out of canvas");
+    }
+
+    // Graphic control extension, transparent frames are cleared to the
+    // background before the next frame.
+    io::writeInteger<1>(output_, 0x21u);
+    io::writeInteger<1>(output_, 0xf9u);
+    io::writeInteger<1>(output_, 4u);
+    io::writeInteger<1>(output_, transparent ? (2u << 2) | 1u : 1u << 2);
+    io::writeInteger<2>(output_, delay);
+    io::writeInteger<1>(output_, 0u);     // transparent color
+    io::writeInteger<1>(output_, 0u);
+
+    // Image descriptor, no local color table.
+    io::writeInteger<1>(output_, 0x2cu);
+    io::writeInteger<2>(output_, x);
+    io::writeInteger<2>(output_, y);
+    io::writeInteger<2>(output_, width);
+    io::writeInteger<2>(output_, height);
+    io::writeInteger<1>(output_, 0u);
+
+    data_.clear();
+    lzw_encode(pixels, width*height, data_);
+    output_.write(data_.data(), data_.size());
+
+    ++frameCount_;
+}
+
+void
+GIFWriter::close() {
+    if (!closed_) {
+        closed_ = true;
+        io::writeInteger<1>(output_, 0x3bu);
+    }
+}
+
+} // namespace nr::dune2
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Dune2/image.hpp>
+#include <Dune2/palette.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::GIFWriter`
+/// Write an animated _GIF_ frame by frame. Frames are written as color
+/// indexes in the global color table made from the palette, there is no
+/// conversion to RGB.
+class GIFWriter {
+public:
+    /// ### constructor `nr::dune2::GIFWriter`
+    /// Write the _GIF_ header and the palette on the given output stream.
+    /// Throw `std::invalid_argument` if the size does not fit in 16 bits.
+    /// #### Parameters
+    /// - `std::ostream &output` - an output stream
+    /// - `size_t width` - the canvas width
+    /// - `size_t height` - the canvas height
+    /// - `const Palette &palette` - the palette
+    /// - `bool loop` - `true` to play the animation in a loop
+    GIFWriter(std::ostream &, size_t width, size_t height, const Palette &, bool loop = true);
+
+    /// ### destructor `nr::dune2::GIFWriter`
+    /// Write the trailer if `close` was not called, errors are ignored.
+    ~GIFWriter();
+
+public:
+    /// ### method `nr::dune2::GIFWriter.write`
+    /// Append a frame. If the frame is transparent, the color `0` is not
+    /// drawn and the frame area is cleared before the next frame, otherwise
+    /// the next frame is drawn over it. Throw `std::invalid_argument` if the
+    /// frame does not fit in the canvas.
+    /// #### Parameters
+    /// - `const Image &image` - the frame, its remap table is applied
+    /// - `std::uint16_t delay` - the frame duration in hundredths of second
+    /// - `bool transparent` - `true` if the color `0` is transparent
+    /// - `size_t x` - the frame left column in the canvas
+    /// - `size_t y` - the frame top row in the canvas
+    void write(const Image &, std::uint16_t delay, bool transparent = false, size_t x = 0, size_t y = 0);
+
+    /// ### method `nr::dune2::GIFWriter.write`
+    /// Same as above for raw color indexes.
+    /// #### Parameters
+    /// - `const std::uint8_t *pixels` - _width*height_ color indexes, row by
+    ///   row
+    /// - `size_t width` - the frame width
+    /// - `size_t height` - the frame height
+    void write(
+        const std::uint8_t *pixels,
+        size_t width,
+        size_t height,
+        std::uint16_t delay,
+        bool transparent = false,
+        size_t x = 0,
+        size_t y = 0
+    );
+
+    /// ### method `nr::dune2::GIFWriter.close`
+    /// Write the trailer, no frame can be added afterward.
+    void close();
+
+    /// ### method `nr::dune2::GIFWriter.getFrameCount`
+    /// #### Return
+    /// `size_t` - the number of frames written so far.
+    size_t getFrameCount() const
+    { return frameCount_; }
+
+private:
+    std::ostream &output_;
+    size_t width_;
+    size_t height_;
+    size_t frameCount_{0};
+    bool closed_{false};
+    std::string data_;
+};
+} // namespace nr::dune2
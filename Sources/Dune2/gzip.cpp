@@ -0,0 +1,208 @@
+#include "gzip.hpp"
+#include "trace.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr std::size_t WindowSize = 32*1024;
+
+struct CompressedBlock {
+    std::string data;
+    std::uint32_t crc;
+};
+
+// Compress a block to raw deflate data. The last block ends the deflate
+// stream, the others end with a sync flush so that the next block starts on
+// a byte boundary.
+CompressedBlock
+compress_block(const std::string &block, const std::string &dictionary, int level, bool last) {
+    trace::Span span("gzip.deflate");
+
+    z_stream stream{};
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("gzip: failed to initialize deflate");
+    }
+    if (!dictionary.empty()) {
+        deflateSetDictionary(
+            &stream,
+            reinterpret_cast<const Bytef *>(dictionary.data()),
+            static_cast<uInt>(dictionary.size())
+        );
+    }
+
+    CompressedBlock compressed{
+        std::string(deflateBound(&stream, static_cast<uLong>(block.size())) + 16, '\0'),
+        static_cast<std::uint32_t>(crc32(
+            0,
+            reinterpret_cast<const Bytef *>(block.data()),
+            static_cast<uInt>(block.size())
+        ))
+    };
+
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(block.data()));
+    stream.avail_in = static_cast<uInt>(block.size());
+    stream.next_out = reinterpret_cast<Bytef *>(compressed.data.data());
+    stream.avail_out = static_cast<uInt>(compressed.data.size());
+
+    const auto status = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    const auto ok = last ? status == Z_STREAM_END : status == Z_OK && stream.avail_in == 0;
+    compressed.data.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (!ok) {
+        throw std::runtime_error("gzip: failed to compress data");
+    }
+    return compressed;
+}
+
+void
+write_le32(std::ostream &output, std::uint32_t value) {
+    const char bytes[] = {
+        char(value & 0xff),
+        char((value >> 8) & 0xff),
+        char((value >> 16) & 0xff),
+        char((value >> 24) & 0xff),
+    };
+    output.write(bytes, sizeof(bytes));
+}
+} // namespace
+
+OGzipStream::Buffer::Buffer(
+    std::ostream &output,
+    Executor &executor,
+    int level,
+    std::size_t block_size
+)
+    : output_{output}
+    , executor_{executor}
+    , level_{std::clamp(level, 1, 9)}
+    , blockSize_{std::max(block_size, WindowSize)}
+    , crc_{0}
+    , size_{0}
+    , closed_{false} {
+    // ID1 ID2 CM FLG MTIME(4) XFL OS(unknown)
+    const char header[] = {
+        '\x1f', '\x8b', '\x08', '\x00',
+        '\x00', '\x00', '\x00', '\x00',
+        '\x00', '\xff'
+    };
+    output_.write(header, sizeof(header));
+    block_.reserve(blockSize_);
+}
+
+OGzipStream::Buffer::int_type
+OGzipStream::Buffer::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+        return traits_type::not_eof(c);
+    }
+    const auto ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+}
+
+std::streamsize
+OGzipStream::Buffer::xsputn(const char *data, std::streamsize count) {
+    if (closed_) {
+        return 0;
+    }
+    for (auto remaining = static_cast<std::size_t>(count); remaining > 0;) {
+        const auto n = std::min(remaining, blockSize_ - block_.size());
+        block_.append(data, n);
+        data += n;
+        remaining -= n;
+        if (block_.size() == blockSize_) {
+            pushBlock();
+        }
+    }
+    return count;
+}
+
+void
+OGzipStream::Buffer::pushBlock() {
+    blocks_.push_back(std::move(block_));
+    block_.clear();
+    block_.reserve(blockSize_);
+    // A block is only compressed once the next one exists, so at least two
+    // are needed even with a single thread.
+    if (blocks_.size() == std::max<std::size_t>(2, executor_.getThreadCount())) {
+        compressBlocks(false);
+    }
+}
+
+// Compress the pending blocks concurrently, then write them in order. Blocks
+// are only compressed once the next one exists, or on close, so that the
+// last block is known to end the stream.
+void
+OGzipStream::Buffer::compressBlocks(bool last) {
+    const auto count = last ? blocks_.size() : blocks_.size() - 1;
+
+    const auto compressed = parallelTransform(executor_, count, [&](std::size_t i) {
+        const auto &dictionary = i == 0 ? dictionary_ : blocks_[i - 1];
+        return compress_block(
+            blocks_[i],
+            dictionary.size() > WindowSize
+                ? dictionary.substr(dictionary.size() - WindowSize)
+                : dictionary,
+            level_,
+            last && i + 1 == count
+        );
+    });
+
+    for (std::size_t i = 0; i < count; ++i) {
+        output_.write(compressed[i].data.data(), compressed[i].data.size());
+        crc_ = static_cast<std::uint32_t>(crc32_combine(
+            crc_,
+            compressed[i].crc,
+            static_cast<z_off_t>(blocks_[i].size())
+        ));
+        size_ += static_cast<std::uint32_t>(blocks_[i].size());
+    }
+    if (count > 0) {
+        dictionary_ = blocks_[count - 1];
+    }
+    blocks_.erase(blocks_.begin(), blocks_.begin() + count);
+}
+
+void
+OGzipStream::Buffer::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+
+    blocks_.push_back(std::move(block_));
+    compressBlocks(true);
+
+    write_le32(output_, crc_);
+    write_le32(output_, size_);
+    output_.flush();
+}
+
+OGzipStream::OGzipStream(
+    std::ostream &output,
+    Executor &executor,
+    int level,
+    std::size_t block_size
+)
+    : std::ostream(nullptr)
+    , buffer_(output, executor, level, block_size) {
+    rdbuf(&buffer_);
+}
+
+OGzipStream::~OGzipStream() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void
+OGzipStream::close() {
+    buffer_.close();
+}
+
+} // namespace nr::dune2
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Dune2/executor.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::OGzipStream`
+/// An output stream compressing its data to a _gzip_ stream written on
+/// another output stream.
+///
+/// Data is cut in blocks compressed concurrently on an executor, the way
+/// `pigz` does: each block is primed with the last 32KiB of the previous
+/// one and ends on a byte boundary, so the result is a single standard
+/// deflate stream. At most one block per executor thread, and no less than
+/// two, is held in memory.
+class OGzipStream : public std::ostream {
+public:
+    /// ### constructor `nr::dune2::OGzipStream`
+    /// The output and the executor must outlive the stream.
+    /// #### Parameters
+    /// - `std::ostream &output` - the stream receiving the compressed data
+    /// - `Executor &executor` - the executor compressing the blocks
+    /// - `int level` - the compression level, from `1` (fastest) to `9`
+    ///   (best)
+    /// - `std::size_t block_size` - the number of bytes of a block
+    OGzipStream(
+        std::ostream &output,
+        Executor &executor,
+        int level = 6,
+        std::size_t block_size = 128*1024
+    );
+    ~OGzipStream();
+
+    OGzipStream(const OGzipStream &) = delete;
+    OGzipStream &operator=(const OGzipStream &) = delete;
+
+public:
+    /// ### method `nr::dune2::OGzipStream.close`
+    /// Compress the pending data and write the _gzip_ trailer. Nothing can be
+    /// written after. Throw `std::runtime_error` if compression fails.
+    void close();
+
+private:
+    class Buffer : public std::streambuf {
+    public:
+        Buffer(std::ostream &, Executor &, int level, std::size_t block_size);
+
+    public:
+        void close();
+
+    protected:
+        virtual int_type overflow(int_type) override;
+        virtual std::streamsize xsputn(const char *, std::streamsize) override;
+
+    private:
+        void pushBlock();
+        void compressBlocks(bool last);
+
+    private:
+        std::ostream &output_;
+        Executor &executor_;
+        int level_;
+        std::size_t blockSize_;
+
+        std::string block_;
+        std::vector<std::string> blocks_;
+        std::string dictionary_;
+
+        std::uint32_t crc_;
+        std::uint32_t size_;
+        bool closed_;
+    };
+    Buffer buffer_;
+};
+} // namespace nr::dune2
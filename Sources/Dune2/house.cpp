@@ -0,0 +1,82 @@
+#include "house.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr std::array<const char *, HouseCount> house_names{
+    "harkonnen",
+    "atreides",
+    "ordos",
+    "fremen",
+    "sardaukar",
+    "mercenary",
+};
+} // namespace
+
+HouseRemap::HouseRemap(House house)
+    : house_{house} {
+    for (auto i = 0u; i < table_.size(); ++i) {
+        table_[i] = FirstColor + i;
+    }
+    for (auto i = 0u; i < ColorCount; ++i) {
+        table_[i] = FirstColor + 16*static_cast<unsigned>(house) + i;
+    }
+}
+
+void
+HouseRemap::apply(const std::uint8_t *src, std::size_t count, std::uint8_t *dst) const {
+    simd::getKernels().remapRange(src, count, FirstColor, table_.data(), dst);
+}
+
+const char *
+getHouseName(House house) {
+    return house_names.at(static_cast<std::size_t>(house));
+}
+
+std::optional<House>
+findHouse(const std::string &name) {
+    std::string lower_name(name);
+    std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), [](unsigned char c) {
+        return std::tolower(c);
+    });
+
+    const auto it = std::find(house_names.begin(), house_names.end(), lower_name);
+    if (it == house_names.end()) {
+        return std::nullopt;
+    }
+    return static_cast<House>(it - house_names.begin());
+}
+
+std::vector<Image>
+createHouseVariants(const Image &image, const std::vector<House> &houses) {
+    trace::Span span("house.remap");
+
+    // Resolve the image colors once, variants share them.
+    auto data = image.getUntrimmedData();
+    if (image.hasRemapTable()) {
+        const auto &remap_table = image.getRemapTableData();
+        std::transform(data.begin(), data.end(), data.begin(), [&](char c) {
+            return remap_table[static_cast<std::uint8_t>(c)];
+        });
+    }
+
+    std::vector<Image> variants;
+    variants.reserve(houses.size());
+    for (auto house: houses) {
+        std::string pixels(data.size(), '\0');
+        HouseRemap(house).apply(
+            reinterpret_cast<const std::uint8_t *>(data.data()),
+            data.size(),
+            reinterpret_cast<std::uint8_t *>(pixels.data())
+        );
+        variants.emplace_back(image.getWidth(), image.getHeight(), std::move(pixels));
+    }
+    return variants;
+}
+
+} // namespace nr::dune2
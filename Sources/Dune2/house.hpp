@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Dune2/image.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### enum `nr::dune2::House`
+/// The houses in the order of the game.
+enum class House : std::uint8_t {
+    Harkonnen,
+    Atreides,
+    Ordos,
+    Fremen,
+    Sardaukar,
+    Mercenary,
+};
+
+/// ### constant `nr::dune2::HouseCount`
+/// The number of houses.
+constexpr std::size_t HouseCount = 6;
+
+/// ### class `nr::dune2::HouseRemap`
+/// Recolor images the way the game does for the units and structures of a
+/// house: the Harkonnen colors `144..150` are replaced by the same colors of
+/// the 16 colors range of the house.
+class HouseRemap {
+public:
+    /// ### constant `nr::dune2::HouseRemap::FirstColor`
+    /// The first color of the range of the first house.
+    static constexpr std::uint8_t FirstColor = 144;
+
+    /// ### constant `nr::dune2::HouseRemap::ColorCount`
+    /// The number of remapped colors of a range.
+    static constexpr std::size_t ColorCount = 7;
+
+public:
+    /// ### constructor `nr::dune2::HouseRemap`
+    /// #### Parameters
+    /// - `House house` - a house
+    explicit HouseRemap(House);
+
+public:
+    House getHouse() const
+    { return house_; }
+
+    /// ### method `nr::dune2::HouseRemap.getTable`
+    /// #### Return
+    /// `const std::array<std::uint8_t, 16> &` - the colors mapped to the 16
+    /// colors starting at `FirstColor`.
+    const std::array<std::uint8_t, 16> &getTable() const
+    { return table_; }
+
+    /// ### method `nr::dune2::HouseRemap.apply`
+    /// Recolor color indexes.
+    /// #### Parameters
+    /// - `const std::uint8_t *src` - the source color indexes
+    /// - `std::size_t count` - the number of color indexes
+    /// - `std::uint8_t *dst` - the destination, can be `src`
+    void apply(const std::uint8_t *src, std::size_t count, std::uint8_t *dst) const;
+
+private:
+    House house_;
+    std::array<std::uint8_t, 16> table_;
+};
+
+/// ### function `nr::dune2::getHouseName`
+/// #### Return
+/// `const char *` - the lower case name of the given house.
+const char *getHouseName(House);
+
+/// ### function `nr::dune2::findHouse`
+/// #### Parameters
+/// - `const std::string &name` - a house name, case is ignored
+/// #### Return
+/// `std::optional<House>` - the house of the given name if any.
+std::optional<House> findHouse(const std::string &);
+
+/// ### function `nr::dune2::createHouseVariants`
+/// Recolor an image for several houses. The image remap table is applied
+/// once, then each variant costs a single pass over the pixels.
+/// #### Parameters
+/// - `const Image &image` - an image
+/// - `const std::vector<House> &houses` - the houses
+/// #### Return
+/// `std::vector<Image>` - an image without remap table per house, in the
+/// order of `houses`.
+std::vector<Image> createHouseVariants(const Image &, const std::vector<House> &);
+} // namespace nr::dune2
@@ -1,35 +1,40 @@
 #include "icon_set.hpp"
 
+#include <cassert>
+
 namespace nr::dune2 {
 
 IconSet::Icon::Surface::Surface(
     const std::size_t col,
     const std::size_t row,
-    std::vector<Image> &&tiles)
-    : column_{col}
+    TileIndexList tiles,
+    const ImageSet &images)
+    : images_{&images}
+    , column_{col}
     , row_{row}
-    , tiles_{std::move(tiles)} {
+    , tiles_{tiles} {
 }
 
 size_t
 IconSet::Icon::Surface::getWidth() const {
-    return column_*tiles_.front().getWidth();
+    return column_*images_->getImage(tiles_[0]).getWidth();
 }
 
 size_t
 IconSet::Icon::Surface::getHeight() const {
-    return row_*tiles_.front().getHeight();
+    return row_*images_->getImage(tiles_[0]).getHeight();
 }
 
 size_t
 IconSet::Icon::Surface::getPixel(size_t x, size_t y) const {
     assert((x < getWidth()) && (y < getHeight()));
 
-    const auto w = tiles_.front().getWidth();
-    const auto h = tiles_.front().getHeight();
+    const auto &first_tile = images_->getImage(tiles_[0]);
+    const auto w = first_tile.getWidth();
+    const auto h = first_tile.getHeight();
 
     const auto tile_index = x/w + (y/h)*column_;
-    const auto &tile = tiles_.at(tile_index);
+    const auto &tile = images_->getImage(tiles_.at(tile_index));
 
     x = x%w;
     y = y%h;
@@ -49,15 +54,17 @@ IconSet::Icon::getRowCount() const {
 
 IconSet::Icon::Surface
 IconSet::Icon::getSurface(const ImageSet &tileset) const {
-    using namespace std::placeholders;
-    std::vector<Image> tiles;
-    std::transform(
-        tiles_.begin(),
-        tiles_.end(),
-        std::back_inserter(tiles),
-        std::bind(&ImageSet::getImage, tileset, _1)
-    );
-    return Surface(columns_, rows_, std::move(tiles));
+    return Surface(columns_, rows_, getTileIndexList(), tileset);
+}
+
+IconSet::IconIterator
+IconSet::begin() const {
+    return IconIterator(*this, 0);
+}
+
+IconSet::IconIterator
+IconSet::end() const {
+    return IconIterator(*this, icons_.size());
 }
 
 } // namespace nr::dune2
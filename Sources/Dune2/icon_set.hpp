@@ -5,25 +5,73 @@
 
 #include <rapidjson/document.h>
 
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace nr::dune2 {
 class IconSet {
 public:
+    /// ### type `nr::dune2::IconSet::TileIndex`
+    /// The index of a tile in an `ImageSet`.
+    using TileIndex = std::uint16_t;
+
+    /// ### class `nr::dune2::IconSet::Icon`
+    /// A view on an icon of an `IconSet`. An `Icon` remains valid as long as
+    /// its `IconSet` is not modified.
     class Icon {
     public:
-        using TileList = std::vector<Image>;
-        using TileIndexList = std::vector<std::size_t>;
+        /// ### class `nr::dune2::IconSet::Icon::TileIndexList`
+        /// A view on the tiles indexes of an icon.
+        class TileIndexList {
+        public:
+            using value_type = TileIndex;
+            using const_iterator = const TileIndex *;
+
+        public:
+            TileIndexList(const TileIndex *first, std::size_t size)
+                : first_{first}
+                , size_{size} {
+            }
+
+        public:
+            const_iterator begin() const
+            { return first_; }
+
+            const_iterator end() const
+            { return first_ + size_; }
+
+            std::size_t size() const
+            { return size_; }
+
+            TileIndex operator[](std::size_t index) const
+            { return first_[index]; }
+
+            TileIndex at(std::size_t index) const {
+                if (index >= size_) {
+                    throw std::out_of_range("tile index out of range");
+                }
+                return first_[index];
+            }
+
+        private:
+            const TileIndex *first_;
+            std::size_t size_;
+        };
 
     public:
         class Surface : public nr::dune2::Surface {
+            const ImageSet *images_;
             std::size_t column_;
             std::size_t row_;
-            std::vector<Image> tiles_;
+            TileIndexList tiles_;
 
         public:
-            Surface(std::size_t col, std::size_t row, TileList &&);
+            Surface(std::size_t col, std::size_t row, TileIndexList, const ImageSet &);
 
         public:
             /// ### method `nr::dune2::IconSet::Icon::Surface.getWidth`
@@ -43,22 +91,19 @@ public:
         };
 
     public:
-        template<typename T>
-        Icon(std::size_t cols, std::size_t rows, T &&tiles)
-            : columns_{cols}
-            , rows_{rows}
-            , tiles_{std::forward<T>(tiles)} {
-            static_assert(std::is_same_v<TileIndexList, std::remove_cv_t<T>>);
-            assert(columns_*rows_ <= tiles_.size());
+        Icon(std::size_t cols, std::size_t rows, const TileIndex *tiles)
+            : tiles_{tiles}
+            , columns_{static_cast<std::uint8_t>(cols)}
+            , rows_{static_cast<std::uint8_t>(rows)} {
         }
 
     public:
         /// ### method `nr::dune2::IconSet::Icon::getTileIndexList`
         /// Get the tiles indexes
         /// #### Return
-        /// - `const std::vector<std::size_t> &`
-        const TileIndexList &getTileIndexList() const
-        { return tiles_; }
+        /// - `TileIndexList` - a view on the _columns*rows_ tiles indexes
+        TileIndexList getTileIndexList() const
+        { return TileIndexList(tiles_, columns_*rows_); }
 
         /// ### method `nr::dune2::IconSet::Icon.getColumnCount`
         /// Get the number of tiles on the width of the icon.
@@ -73,20 +118,23 @@ public:
         std::size_t getRowCount() const;
 
         /// ### method `nr::dune2::IconSet::Icon.getSurface`
-        /// Get an IconSurface
+        /// Get an IconSurface. The surface refers to the given `ImageSet`.
         /// #### Return
         /// - `nr::dune2::IconSet::Icon::Surface`
         Surface getSurface(const ImageSet &) const;
 
     private:
-        std::size_t columns_;
-        std::size_t rows_;
-        TileIndexList tiles_;
+        const TileIndex *tiles_;
+        std::uint8_t columns_;
+        std::uint8_t rows_;
     };
 
-    /// ### class `nr::dune2::ImageSet::TileIterator`
-    /// An input iterator to iterate throught tiles.
-    using IconIterator = std::vector<Icon>::const_iterator;
+    class IconIterator;
+
+public:
+    /// ### constant `nr::dune2::IconSet::LandscapeGroup`
+    /// The index of the landscape icons group of `ICON.MAP`.
+    static constexpr std::size_t LandscapeGroup = 8;
 
 public:
     /// ### method `nr::dune2::IconSet::loadFromMAP`
@@ -95,6 +143,19 @@ public:
     /// - `const std::filesystem::path &map_path` - a path to `*.map` file
     void loadFromMAP(const std::filesystem::path &);
 
+    /// ### method `nr::dune2::IconSet::loadFromMAP`
+    /// Load tiles from the given `.map` data stream.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    void loadFromMAP(std::istream &);
+
+    /// ### method `nr::dune2::IconSet::loadFromMAP`
+    /// Load tiles from the given `.map` data, for example a `PAK` entry data
+    /// or a mapped file.
+    /// #### Parameters
+    /// - `std::string_view map_data` - the `.map` file content
+    void loadFromMAP(std::string_view);
+
     /// ### method `nr::dune2::ImageSet::loadFromJSON`
     /// Load tiles from the given _JSON_ value.
     /// #### Parameters
@@ -119,29 +180,147 @@ public:
     /// #### Parameters
     /// - `icon_index` - the tile index.
     /// #### Return
-    /// `IconSet::Icon` - an icon _icons[icons_index]_.
-    const Icon &getIcon(size_t icon_index) const
-    { return icons_.at(icon_index); }
+    /// `IconSet::Icon` - a view on the icon _icons[icons_index]_.
+    Icon getIcon(size_t icon_index) const {
+        const auto &shape = icons_.at(icon_index);
+        return Icon(shape.columns, shape.rows, tiles_.data() + shape.offset);
+    }
+
+    /// ### method `nr::dune2::IconSet.getGroupCount`
+    /// Icons loaded from a `.map` file are organized in groups. Icon sets
+    /// loaded from other sources have no group.
+    /// #### Return
+    /// `size_t` - the number of icon groups.
+    size_t getGroupCount() const
+    { return groups_.size(); }
+
+    /// ### method `nr::dune2::IconSet.getGroupOffset`
+    /// #### Parameters
+    /// - `group_index` - the group index.
+    /// #### Return
+    /// `size_t` - the index of the first icon of the group.
+    size_t getGroupOffset(size_t group_index) const
+    { return groups_.at(group_index); }
+
+    /// ### method `nr::dune2::IconSet.getGroupSize`
+    /// #### Parameters
+    /// - `group_index` - the group index.
+    /// #### Return
+    /// `size_t` - the number of icons of the group.
+    size_t getGroupSize(size_t group_index) const {
+        const auto last = group_index + 1 < groups_.size()
+            ? groups_[group_index + 1]
+            : icons_.size();
+        return last - groups_.at(group_index);
+    }
 
     /// ### method `nr::dune2::IconSet.begin`
     /// #### Return
     /// `IconSet::IconIterator` - an iterator on the first tile.
-    IconIterator begin() const
-    { return icons_.begin(); }
+    IconIterator begin() const;
 
     /// ### method `nr::dune2::IconSet.end`
     /// #### Return
     /// `IconSet::IconIterator` - an iterator on the last tile.
-    IconIterator end() const
-    { return icons_.end(); }
+    IconIterator end() const;
 
 public:
-    template <typename T>
-    void push_back(T &&icon) {
-        icons_.push_back(std::forward<T>(icon));
+    /// ### method `nr::dune2::IconSet.addIcon`
+    /// Append an icon of _columns*rows_ tiles.
+    /// #### Parameters
+    /// - `std::size_t columns` - the number of tiles on the width of the icon
+    /// - `std::size_t rows` - the number of tiles on the height of the icon
+    /// - `InputIt first, InputIt last` - the range of tiles indexes
+    template <typename InputIt>
+    void addIcon(std::size_t columns, std::size_t rows, InputIt first, InputIt last) {
+        constexpr auto shape_max = std::numeric_limits<std::uint8_t>::max();
+        constexpr auto index_max = std::numeric_limits<TileIndex>::max();
+
+        if (columns > shape_max || rows > shape_max) {
+            throw std::invalid_argument("icon shape too large");
+        }
+
+        const auto offset = tiles_.size();
+        for (; first != last; ++first) {
+            const auto index = *first;
+            if (static_cast<std::uintmax_t>(index) > index_max) {
+                tiles_.resize(offset);
+                throw std::out_of_range("tile index out of range");
+            }
+            tiles_.push_back(static_cast<TileIndex>(index));
+        }
+
+        if (tiles_.size() - offset != columns*rows) {
+            tiles_.resize(offset);
+            throw std::invalid_argument("icon shape does not match its tiles count");
+        }
+
+        icons_.push_back(IconShape{
+            static_cast<std::uint32_t>(offset),
+            static_cast<std::uint8_t>(columns),
+            static_cast<std::uint8_t>(rows),
+        });
+    }
+
+    void push_back(const Icon &icon) {
+        const auto tiles = icon.getTileIndexList();
+        addIcon(icon.getColumnCount(), icon.getRowCount(), tiles.begin(), tiles.end());
     }
 
 private:
-    std::vector<Icon> icons_;
+    // Icons are stored in a compressed sparse row layout: the tiles indexes
+    // of all icons are packed in one array, each icon only records its
+    // offset in this array and its shape.
+    struct IconShape {
+        std::uint32_t offset;
+        std::uint8_t columns;
+        std::uint8_t rows;
+    };
+
+    std::vector<TileIndex> tiles_;
+    std::vector<IconShape> icons_;
+    std::vector<std::uint32_t> groups_;
+};
+
+/// ### class `nr::dune2::IconSet::IconIterator`
+/// An input iterator to iterate throught icons.
+class IconSet::IconIterator {
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Icon;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Icon;
+
+public:
+    IconIterator(const IconSet &icons, size_t index)
+        : icons_{&icons}
+        , index_{index} {
+    }
+
+public:
+    reference operator*() const
+    { return icons_->getIcon(index_); }
+
+    IconIterator &operator++() {
+        ++index_;
+        return *this;
+    }
+
+    IconIterator operator++(int) {
+        auto it = *this;
+        ++index_;
+        return it;
+    }
+
+    bool operator==(const IconIterator &other) const
+    { return icons_ == other.icons_ && index_ == other.index_; }
+
+    bool operator!=(const IconIterator &other) const
+    { return !(*this == other); }
+
+private:
+    const IconSet *icons_;
+    size_t index_;
 };
 } // namespace nr::dune2
@@ -6,23 +6,25 @@
 namespace nr::dune2 {
 
 namespace {
-IconSet::Icon load_icon_from_JSON(const rapidjson::Value &value) {
-    const auto &images_indexes_value = value.FindMember("images")->value;
+void load_icon_from_JSON(IconSet &icons, const rapidjson::Value &value) {
+    const auto &shape_value = value.FindMember("shape")->value;
+    const auto &indexes_value = value.FindMember("indexes")->value;
 
-    IconSet::Icon::TileIndexList image_indexes;
+    std::vector<unsigned int> indexes;
     std::transform(
-        images_indexes_value.Begin(),
-        images_indexes_value.End(),
-        std::back_inserter(image_indexes),
+        indexes_value.Begin(),
+        indexes_value.End(),
+        std::back_inserter(indexes),
         [](const auto &index_value) {
-            return index_value.GetInt();
+            return index_value.GetUint();
         }
     );
 
-    return IconSet::Icon(
-        value.FindMember("columns")->value.GetUint(),
-        value.FindMember("rows")->value.GetUint(),
-        std::move(image_indexes)
+    icons.addIcon(
+        shape_value.FindMember("columns")->value.GetUint(),
+        shape_value.FindMember("rows")->value.GetUint(),
+        indexes.begin(),
+        indexes.end()
     );
 }
 } // namespace
@@ -32,11 +34,12 @@ IconSet::loadFromJSON(const std::filesystem::path &json_path) {
     std::fstream input(json_path);
     const auto json = io::loadJSON(input);
 
-    std::transform(
+    std::for_each(
         json.Begin(),
         json.End(),
-        std::back_inserter(icons_),
-        load_icon_from_JSON
+        [this](const auto &value) {
+            load_icon_from_JSON(*this, value);
+        }
     );
 }
 
@@ -1,13 +1,19 @@
 #include "icon_set.hpp"
 #include "io.hpp"
 
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
 
 namespace nr::dune2 {
 
 namespace {
 
-using ImageIndexList = std::vector<std::size_t>;
+using ImageIndexList = std::vector<IconSet::TileIndex>;
 using ImageIndexListIterator = ImageIndexList::const_iterator;
 using ImageIndexRangeList = std::vector<std::tuple<
         ImageIndexListIterator,
@@ -21,103 +27,127 @@ using ShapeList = std::vector<std::tuple<
     >
 >;
 
-void
-icons_from_index(
-    std::size_t icon_index,
-    ImageIndexListIterator first,
-    ImageIndexListIterator last,
-    std::vector<IconSet::Icon> &icons
-) {
-    ShapeList shapes;
-
+ShapeList
+icon_shapes_from_index(std::size_t icon_index, std::size_t tile_count) {
     switch (icon_index) {
     case 10:
-        shapes = ShapeList( 4, std::make_tuple(3, 3));
-        break;
+        return ShapeList( 4, std::make_tuple(3, 3));
     case 11:
     case 25:
-        shapes = ShapeList( 6, std::make_tuple(2, 2));
-        break;
+        return ShapeList( 6, std::make_tuple(2, 2));
     case 12:
     case 13:
-        shapes = ShapeList( 8, std::make_tuple(3, 2));
-        break;
+        return ShapeList( 8, std::make_tuple(3, 2));
     case 14:
     case 15:
     case 16:
     case 17:
     case 18:
     case 24:
-        shapes = ShapeList( 4, std::make_tuple(2, 2));
-        break;
+        return ShapeList( 4, std::make_tuple(2, 2));
     case 19:
-        shapes = ShapeList(10, std::make_tuple(3, 3));
-        break;
+        return ShapeList(10, std::make_tuple(3, 3));
     case 20:
     case 21:
-        shapes = ShapeList(10, std::make_tuple(3, 2));
-        break;
+        return ShapeList(10, std::make_tuple(3, 2));
     default:
-        shapes = ShapeList(std::distance(first, last), std::make_tuple(1, 1));
-        break;
+        return ShapeList(tile_count, std::make_tuple(1, 1));
     }
+}
 
-    std::for_each(
+std::size_t
+icon_shapes_tile_count(const ShapeList &shapes) {
+    return std::accumulate(
         shapes.begin(),
         shapes.end(),
-        [&](const auto shape) mutable {
+        std::size_t{0},
+        [](auto count, const auto &shape) {
             const auto [columns, rows] = shape;
-            const auto count = columns*rows;
+            return count + columns*rows;
+        }
+    );
+}
+
+// The file starts with a table of group offsets. The first entry is the
+// number of entries of the table, hence the offset of the first group. Each
+// group extends to the next group offset, the last group extends to the end
+// of the file.
+ImageIndexRangeList
+map_read_groups(const ImageIndexList &indexes) {
+    if (indexes.empty()) {
+        throw std::invalid_argument("corrupted file");
+    }
 
-            assert(first + count <= last);
-            icons.emplace_back(IconSet::Icon(
-                columns, rows,
-                ImageIndexList(first, first + count)
-            ));
+    const std::size_t group_table_size = indexes[0];
+    if (group_table_size < 1 || group_table_size > indexes.size()) {
+        throw std::invalid_argument("corrupted file");
+    }
 
-            first += count;
+    ImageIndexRangeList ranges;
+    for (auto group = 1u; group < group_table_size; ++group) {
+        const std::size_t first = indexes[group];
+        const std::size_t last = group + 1 < group_table_size
+            ? indexes[group + 1]
+            : indexes.size();
+
+        if (first < group_table_size || first > last || last > indexes.size()) {
+            throw std::invalid_argument("corrupted file");
         }
-    );
+
+        ranges.emplace_back(indexes.begin() + first, indexes.begin() + last);
+    }
+    return ranges;
 }
 } // namespace
 
 void
 IconSet::loadFromMAP(const std::filesystem::path &map_path) {
-    std::fstream map_input(map_path, std::ios::binary|std::ios::in);
-    ImageIndexList indexes;
+    std::ifstream map_input(map_path, std::ios::binary);
+    map_input.exceptions(std::ios::failbit|std::ios::badbit);
+    loadFromMAP(map_input);
+}
+
+void
+IconSet::loadFromMAP(std::istream &map_input) {
+    const auto map_data = io::readAll(map_input);
+    loadFromMAP(std::string_view(map_data));
+}
 
-    while (!map_input.eof()) {
-        indexes.emplace_back(io::readLEInteger<2>(map_input));
+void
+IconSet::loadFromMAP(std::string_view map_data) {
+    if (map_data.size() % sizeof(TileIndex) != 0) {
+        throw std::invalid_argument("corrupted file");
     }
 
-    ImageIndexRangeList ranges;
-    std::transform(
-        indexes.begin() + 1,
-        indexes.begin() + indexes[0],
-        indexes.begin() + 2,
-        std::back_inserter(ranges),
-        [&](auto first, auto last) {
-            last = last > 0 ? last : indexes.size();
-            return std::make_tuple(
-                indexes.begin() + first,
-                indexes.begin() + last
-            );
+    ImageIndexList indexes(map_data.size()/sizeof(TileIndex));
+    std::memcpy(indexes.data(), map_data.data(), map_data.size());
+    io::fromLittleEndian(indexes.data(), indexes.size());
+
+    const auto ranges = map_read_groups(indexes);
+
+    // Check that every group holds enough tiles for its icons before
+    // modifying this set.
+    std::vector<ShapeList> group_shapes;
+    for (const auto &[first, last]: ranges) {
+        const auto tile_count = static_cast<std::size_t>(std::distance(first, last));
+        auto shapes = icon_shapes_from_index(group_shapes.size(), tile_count);
+        if (icon_shapes_tile_count(shapes) > tile_count) {
+            throw std::invalid_argument("corrupted file");
         }
-    );
+        group_shapes.push_back(std::move(shapes));
+    }
 
-    std::for_each(
-        ranges.begin(),
-        ranges.end(),
-        [&, icon_index = 0u](const auto &range) mutable {
-            const auto [first, last] = range;
-            icons_from_index(
-                icon_index++,
-                first,
-                last,
-                icons_
-            );
+    tiles_.reserve(tiles_.size() + indexes.size());
+    for (auto group = 0u; group < ranges.size(); ++group) {
+        groups_.push_back(static_cast<std::uint32_t>(icons_.size()));
+
+        auto first = std::get<0>(ranges[group]);
+        for (const auto &[columns, rows]: group_shapes[group]) {
+            const auto count = columns*rows;
+            addIcon(columns, rows, first, first + count);
+            first += count;
         }
-    );
+    }
 }
 
 } // namespace nr::dune2
@@ -1,4 +1,5 @@
 #include "icon_set.hpp"
+#include "trace.hpp"
 
 namespace nr::dune2 {
 
@@ -32,12 +33,14 @@ icon_to_JSON(
 
 Document
 IconSet::toJSON() const {
+    trace::Span span("json.build");
+
     Document doc;
 
     auto &allocator = doc.GetAllocator();
     auto &icons = doc.SetArray();
     
-    for (auto &&icon : icons_) {
+    for (auto &&icon : *this) {
         icons.PushBack(icon_to_JSON(allocator, icon), allocator);
     }
 
@@ -1,14 +1,48 @@
 #include "image.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
 
 namespace nr::dune2 {
 
+Image::Image(
+    size_t width, size_t height,
+    size_t left, size_t top,
+    size_t data_width, size_t data_height,
+    std::string data,
+    std::string data_remap_table
+)
+    : width_{width}
+    , height_{height}
+    , left_{left}
+    , top_{top}
+    , dataWidth_{data_width}
+    , dataHeight_{data_height}
+    , data_{std::move(data)}
+    , dataRemapTable_{std::move(data_remap_table)} {
+    if (left_ + dataWidth_ > width_
+            || top_ + dataHeight_ > height_
+            || data_.size() != dataWidth_*dataHeight_) {
+        throw std::invalid_argument("corrupted data");
+    }
+}
+
 size_t
 Image::getPixel(size_t x, size_t y) const {
     assert(x < getWidth());
     assert(y < getHeight());
 
-    const auto index = y*getWidth() + x;
-    const auto pixel = static_cast<unsigned char>(data_[index]);
+    auto pixel = 0u;
+    if (x - left_ < dataWidth_ && y - top_ < dataHeight_) {
+        const auto index = (y - top_)*dataWidth_ + x - left_;
+        pixel = static_cast<unsigned char>(data_[index]);
+    }
     if (hasRemapTable()) {
         return static_cast<unsigned char>(dataRemapTable_[pixel]);
     }
@@ -20,6 +54,77 @@ Image::getData() const {
     return data_;
 }
 
+std::string
+Image::getUntrimmedData() const {
+    if (!isTrimmed()) {
+        return data_;
+    }
+
+    std::string data(width_*height_, '\0');
+    for (auto y = 0u; y < dataHeight_; ++y) {
+        std::memcpy(
+            data.data() + (top_ + y)*width_ + left_,
+            data_.data() + y*dataWidth_,
+            dataWidth_
+        );
+    }
+    return data;
+}
+
+void
+Image::trim() {
+    trace::Span span("image.trim");
+
+    const auto &kernels = simd::getKernels();
+    const auto data = reinterpret_cast<const std::uint8_t *>(data_.data());
+
+    // One pass gives the rows holding opaque pixels and, ORed together, the
+    // columns holding opaque pixels.
+    std::vector<std::uint8_t> columns(dataWidth_, 0);
+    auto y_min = dataHeight_, y_max = size_t{0};
+    for (auto y = 0u; y < dataHeight_; ++y) {
+        if (kernels.orAccumulate(columns.data(), data + y*dataWidth_, dataWidth_) != 0) {
+            y_min = std::min(y_min, size_t(y));
+            y_max = y + 1;
+        }
+    }
+
+    if (y_min >= y_max) {
+        left_ = top_ = 0;
+        dataWidth_ = dataHeight_ = 0;
+        data_.clear();
+        return;
+    }
+
+    const auto x_min = size_t(std::find_if(columns.begin(), columns.end(), [](auto c) {
+        return c != 0;
+    }) - columns.begin());
+    const auto x_max = size_t(std::find_if(columns.rbegin(), columns.rend(), [](auto c) {
+        return c != 0;
+    }).base() - columns.begin());
+
+    if (x_min == 0 && y_min == 0 && x_max == dataWidth_ && y_max == dataHeight_) {
+        return;
+    }
+
+    const auto box_width = x_max - x_min;
+    const auto box_height = y_max - y_min;
+    std::string box(box_width*box_height, '\0');
+    for (auto y = 0u; y < box_height; ++y) {
+        std::memcpy(
+            box.data() + y*box_width,
+            data_.data() + (y_min + y)*dataWidth_ + x_min,
+            box_width
+        );
+    }
+
+    left_ += x_min;
+    top_ += y_min;
+    dataWidth_ = box_width;
+    dataHeight_ = box_height;
+    data_ = std::move(box);
+}
+
 const std::string &
 Image::getRemapTableData() const {
     return dataRemapTable_;
@@ -2,12 +2,19 @@
 
 #include <Dune2/surface.hpp>
 
+#include <cstddef>
 #include <filesystem>
+#include <istream>
 #include <string>
 
 namespace nr::dune2 {
 /// ### class nr::dune2::ImageSet::Image
 /// An image loaded from an `.icn` or an `.shp` file.
+///
+/// A trimmed image only stores the data of a box holding its opaque pixels,
+/// the pixels outside of the box are `0` before remapping. Its width and
+/// height stay the ones of the whole image.
+///
 /// `nr::dune2::ImageSet::Image` implements `nr::dune2::Surface`.
 /// See [`nr::dune2::Surface`](/docs/nr/dune2/surface) for more details.
 class Image: public Surface {
@@ -16,13 +23,21 @@ class Image: public Surface {
 public:
     Image()
         : width_{0}
-        , height_{0} {
+        , height_{0}
+        , left_{0}
+        , top_{0}
+        , dataWidth_{0}
+        , dataHeight_{0} {
     }
 
     template <typename T>
     Image(size_t width, size_t height, T &&data)
         : width_{width}
         , height_{height}
+        , left_{0}
+        , top_{0}
+        , dataWidth_{width}
+        , dataHeight_{height}
         , data_{std::forward<T>(data)} {
     }
 
@@ -30,10 +45,34 @@ public:
     Image(size_t width, size_t height, T &&data, U &&data_remap_table)
         : width_{width}
         , height_{height}
+        , left_{0}
+        , top_{0}
+        , dataWidth_{width}
+        , dataHeight_{height}
         , data_{std::forward<T>(data)}
         , dataRemapTable_{std::forward<U>(data_remap_table)} {
     }
 
+    /// ### constructor `nr::dune2::Image`
+    /// Build a trimmed image. Throw `std::invalid_argument` if the box does
+    /// not fit in the image or if the data size does not match the box.
+    /// #### Parameters
+    /// - `size_t width` - the image width
+    /// - `size_t height` - the image height
+    /// - `size_t left` - the box left column
+    /// - `size_t top` - the box top row
+    /// - `size_t data_width` - the box width
+    /// - `size_t data_height` - the box height
+    /// - `std::string data` - the box data
+    /// - `std::string data_remap_table` - the remap table, empty if none
+    Image(
+        size_t width, size_t height,
+        size_t left, size_t top,
+        size_t data_width, size_t data_height,
+        std::string data,
+        std::string data_remap_table = std::string()
+    );
+
 public:
     /// ### method `nr::dune2::Image::loadFromCPS`
     /// Load image data from given `.cps` files.
@@ -41,6 +80,12 @@ public:
     /// - `const std::filesystem::path &icn_path` - a path to `*.cps` file
     void loadFromCPS(const std::filesystem::path &);
 
+    /// ### method `nr::dune2::Image::loadFromCPS`
+    /// Load image data from the given `.cps` data stream.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    void loadFromCPS(std::istream &);
+
 public:
     /// ### method `nr::dune2::ImageSet::Image.getWidth`
     /// See [`nr::dune2::Surface.getWidth`](/docs/nr/dune2/surface#getWidth)
@@ -61,9 +106,38 @@ public:
 
     /// ### method `nr::dune2::ImageSet::Image::getData`
     /// #### Return
-    /// - `const std::string &` - a reference on the tile's raw data.
+    /// - `const std::string &` - a reference on the tile's raw data, the
+    /// data of the box row by row if the image is trimmed.
     const std::string &getData() const;
 
+    /// ### method `nr::dune2::ImageSet::Image::getUntrimmedData`
+    /// #### Return
+    /// - `std::string` - the raw data of the whole image, row by row.
+    std::string getUntrimmedData() const;
+
+    size_t getLeft() const
+    { return left_; }
+
+    size_t getTop() const
+    { return top_; }
+
+    size_t getDataWidth() const
+    { return dataWidth_; }
+
+    size_t getDataHeight() const
+    { return dataHeight_; }
+
+    /// ### method `nr::dune2::ImageSet::Image::isTrimmed`
+    /// #### Return
+    /// - `bool` - `true` if the data box is smaller than the image.
+    bool isTrimmed() const
+    { return dataWidth_ != width_ || dataHeight_ != height_; }
+
+    /// ### method `nr::dune2::ImageSet::Image::trim`
+    /// Shrink the data box to the smallest box holding the pixels which are
+    /// not `0` before remapping.
+    void trim();
+
     /// ### method `nr::dune2::ImageSet::Image::getRemapTableData`
     /// #### Return
     /// - `const std::string &` - a reference on the tile's remap table raw
@@ -78,6 +152,10 @@ public:
 private:
     size_t width_;
     size_t height_;
+    size_t left_;
+    size_t top_;
+    size_t dataWidth_;
+    size_t dataHeight_;
     std::string data_;
     std::string dataRemapTable_;
 };
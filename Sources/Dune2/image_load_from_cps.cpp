@@ -15,6 +15,11 @@ Image::loadFromCPS(const fs::path &cps_path) {
     input.open(cps_path, std::ios::binary);
     input.exceptions(std::ios::failbit);
 
+    loadFromCPS(input);
+}
+
+void
+Image::loadFromCPS(std::istream &input) {
     const auto file_size = io::readLEInteger<2>(input);
     const auto compression_type = io::readLEInteger<2>(input);
     const auto inflated_size = io::readLEInteger<4>(input);
@@ -36,6 +41,10 @@ Image::loadFromCPS(const fs::path &cps_path) {
 
     width_ = 320;
     height_ = 200;
+    left_ = 0;
+    top_ = 0;
+    dataWidth_ = width_;
+    dataHeight_ = height_;
     data_ = std::string(data.begin(), data.end());
 }
 
@@ -14,17 +14,40 @@ ImageSet::getImageCount() const {
 
 const Image &
 ImageSet::getImage(size_t tile_index) const {
-    return tiles_[tile_index];
+    const auto &entry = tiles_[tile_index];
+    if (entry.decoder) {
+        std::call_once(entry.decoded, [&entry] {
+            entry.image = entry.decoder();
+        });
+    }
+    return entry.image;
+}
+
+const Mask &
+ImageSet::getMask(size_t tile_index) const {
+    const auto &entry = tiles_[tile_index];
+    std::call_once(entry.masked, [&] {
+        if (!entry.mask) {
+            entry.mask.emplace(getImage(tile_index));
+        }
+    });
+    return *entry.mask;
+}
+
+void
+ImageSet::trim(size_t tile_index) {
+    getImage(tile_index);
+    tiles_[tile_index].image.trim();
 }
 
 ImageSet::TileIterator
 ImageSet::begin() const {
-    return tiles_.begin();
+    return TileIterator(*this, 0);
 }
 
 ImageSet::TileIterator
 ImageSet::end() const {
-    return tiles_.end();
+    return TileIterator(*this, tiles_.size());
 }
 
 } // namespace nr::dune2
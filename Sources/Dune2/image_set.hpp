@@ -1,32 +1,70 @@
 #pragma once
 
 #include <Dune2/image.hpp>
+#include <Dune2/mask.hpp>
 
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <mutex>
+#include <optional>
 #include <string>
-#include <vector>
 
 #include <rapidjson/document.h>
 
 namespace nr::dune2 {
 class ImageSet {
 public:
-    /// ### class `nr::dune2::ImageSet::TileIterator`
-    /// An input iterator to iterate throught tiles.
-    using TileIterator = std::vector<Image>::const_iterator;
+    /// ### enum `nr::dune2::ImageSet::LoadPolicy`
+    /// - `Eager` - every image is decoded at load time,
+    /// - `Lazy` - only the file index is parsed at load time, an image is
+    ///   decoded the first time it is accessed.
+    enum class LoadPolicy {
+        Eager,
+        Lazy,
+    };
+
+    /// ### type `nr::dune2::ImageSet::ImageDecoder`
+    /// A function decoding an image on demand.
+    using ImageDecoder = std::function<Image()>;
+
+    class TileIterator;
+
+public:
+    ImageSet() = default;
+    ImageSet(ImageSet &&) = default;
+    ImageSet &operator=(ImageSet &&) = default;
 
 public:
     /// ### method `nr::dune2::ImageSet::loadFromICN`
     /// Load tiles from given `.icn` files.
     /// #### Parameters
     /// - `const std::filesystem::path &icn_path` - a path to `*.icn` file
-    void loadFromICN(const std::filesystem::path &);
+    /// - `LoadPolicy policy` - decode tiles now or on demand
+    void loadFromICN(const std::filesystem::path &, LoadPolicy = LoadPolicy::Eager);
+
+    /// ### method `nr::dune2::ImageSet::loadFromICN`
+    /// Load tiles from the given `.icn` data stream.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    /// - `LoadPolicy policy` - decode tiles now or on demand
+    void loadFromICN(std::istream &, LoadPolicy = LoadPolicy::Eager);
 
     /// ### method `nr::dune2::ImageSet::loadFromSHP`
     /// Load tiles from given `.shp` files.
     /// #### Parameters
     /// - `const std::filesystem::path &shp_path` - a path to `*.shp` file
-    void loadFromSHP(const std::filesystem::path &);
+    /// - `LoadPolicy policy` - decode frames now or on demand
+    void loadFromSHP(const std::filesystem::path &, LoadPolicy = LoadPolicy::Eager);
+
+    /// ### method `nr::dune2::ImageSet::loadFromSHP`
+    /// Load tiles from the given `.shp` data stream.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    /// - `LoadPolicy policy` - decode frames now or on demand
+    void loadFromSHP(std::istream &, LoadPolicy = LoadPolicy::Eager);
 
     /// ### method `nr::dune2::ImageSet::loadFromJSON`
     /// Load tiles from the given _JSON_ value.
@@ -34,12 +72,33 @@ public:
     /// - `const std::filesystem::path &` - a path to `*.json` file
     void loadFromJSON(const std::filesystem::path &);
 
+public:
+    /// ### method `nr::dune2::ImageSet::storeToICN`
+    /// Write the tiles to the given `.icn` file. See the stream overload.
+    /// #### Parameters
+    /// - `const std::filesystem::path &icn_path` - a path to `*.icn` file
+    void storeToICN(const std::filesystem::path &) const;
+
+    /// ### method `nr::dune2::ImageSet::storeToICN`
+    /// Write the tiles as `.icn` data, 4 bits per pixel. Tiles share a pool
+    /// of 16 colors sub-palettes: a tile reuses a sub-palette holding all its
+    /// colors, or completes one having enough free entries, before a new one
+    /// is added. Throw `std::invalid_argument` if the tiles do not have the
+    /// same size, a multiple of 8, or if a tile has more than 16 colors, and
+    /// `std::length_error` if more than 256 sub-palettes are needed.
+    /// #### Parameters
+    /// - `std::ostream &output` - an output stream
+    void storeToICN(std::ostream &) const;
+
 public:
     /// ### method `nr::dune2::ImageSet::toJSON`
     /// Transform this tileset to _JSON_ document
+    /// #### Parameters
+    /// - `bool masks` - also write the opacity mask of each tile, so that
+    ///   they are not computed again when the document is loaded
     /// #### Return
     /// `rapidjson::Document` - a json document
-    rapidjson::Document toJSON() const;
+    rapidjson::Document toJSON(bool masks = false) const;
 
 public:
     /// ### method `nr::dune2::ImageSet.getName`
@@ -64,12 +123,24 @@ public:
     size_t getImageCount() const;
 
     /// ### method `nr::dune2::ImageSet.getImage`
+    /// If the image was loaded lazily, it is decoded on the first call. It is
+    /// safe to call this method concurrently.
     /// #### Parameters
     /// - `tile_index` - the tile index.
     /// #### Return
     /// `ImageSet::Image` - a tile _tiles[tile_index]_.
     const Image &getImage(size_t tile_index) const;
 
+    /// ### method `nr::dune2::ImageSet.getMask`
+    /// Return the opacity mask of a tile. Unless it was loaded with the
+    /// tiles, the mask is computed on the first call. It is safe to call this
+    /// method concurrently.
+    /// #### Parameters
+    /// - `tile_index` - the tile index.
+    /// #### Return
+    /// `const Mask &` - the mask of _tiles[tile_index]_.
+    const Mask &getMask(size_t tile_index) const;
+
     /// ### method `nr::dune2::ImageSet.tilesBegin`
     /// #### Return
     /// `ImageSet::TileIterator` - an iterator on the first tile.
@@ -80,14 +151,86 @@ public:
     /// `ImageSet::TileIterator` - an iterator on the last tile.
     TileIterator end() const;
 
+    /// ### method `nr::dune2::ImageSet.trim`
+    /// Trim a tile to the box of its opaque pixels, see
+    /// `nr::dune2::Image.trim`. It is safe to trim distinct tiles
+    /// concurrently.
+    /// #### Parameters
+    /// - `tile_index` - the tile index.
+    void trim(size_t tile_index);
+
 public:
+    /// ### method `nr::dune2::ImageSet.push_back`
+    /// Append an image or an `ImageDecoder` producing it on demand.
     template <typename T>
     void push_back(T &&image) {
-        tiles_.push_back(std::forward<T>(image));
+        tiles_.emplace_back(std::forward<T>(image));
     }
 
 private:
+    struct Entry {
+        explicit Entry(Image image)
+            : image{std::move(image)} {
+        }
+
+        explicit Entry(ImageDecoder decoder)
+            : decoder{std::move(decoder)} {
+        }
+
+        ImageDecoder decoder;
+        mutable std::once_flag decoded;
+        mutable Image image;
+
+        mutable std::once_flag masked;
+        mutable std::optional<Mask> mask;
+    };
+
     std::string name_;
-    std::vector<Image> tiles_;
+    std::deque<Entry> tiles_;
+};
+
+/// ### class `nr::dune2::ImageSet::TileIterator`
+/// An input iterator to iterate throught tiles.
+class ImageSet::TileIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Image;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Image *;
+    using reference = const Image &;
+
+public:
+    TileIterator(const ImageSet &images, size_t index)
+        : images_{&images}
+        , index_{index} {
+    }
+
+public:
+    reference operator*() const
+    { return images_->getImage(index_); }
+
+    pointer operator->() const
+    { return &images_->getImage(index_); }
+
+    TileIterator &operator++() {
+        ++index_;
+        return *this;
+    }
+
+    TileIterator operator++(int) {
+        auto it = *this;
+        ++index_;
+        return it;
+    }
+
+    bool operator==(const TileIterator &other) const
+    { return images_ == other.images_ && index_ == other.index_; }
+
+    bool operator!=(const TileIterator &other) const
+    { return !(*this == other); }
+
+private:
+    const ImageSet *images_;
+    size_t index_;
 };
 } // namespace nr::dune2
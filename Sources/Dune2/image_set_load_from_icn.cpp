@@ -1,9 +1,11 @@
 #include "image_set.hpp"
 #include "io.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
 
-#include <stdexcept>
 #include <fstream>
-#include <iostream>
+#include <memory>
+#include <stdexcept>
 
 namespace fs = std::filesystem;
 namespace nr::dune2 {
@@ -36,12 +38,29 @@ struct ICNInfo {
     { return 1<<bitPerPixels; }
 };
 
-using SSet = std::vector<std::string>;
+struct SSet {
+    /// #### attribute `offset`
+    /// The position of the first tile in the file data.
+    size_t offset;
+
+    /// #### attribute `count`
+    /// The number of tiles.
+    size_t count;
+};
+
 using RPal = std::vector<std::string>;
 using RTbl = std::vector<uint8_t>;
 
+struct ICNData {
+    std::string data;
+    ICNInfo info;
+    SSet sset;
+    RPal rpal;
+    RTbl rtbl;
+};
+
 ICNInfo
-read_sinf_chunk(std::ifstream &input) {
+read_sinf_chunk(std::istream &input) {
     using namespace std::literals;
 
     io::check(input, []{ return "SINF"sv; });
@@ -62,7 +81,7 @@ read_sinf_chunk(std::ifstream &input) {
 }
 
 SSet
-read_sset_chunk(std::ifstream &input, const ICNInfo &info) {
+read_sset_chunk(std::istream &input, const ICNInfo &info) {
     using namespace std::literals;
 
     io::check(input, []{ return "SSET"sv; });
@@ -76,17 +95,15 @@ read_sset_chunk(std::ifstream &input, const ICNInfo &info) {
     // ABCD being little endian representation of sset_chunk_size - 4.
     input.ignore(8);
 
-    SSet sset;
-    std::generate_n(
-        std::back_inserter(sset),
-        tile_count,
-        [&] { return io::readString(input, tile_size); }
-    );
+    // Tiles are decoded later, only skip them now.
+    const SSet sset{size_t(input.tellg()), tile_count};
+    input.seekg(tile_count*tile_size, std::ios::cur);
+
     return sset;
 }
 
 RPal
-read_rpal_chunk(std::ifstream &input, const ICNInfo &info) {
+read_rpal_chunk(std::istream &input, const ICNInfo &info) {
     using namespace std::literals;
 
     io::check(input, []{ return "RPAL"sv; });
@@ -105,7 +122,7 @@ read_rpal_chunk(std::ifstream &input, const ICNInfo &info) {
 }
 
 RTbl
-read_rtbl_chunk(std::ifstream &input, const ICNInfo &info) {
+read_rtbl_chunk(std::istream &input, const ICNInfo &info) {
     using namespace std::literals;
 
     io::check(input, []{ return "RTBL"sv; });
@@ -115,16 +132,64 @@ read_rtbl_chunk(std::ifstream &input, const ICNInfo &info) {
 
     return rtbl;
 }
+Image
+icn_read_tile(const ICNData &icn, size_t tile_index) {
+    trace::Span span("decode.icn");
+
+    const auto &info = icn.info;
+    const auto &rpal = icn.rpal.at(icn.rtbl[tile_index]);
+
+    const auto bpp = info.bitPerPixels;
+    const auto tile_size = info.getTileSize();
+    const auto first = icn.data.begin() + icn.sset.offset + tile_index*tile_size;
+
+    std::string data;
+
+    if (bpp == 4 && rpal.size() == 16) {
+        data.resize(2*tile_size);
+        simd::getKernels().unpackNibbles(
+            reinterpret_cast<const uint8_t *>(&*first),
+            tile_size,
+            reinterpret_cast<const uint8_t *>(rpal.data()),
+            reinterpret_cast<uint8_t *>(data.data())
+        );
+        return Image(info.width, info.height, std::move(data));
+    }
+
+    data.reserve(info.width*info.height);
+    std::for_each(first, first + tile_size, [&](unsigned char b) {
+        for (auto i = 8/bpp; i > 0; --i) {
+            const auto p = (b >> (i - 1)*bpp) & ((1 << bpp) - 1);
+            data.push_back(rpal[p]);
+        }
+    });
+
+    return Image(info.width, info.height, std::move(data));
+}
 } // namespace
 
 void
-ImageSet::loadFromICN(const fs::path &icn_path) {
-    using namespace std::literals;
+ImageSet::loadFromICN(const fs::path &icn_path, LoadPolicy policy) {
     std::ifstream input;
 
     input.open(icn_path, std::ios::binary);
     input.exceptions(std::ios::failbit);
 
+    loadFromICN(input, policy);
+}
+
+void
+ImageSet::loadFromICN(std::istream &icn_input, LoadPolicy policy) {
+    using namespace std::literals;
+
+    // Tiles are decoded from a shared copy of the file data so that they can
+    // be decoded later, and concurrently, in lazy mode.
+    auto icn = std::make_shared<ICNData>();
+    icn->data = io::readAll(icn_input);
+
+    io::IMemoryStream input(icn->data);
+    input.exceptions(std::ios::failbit);
+
     // First read IFF chunk group ID (wich must be FORM)
     io::check(input, []{ return "FORM"sv;});
 
@@ -134,33 +199,32 @@ ImageSet::loadFromICN(const fs::path &icn_path) {
     io::check(input, []{ return "ICON"sv;});
 
     // Keep read order below
-    const auto info = read_sinf_chunk(input);
-    const auto sset = read_sset_chunk(input, info);
-    const auto rpal = read_rpal_chunk(input, info);
-    const auto rtbl = read_rtbl_chunk(input, info);
+    icn->info = read_sinf_chunk(input);
+    icn->sset = read_sset_chunk(input, icn->info);
+    icn->rpal = read_rpal_chunk(input, icn->info);
+    icn->rtbl = read_rtbl_chunk(input, icn->info);
 
-    if (sset.size() != rtbl.size()) {
+    if (icn->sset.count != icn->rtbl.size()) {
         throw std::invalid_argument("corrupted file");
     }
 
-    std::transform(
-        sset.begin(), sset.end(),
-        rtbl.begin(),
-        std::back_inserter(tiles_),
-        [&](auto &raw_data, auto rpal_index) {
-            const auto bpp = info.bitPerPixels;
-            std::string data;
-
-            for (auto &&b: raw_data) {
-                for (auto i = 8/bpp; i > 0; --i) {
-                    const auto p = (b >> (i - 1)*bpp) & ((1 << bpp) - 1);
-                    data.push_back(rpal[rpal_index][p]);
-                }
-            }
-
-            return Image(info.width, info.height, std::move(data));
+    const auto is_valid_rpal_index = [&](auto rpal_index) {
+        return rpal_index < icn->rpal.size();
+    };
+    if (!std::all_of(icn->rtbl.begin(), icn->rtbl.end(), is_valid_rpal_index)) {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    const std::shared_ptr<const ICNData> icn_data = std::move(icn);
+    for (auto tile_index = 0u; tile_index < icn_data->sset.count; ++tile_index) {
+        if (policy == LoadPolicy::Lazy) {
+            push_back(ImageDecoder([icn_data, tile_index] {
+                return icn_read_tile(*icn_data, tile_index);
+            }));
+        } else {
+            push_back(icn_read_tile(*icn_data, tile_index));
         }
-    );
+    }
 }
 
 } // namespace nr::dune2
@@ -1,15 +1,21 @@
 #include "image_set.hpp"
 #include "io.hpp"
+#include "trace.hpp"
 
 #include <cppcodec/base64_rfc4648.hpp>
 
+#include <cstdint>
 #include <fstream>
+#include <stdexcept>
+#include <vector>
 
 namespace nr::dune2 {
 
 std::string
 decode(const rapidjson::Value &value) {
     using base64 = cppcodec::base64_rfc4648;
+    trace::Span span("base64.decode");
+
     return base64::decode<std::string>(std::string(value.GetString()));
 }
 
@@ -19,23 +25,69 @@ Image load_tile_from_JSON(const rapidjson::Value &value) {
     unsigned int height{value.FindMember("h")->value.GetUint()};
     std::string data(decode(value.FindMember("data")->value));
 
+    if (value.HasMember("dw")) {
+        std::string remap;
+        if (value.HasMember("remap")) {
+            remap = decode(value.FindMember("remap")->value);
+        }
+        return Image(
+            width,
+            height,
+            value.FindMember("x")->value.GetUint(),
+            value.FindMember("y")->value.GetUint(),
+            value.FindMember("dw")->value.GetUint(),
+            value.FindMember("dh")->value.GetUint(),
+            std::move(data),
+            std::move(remap)
+        );
+    }
+
     if (value.HasMember("remap")) {
         std::string remap(decode(value.FindMember("remap")->value));
         return Image(width, height, data, remap);
     }
     return Image(width, height, data);
 }
+
+Mask load_mask_from_JSON(const Image &tile, const rapidjson::Value &value) {
+    const auto bytes = decode(value.FindMember("data")->value);
+    if (bytes.size()%8 != 0) {
+        throw std::invalid_argument("corrupted data");
+    }
+
+    std::vector<std::uint64_t> words(bytes.size()/8, 0);
+    for (auto i = 0u; i < bytes.size(); ++i) {
+        words[i/8] |= std::uint64_t(std::uint8_t(bytes[i])) << (8*(i%8));
+    }
+
+    return Mask(
+        tile.getWidth(),
+        tile.getHeight(),
+        value.FindMember("x")->value.GetUint(),
+        value.FindMember("y")->value.GetUint(),
+        value.FindMember("w")->value.GetUint(),
+        value.FindMember("h")->value.GetUint(),
+        std::move(words)
+    );
+}
 }
 
 void
 ImageSet::loadFromJSON(const std::filesystem::path &filepath) {
     std::ifstream input(filepath);
     const auto json = io::loadJSON(input);
-    std::transform(
+    std::for_each(
         json.Begin(),
         json.End(),
-        std::back_inserter(tiles_),
-        load_tile_from_JSON
+        [this](const auto &value) {
+            push_back(load_tile_from_JSON(value));
+            if (value.HasMember("mask")) {
+                tiles_.back().mask = load_mask_from_JSON(
+                    tiles_.back().image,
+                    value.FindMember("mask")->value
+                );
+            }
+        }
     );
 }
 } // namespace nr::dune2
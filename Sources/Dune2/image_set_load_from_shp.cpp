@@ -1,9 +1,11 @@
 #include "image_set.hpp"
 #include "io.hpp"
+#include "trace.hpp"
 
-#include <stdexcept>
+#include <bitset>
 #include <fstream>
-#include <iostream>
+#include <memory>
+#include <stdexcept>
 
 namespace fs = std::filesystem;
 namespace nr::dune2 {
@@ -16,7 +18,7 @@ enum class SHPVersion {
 };
 
 SHPVersion
-shp_read_version(std::ifstream &input) {
+shp_read_version(std::istream &input) {
     io::IPosOffsetGuard _(input);
     input.seekg(4);
     return nr::dune2::io::readLEInteger<2>(input) != 0
@@ -51,7 +53,12 @@ shp_read_frame_offsets(std::istream &input, SHPVersion version) {
 }
 
 Image
-shp_read_tile(std::istream &input, std::istream::pos_type pos) {
+shp_read_tile(const std::string &shp_data, std::istream::pos_type pos) {
+    trace::Span span("decode.shp");
+
+    io::IMemoryStream input(shp_data);
+
+    input.exceptions(std::ios::failbit);
     input.seekg(pos);
 
     std::bitset<16> frame_flags(io::readLEInteger<2>(input));
@@ -88,12 +95,16 @@ shp_read_tile(std::istream &input, std::istream::pos_type pos) {
         rle_data = io::readLCWData(input, frame_data_size, rle_data_size);
     }
 
-    auto it = rle_data.begin();
-    while (it != rle_data.end()) {
-        const auto n = it - rle_data.begin();
-        const auto value = *it++;
-        const auto count = (value == 0 ? *it++ : 1);
-        data.insert(data.end(), count, value);
+    {
+        trace::Span rle_span("decode.rle");
+
+        auto it = rle_data.begin();
+        while (it != rle_data.end()) {
+            const auto n = it - rle_data.begin();
+            const auto value = *it++;
+            const auto count = (value == 0 ? *it++ : 1);
+            data.insert(data.end(), count, value);
+        }
     }
 
     return Image(width, height, std::move(data), std::move(data_remap_table));
@@ -102,23 +113,39 @@ shp_read_tile(std::istream &input, std::istream::pos_type pos) {
 } // namespace
 
 void
-ImageSet::loadFromSHP(const fs::path &shp_path) {
+ImageSet::loadFromSHP(const fs::path &shp_path, LoadPolicy policy) {
     std::ifstream input;
 
     input.open(shp_path, std::ios::binary);
     input.exceptions(std::ios::failbit);
 
+    loadFromSHP(input, policy);
+}
+
+void
+ImageSet::loadFromSHP(std::istream &shp_input, LoadPolicy policy) {
+    // Frames are decoded from a shared copy of the file data so that they
+    // can be decoded later, and concurrently, in lazy mode.
+    const auto shp_data = std::make_shared<const std::string>(io::readAll(shp_input));
+
+    io::IMemoryStream input(*shp_data);
+    input.exceptions(std::ios::failbit);
+
     const auto version = shp_read_version(input);
     const auto offsets = shp_read_frame_offsets(input, version);
 
-    std::transform(
-        offsets.begin(),
-        offsets.end(),
-        std::back_inserter(tiles_),
-        [&](const auto pos) {
-            return shp_read_tile(input, pos);
+    for (auto &&pos: offsets) {
+        if (pos >= std::istream::pos_type(shp_data->size())) {
+            throw std::invalid_argument("corrupted file");
         }
-    );
+        if (policy == LoadPolicy::Lazy) {
+            push_back(ImageDecoder([shp_data, pos] {
+                return shp_read_tile(*shp_data, pos);
+            }));
+        } else {
+            push_back(shp_read_tile(*shp_data, pos));
+        }
+    }
 }
 
 } // namespace nr::dune2
@@ -0,0 +1,249 @@
+#include "image_set.hpp"
+#include "io.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace nr::dune2 {
+
+namespace {
+constexpr size_t icn_palette_size = 16;
+constexpr size_t icn_max_palette_count = 256;
+constexpr size_t icn_size_shift = 3;
+
+// The set of the colors of a tile or of a palette, one bit per color, so
+// that testing if a tile fits in a palette costs four word operations.
+struct ColorSignature {
+    std::array<std::uint64_t, 4> words{};
+
+    void insert(std::uint8_t color)
+    { words[color/64] |= std::uint64_t{1} << (color%64); }
+
+    bool contains(std::uint8_t color) const
+    { return (words[color/64] >> (color%64)) & 1; }
+
+    // Number of colors of this set missing from the other one.
+    size_t countMissing(const ColorSignature &other) const {
+        size_t count = 0;
+        for (auto i = 0u; i < words.size(); ++i) {
+            count += __builtin_popcountll(words[i] & ~other.words[i]);
+        }
+        return count;
+    }
+
+    size_t count() const {
+        size_t count = 0;
+        for (auto word: words) {
+            count += __builtin_popcountll(word);
+        }
+        return count;
+    }
+};
+
+struct Tile {
+    std::string pixels;
+    ColorSignature signature;
+    size_t colorCount;
+};
+
+struct SubPalette {
+    std::string colors;
+    ColorSignature signature;
+};
+
+void
+write_chunk_header(std::ostream &output, const char *id, size_t size) {
+    output.write(id, 4);
+    for (auto shift = 24; shift >= 0; shift -= 8) {
+        output.put(char((size >> shift) & 0xff));
+    }
+}
+
+// Resolve the pixels of an image through its remap table, the whole image
+// when it is trimmed.
+std::string
+read_tile_pixels(const Image &image) {
+    auto pixels = image.getUntrimmedData();
+    if (image.hasRemapTable()) {
+        const auto &remap_table = image.getRemapTableData();
+        std::transform(pixels.begin(), pixels.end(), pixels.begin(), [&](char c) {
+            return remap_table[static_cast<std::uint8_t>(c)];
+        });
+    }
+    return pixels;
+}
+
+// Give a sub-palette to each tile. Tiles are taken from the most colorful
+// so that the palettes they create can hold the colors of the simpler ones.
+// A tile reuses the first palette holding all its colors, else it completes
+// the palette with the fewest missing colors and enough free entries, else
+// it starts a new palette.
+std::vector<std::uint8_t>
+assign_sub_palettes(const std::vector<Tile> &tiles, std::vector<SubPalette> &palettes) {
+    std::vector<size_t> order(tiles.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) {
+        return tiles[a].colorCount > tiles[b].colorCount;
+    });
+
+    std::vector<std::uint8_t> rtbl(tiles.size(), 0);
+    for (auto tile_index: order) {
+        const auto &tile = tiles[tile_index];
+
+        auto best = palettes.size();
+        auto best_missing = icn_palette_size + 1;
+        for (auto i = 0u; i < palettes.size() && best_missing > 0; ++i) {
+            const auto missing = tile.signature.countMissing(palettes[i].signature);
+            if (missing < best_missing && palettes[i].colors.size() + missing <= icn_palette_size) {
+                best = i;
+                best_missing = missing;
+            }
+        }
+
+        if (best == palettes.size()) {
+            if (palettes.size() == icn_max_palette_count) {
+                throw std::length_error("too many sub-palettes");
+            }
+            palettes.emplace_back();
+        }
+
+        auto &palette = palettes[best];
+        for (auto color = 0u; color < 256; ++color) {
+            if (tile.signature.contains(color) && !palette.signature.contains(color)) {
+                palette.colors.push_back(char(color));
+                palette.signature.insert(color);
+            }
+        }
+        rtbl[tile_index] = std::uint8_t(best);
+    }
+    return rtbl;
+}
+} // namespace
+
+void
+ImageSet::storeToICN(const fs::path &icn_path) const {
+    std::ofstream output;
+
+    output.exceptions(std::ios::failbit);
+    output.open(icn_path, std::ios::binary);
+
+    storeToICN(output);
+}
+
+void
+ImageSet::storeToICN(std::ostream &output) const {
+    trace::Span span("encode.icn");
+
+    const auto tile_count = getImageCount();
+    if (tile_count == 0) {
+        throw std::invalid_argument("no tile");
+    }
+
+    const auto width = getImage(0).getWidth();
+    const auto height = getImage(0).getHeight();
+    const auto size_unit = size_t{1} << icn_size_shift;
+    if (width == 0 || height == 0
+            || width%size_unit != 0 || height%size_unit != 0
+            || (width >> icn_size_shift) > 255 || (height >> icn_size_shift) > 255) {
+        throw std::invalid_argument("invalid tile size");
+    }
+
+    std::vector<Tile> tiles;
+    tiles.reserve(tile_count);
+    for (auto i = 0u; i < tile_count; ++i) {
+        const auto &image = getImage(i);
+        if (image.getWidth() != width || image.getHeight() != height) {
+            throw std::invalid_argument("invalid tile size");
+        }
+        Tile tile{read_tile_pixels(image), {}, 0};
+        for (auto c: tile.pixels) {
+            tile.signature.insert(static_cast<std::uint8_t>(c));
+        }
+        tile.colorCount = tile.signature.count();
+        if (tile.colorCount > icn_palette_size) {
+            throw std::invalid_argument("too many colors in tile");
+        }
+        tiles.push_back(std::move(tile));
+    }
+
+    std::vector<SubPalette> palettes;
+    const auto rtbl = assign_sub_palettes(tiles, palettes);
+
+    // Unused entries of the palettes are 0.
+    for (auto &palette: palettes) {
+        palette.colors.resize(icn_palette_size, '\0');
+    }
+
+    // Map each tile to the indexes of its palette, then pack them two per
+    // byte.
+    const auto &kernels = simd::getKernels();
+    const auto tile_size = width*height/2;
+    std::string sset(tile_count*tile_size, '\0');
+    std::vector<std::uint8_t> indexes(width*height);
+    for (auto i = 0u; i < tile_count; ++i) {
+        const auto &colors = palettes[rtbl[i]].colors;
+        // The padding of a palette can repeat a color, the first entry wins.
+        std::array<std::uint8_t, 256> index_of{};
+        for (auto k = icn_palette_size; k-- > 0;) {
+            index_of[static_cast<std::uint8_t>(colors[k])] = std::uint8_t(k);
+        }
+        std::transform(tiles[i].pixels.begin(), tiles[i].pixels.end(), indexes.begin(), [&](char c) {
+            return index_of[static_cast<std::uint8_t>(c)];
+        });
+        kernels.packNibbles(
+            indexes.data(),
+            tile_size,
+            reinterpret_cast<std::uint8_t *>(sset.data()) + i*tile_size
+        );
+    }
+
+    // SSET data starts with an uncompressed sprite header: the format, the
+    // data size and the size of an extra header.
+    const auto sinf_size = size_t{4};
+    const auto sset_size = 8 + sset.size();
+    const auto rpal_size = palettes.size()*icn_palette_size;
+    const auto rtbl_size = rtbl.size();
+    const auto padded = [](size_t size) { return size + (size & 1); };
+    const auto form_size = 4
+        + 8 + padded(sinf_size)
+        + 8 + padded(sset_size)
+        + 8 + padded(rpal_size)
+        + 8 + padded(rtbl_size);
+
+    write_chunk_header(output, "FORM", form_size);
+    output.write("ICON", 4);
+
+    write_chunk_header(output, "SINF", sinf_size);
+    io::writeInteger<1>(output, std::uint8_t(width >> icn_size_shift));
+    io::writeInteger<1>(output, std::uint8_t(height >> icn_size_shift));
+    io::writeInteger<1>(output, std::uint8_t(icn_size_shift));
+    io::writeInteger<1>(output, std::uint8_t(4));
+
+    write_chunk_header(output, "SSET", sset_size);
+    io::writeInteger<2>(output, std::uint16_t(0));
+    io::writeInteger<4>(output, std::uint32_t(sset.size()));
+    io::writeInteger<2>(output, std::uint16_t(0));
+    output.write(sset.data(), sset.size());
+
+    write_chunk_header(output, "RPAL", rpal_size);
+    for (const auto &palette: palettes) {
+        output.write(palette.colors.data(), palette.colors.size());
+    }
+
+    write_chunk_header(output, "RTBL", rtbl_size);
+    output.write(reinterpret_cast<const char *>(rtbl.data()), rtbl.size());
+    if (rtbl_size & 1) {
+        output.put('\0');
+    }
+}
+
+} // namespace nr::dune2
@@ -1,7 +1,11 @@
 #include "image_set.hpp"
+#include "trace.hpp"
 
 #include <cppcodec/base64_rfc4648.hpp>
 
+#include <cstdint>
+#include <string>
+
 namespace nr::dune2 {
 
 using rapidjson::Document;
@@ -14,11 +18,21 @@ Value tile_to_JSON(
     const Image &tile
 ) {
     using base64 = cppcodec::base64_rfc4648;
+    trace::Span span("base64.encode");
+
     Value value(rapidjson::kObjectType);
 
     value.AddMember("w", Value((unsigned int)tile.getWidth()), allocator);
     value.AddMember("h", Value((unsigned int)tile.getHeight()), allocator);
 
+    // The data of a trimmed image is its data box.
+    if (tile.isTrimmed()) {
+        value.AddMember("x", Value((unsigned int)tile.getLeft()), allocator);
+        value.AddMember("y", Value((unsigned int)tile.getTop()), allocator);
+        value.AddMember("dw", Value((unsigned int)tile.getDataWidth()), allocator);
+        value.AddMember("dh", Value((unsigned int)tile.getDataHeight()), allocator);
+    }
+
     const auto data = base64::encode(tile.getData());
     value.AddMember(
         "data",
@@ -38,15 +52,53 @@ Value tile_to_JSON(
     return value;
 }
 
+// Words are written in little endian order.
+Value mask_to_JSON(
+    MemoryPoolAllocator<> &allocator,
+    const Mask &mask
+) {
+    using base64 = cppcodec::base64_rfc4648;
+    trace::Span span("base64.encode");
+
+    Value value(rapidjson::kObjectType);
+
+    value.AddMember("x", Value((unsigned int)mask.getLeft()), allocator);
+    value.AddMember("y", Value((unsigned int)mask.getTop()), allocator);
+    value.AddMember("w", Value((unsigned int)mask.getBoxWidth()), allocator);
+    value.AddMember("h", Value((unsigned int)mask.getBoxHeight()), allocator);
+
+    std::string bytes;
+    bytes.reserve(8*mask.getWords().size());
+    for (auto word: mask.getWords()) {
+        for (auto i = 0u; i < 8; ++i) {
+            bytes.push_back(char((word >> (8*i)) & 0xff));
+        }
+    }
+    const auto data = base64::encode(bytes);
+    value.AddMember(
+        "data",
+        Value().SetString(data.c_str(), allocator),
+        allocator
+    );
+
+    return value;
+}
+
 }
 
 rapidjson::Document
-ImageSet::toJSON() const {
+ImageSet::toJSON(bool masks) const {
+    trace::Span span("json.build");
+
     rapidjson::Document doc;
     auto &allocator = doc.GetAllocator();
     auto &tiles = doc.SetArray();
-    for (const auto &tile: tiles_) {
-        tiles.PushBack(tile_to_JSON(allocator, tile), allocator);
+    for (auto i = 0u; i < getImageCount(); ++i) {
+        auto tile = tile_to_JSON(allocator, getImage(i));
+        if (masks) {
+            tile.AddMember("mask", mask_to_JSON(allocator, getMask(i)), allocator);
+        }
+        tiles.PushBack(tile, allocator);
     }
     return doc;
 }
@@ -1,4 +1,5 @@
 #include "io.hpp"
+#include "trace.hpp"
 
 #include <sstream>
 
@@ -22,8 +23,53 @@ OPosOffsetGuard::~OPosOffsetGuard() {
     output_.seekp(pos_);
 }
 
+IMemoryStream::Buffer::Buffer(const char *data, size_t size) {
+    char *p = const_cast<char *>(data);
+    setg(p, p, p + size);
+}
+
+IMemoryStream::Buffer::pos_type
+IMemoryStream::Buffer::seekoff(
+    off_type off,
+    std::ios::seekdir dir,
+    std::ios::openmode which) {
+    if (!(which & std::ios::in)) {
+        return pos_type(off_type(-1));
+    }
+
+    const auto pos = off + (dir == std::ios::beg
+        ? 0
+        : dir == std::ios::cur
+            ? gptr() - eback()
+            : egptr() - eback());
+
+    if (pos < 0 || pos > egptr() - eback()) {
+        return pos_type(off_type(-1));
+    }
+
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
+}
+
+IMemoryStream::Buffer::pos_type
+IMemoryStream::Buffer::seekpos(pos_type pos, std::ios::openmode which) {
+    return seekoff(off_type(pos), std::ios::beg, which);
+}
+
+IMemoryStream::IMemoryStream(const char *data, size_t size)
+    : std::istream(nullptr)
+    , buffer_(data, size) {
+    rdbuf(&buffer_);
+}
+
+IMemoryStream::IMemoryStream(std::string_view data)
+    : IMemoryStream(data.data(), data.size()) {
+}
+
 std::string
 readAll(std::istream &in) {
+    trace::Span span("io.read");
+
     std::ostringstream oss;
     std::copy(
         std::istreambuf_iterator<char>(in),
@@ -50,6 +96,8 @@ readString(std::istream &in, size_t size) {
 
 rapidjson::Document
 loadJSON(std::istream &in) {
+    trace::Span span("json.parse");
+
     const auto src = nr::dune2::io::readAll(in);
 
     rapidjson::Document doc;
@@ -4,9 +4,11 @@
 
 #include <rapidjson/document.h>
 
+#include <algorithm>
 #include <array>
 #include <functional>
 #include <istream>
+#include <streambuf>
 #include <string_view>
 #include <vector>
 
@@ -21,6 +23,25 @@ public:
     ~IPosOffsetGuard();
 };
 
+/// IMemoryStream
+/// An input stream reading from a memory buffer without copying it. The
+/// buffer must outlive the stream.
+class IMemoryStream : public std::istream {
+    class Buffer : public std::streambuf {
+    public:
+        Buffer(const char *, size_t);
+
+    protected:
+        virtual pos_type seekoff(off_type, std::ios::seekdir, std::ios::openmode) override;
+        virtual pos_type seekpos(pos_type, std::ios::openmode) override;
+    };
+    Buffer buffer_;
+
+public:
+    IMemoryStream(const char *, size_t);
+    explicit IMemoryStream(std::string_view);
+};
+
 /// readLEInteger
 /// generic function to read a little endian integer on a input stream
 template<int N, typename IntType = uint32_t>
@@ -83,8 +104,34 @@ readData(std::istream &input, size_t count) {
     return buffer;
 }
 
+/// fromLittleEndian
+/// convert in place an array of little endian integers to the host byte
+/// order. This is a no-op on little endian hosts, on big endian hosts the
+/// loop is simple enough to be vectorized by the compiler.
+template<typename T>
+void
+fromLittleEndian(T *data, size_t count) {
+    static_assert(std::is_integral<T>::value, "Integral type required");
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::transform(data, data + count, data, byte_swap<T>::swap);
+#else
+    (void)data;
+    (void)count;
+#endif
+}
+
 std::vector<uint8_t> readLCWData(std::istream &, size_t deflated_size, size_t inflated_size);
 
+/// encodeLCWData
+/// compress data with LCW (Format80) using absolute positions, the output
+/// ends with the 0x80 end marker and is readable by `readLCWData`.
+std::vector<uint8_t> encodeLCWData(const uint8_t *data, size_t size);
+
+/// applyFormat40Data
+/// apply Format40 (XOR delta) data on a frame buffer.
+/// Throw `std::invalid_argument` if the data overflows the frame buffer.
+void applyFormat40Data(const uint8_t *data, size_t size, uint8_t *frame, size_t frame_size);
+
 std::string readAll(std::istream &);
 std::string readString(std::istream &);
 std::string readString(std::istream &, size_t);
@@ -0,0 +1,94 @@
+#include "io.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
+
+#include <stdexcept>
+
+namespace nr::dune2::io {
+
+void
+applyFormat40Data(const uint8_t *data, size_t size, uint8_t *frame, size_t frame_size) {
+    trace::Span span("decode.format40");
+
+    const auto data_end = data + size;
+    const auto frame_end = frame + frame_size;
+
+    const auto &kernels = simd::getKernels();
+
+    const auto check_data = [&](size_t count) {
+        if (count > size_t(data_end - data)) {
+            throw std::invalid_argument("corrupted data");
+        }
+    };
+    const auto check_frame = [&](size_t count) {
+        if (count > size_t(frame_end - frame)) {
+            throw std::invalid_argument("corrupted data");
+        }
+    };
+    const auto read_byte = [&]() {
+        check_data(1);
+        return *data++;
+    };
+    const auto read_word = [&]() {
+        check_data(2);
+        const auto word = uint16_t(data[0] | (data[1] << 8));
+        data += 2;
+        return word;
+    };
+    const auto copy = [&](size_t count) {
+        check_data(count);
+        check_frame(count);
+        kernels.xorCopy(frame, data, count);
+        frame += count;
+        data += count;
+    };
+    const auto fill = [&](size_t count, uint8_t value) {
+        check_frame(count);
+        kernels.xorFill(frame, value, count);
+        frame += count;
+    };
+    const auto skip = [&](size_t count) {
+        check_frame(count);
+        frame += count;
+    };
+
+    while (data < data_end) {
+        const auto cmd = read_byte();
+
+        if (cmd == 0) {
+            // command 1: short xor fill
+            // 0b00000000 c v
+            const auto count = read_byte();
+            fill(count, read_byte());
+        } else if ((cmd & 0x80) == 0) {
+            // command 2: short xor copy
+            // 0b0ccccccc
+            copy(cmd);
+        } else if (cmd != 0x80) {
+            // command 3: short skip
+            // 0b1ccccccc
+            skip(cmd & 0x7f);
+        } else {
+            const auto word = read_word();
+            if (word == 0) {
+                // command 4: end of data
+                // 0b10000000 0 0
+                break;
+            } else if ((word & 0x8000) == 0) {
+                // command 5: long skip
+                // 0b10000000 c 0b0ccccccc
+                skip(word);
+            } else if ((word & 0x4000) == 0) {
+                // command 6: long xor copy
+                // 0b10000000 c 0b10cccccc
+                copy(word & 0x3fff);
+            } else {
+                // command 7: long xor fill
+                // 0b10000000 c 0b11cccccc v
+                fill(word & 0x3fff, read_byte());
+            }
+        }
+    }
+}
+
+} // namespace nr::dune2::io
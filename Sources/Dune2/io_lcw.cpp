@@ -1,23 +1,32 @@
 #include "io.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
 
 namespace nr::dune2::io {
 
 std::vector<uint8_t>
 readLCWData(std::istream &input, size_t deflated_size, size_t inflated_size) {
+    trace::Span span("decode.lcw");
+
     std::vector<uint8_t> dst;
 
     dst.reserve(inflated_size);
 
     const auto read_byte = [&]() { return io::readLEInteger<1, uint8_t>(input); };
     const auto read_word = [&]() { return io::readLEInteger<2, uint16_t>(input); };
-    const auto copy_block = [&](auto count, auto pos, bool relative) {
-        std::copy_n(
-            relative
-                ? dst.end() - pos
-                : dst.begin() + pos,
-            count,
-            std::back_inserter(dst)
-        );
+    const auto &kernels = simd::getKernels();
+    const auto copy_block = [&](size_t count, size_t pos, bool relative) {
+        const auto size = dst.size();
+        const auto distance = relative ? pos : size - pos;
+        if (distance == 0 || distance > size) {
+            throw std::invalid_argument("corrupted data");
+        }
+        dst.resize(size + count);
+        kernels.overlapCopy(dst.data() + size, distance, count);
     };
 
     // Ignore first byte if it is the relative mode flag
@@ -72,4 +81,101 @@ readLCWData(std::istream &input, size_t deflated_size, size_t inflated_size) {
 
     return dst;
 }
+
+std::vector<uint8_t>
+encodeLCWData(const uint8_t *data, size_t size) {
+    // Greedy encoder: a hash of the next three bytes gives the last position
+    // they were seen at. Copies never overlap their destination and long
+    // copies use absolute positions, so sources must start in the first 64KiB.
+    constexpr size_t HashBits = 16;
+    constexpr size_t NoPosition = SIZE_MAX;
+    constexpr size_t MaxLiteralCount = 63;
+    constexpr size_t MinRunLength = 8;
+
+    std::vector<uint8_t> dst;
+    std::vector<size_t> head(size_t(1) << HashBits, NoPosition);
+
+    dst.reserve(size + size/63 + 16);
+
+    const auto hash = [&](size_t i) {
+        const uint32_t v = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+        return (v*2654435761u) >> (32 - HashBits);
+    };
+    const auto write_word = [&](size_t word) {
+        dst.push_back(uint8_t(word & 0xff));
+        dst.push_back(uint8_t((word >> 8) & 0xff));
+    };
+
+    size_t literal_first = 0;
+    const auto flush_literals = [&](size_t last) {
+        while (literal_first < last) {
+            const auto count = std::min(last - literal_first, MaxLiteralCount);
+            dst.push_back(uint8_t(0x80 | count));
+            dst.insert(dst.end(), data + literal_first, data + literal_first + count);
+            literal_first += count;
+        }
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        size_t run = 1;
+        while (i + run < size && run < 0xffff && data[i + run] == data[i]) {
+            ++run;
+        }
+        if (run >= MinRunLength) {
+            // command 4: repeat value
+            flush_literals(i);
+            dst.push_back(0xfe);
+            write_word(run);
+            dst.push_back(data[i]);
+            i += run;
+            literal_first = i;
+            continue;
+        }
+
+        size_t match_pos = NoPosition;
+        size_t match_len = 0;
+        if (i + 3 <= size) {
+            const auto h = hash(i);
+            const auto pos = head[h];
+            head[h] = i;
+            if (pos != NoPosition && pos <= 0xffff) {
+                const auto max_len = std::min({size - i, i - pos, size_t(0xffff)});
+                while (match_len < max_len && data[pos + match_len] == data[i + match_len]) {
+                    ++match_len;
+                }
+                match_pos = pos;
+            }
+        }
+        if (match_len < 3) {
+            ++i;
+            continue;
+        }
+
+        flush_literals(i);
+        const auto distance = i - match_pos;
+        if (match_len <= 10 && distance <= 0xfff) {
+            // command 2: existing block relative copy
+            dst.push_back(uint8_t(((match_len - 3) << 4) | (distance >> 8)));
+            dst.push_back(uint8_t(distance & 0xff));
+        } else if (match_len <= 64) {
+            // command 3: existing block medium-length copy
+            dst.push_back(uint8_t(0xc0 | (match_len - 3)));
+            write_word(match_pos);
+        } else {
+            // command 5: existing block long copy
+            dst.push_back(0xff);
+            write_word(match_len);
+            write_word(match_pos);
+        }
+        i += match_len;
+        literal_first = i;
+    }
+    flush_literals(size);
+
+    // command 1 with a null count marks the end of the data.
+    dst.push_back(0x80);
+
+    return dst;
+}
 }
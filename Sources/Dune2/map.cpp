@@ -0,0 +1,137 @@
+#include "map.hpp"
+#include "io.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace nr::dune2 {
+
+using rapidjson::Document;
+using rapidjson::Value;
+
+Map::Surface::Surface(
+    const Map &map,
+    const IconSet &icons,
+    const ImageSet &images
+)
+    : map_{&map} {
+    if (icons.getGroupCount() <= IconSet::LandscapeGroup) {
+        throw std::invalid_argument("icon set has no landscape group");
+    }
+
+    // Landscape icons are made of a single tile, resolve them once.
+    const auto offset = icons.getGroupOffset(IconSet::LandscapeGroup);
+    const auto count = icons.getGroupSize(IconSet::LandscapeGroup);
+    for (auto i = offset; i < offset + count; ++i) {
+        const auto tiles = icons.getIcon(i).getTileIndexList();
+        landscape_.push_back(&images.getImage(tiles.at(0)));
+    }
+
+    if (landscape_.empty()) {
+        throw std::invalid_argument("icon set has no landscape group");
+    }
+    tileWidth_ = landscape_.front()->getWidth();
+    tileHeight_ = landscape_.front()->getHeight();
+    if (tileWidth_ == 0 || tileHeight_ == 0) {
+        throw std::invalid_argument("invalid landscape tiles");
+    }
+}
+
+std::size_t
+Map::Surface::getWidth() const {
+    return Width*tileWidth_;
+}
+
+std::size_t
+Map::Surface::getHeight() const {
+    return Height*tileHeight_;
+}
+
+std::size_t
+Map::Surface::getPixel(std::size_t x, std::size_t y) const {
+    const auto icon = map_->getIcon(x/tileWidth_, y/tileHeight_);
+    return landscape_.at(icon)->getPixel(x%tileWidth_, y%tileHeight_);
+}
+
+Map::Minimap::Minimap(const Map &map, std::vector<std::uint8_t> lut)
+    : map_{&map}
+    , lut_{std::move(lut)} {
+    const auto icon = *std::max_element(map.data(), map.data() + Width*Height);
+    if (icon >= lut_.size()) {
+        throw std::invalid_argument("map icon out of table");
+    }
+}
+
+std::size_t
+Map::Minimap::getWidth() const {
+    return Width;
+}
+
+std::size_t
+Map::Minimap::getHeight() const {
+    return Height;
+}
+
+std::size_t
+Map::Minimap::getPixel(std::size_t x, std::size_t y) const {
+    return lut_[map_->data()[y*Width + x]];
+}
+
+void
+Map::loadFromJSON(const Value &value) {
+    const auto &icons_value = value.FindMember("icons")->value;
+
+    if (value.FindMember("width")->value.GetUint() != Width
+            || value.FindMember("height")->value.GetUint() != Height
+            || icons_value.Size() != cells_.size()) {
+        throw std::invalid_argument("invalid map size");
+    }
+
+    std::transform(
+        icons_value.Begin(),
+        icons_value.End(),
+        cells_.begin(),
+        [](const auto &icon_value) {
+            return static_cast<IconIndex>(icon_value.GetUint());
+        }
+    );
+    seed_ = value.FindMember("seed")->value.GetUint();
+}
+
+void
+Map::loadFromJSON(const std::filesystem::path &json_path) {
+    std::ifstream input(json_path);
+    loadFromJSON(io::loadJSON(input));
+}
+
+Value
+Map::toJSON(Document::AllocatorType &allocator) const {
+    trace::Span span("json.build");
+
+    Value icons(rapidjson::kArrayType);
+    icons.Reserve(cells_.size(), allocator);
+    for (auto icon: cells_) {
+        icons.PushBack(Value((unsigned int)icon), allocator);
+    }
+
+    Value value(rapidjson::kObjectType);
+    value.AddMember("seed", Value((unsigned int)seed_), allocator);
+    value.AddMember("width", Value((unsigned int)Width), allocator);
+    value.AddMember("height", Value((unsigned int)Height), allocator);
+    value.AddMember("icons", icons, allocator);
+
+    return value;
+}
+
+Document
+Map::toJSON() const {
+    Document doc;
+    auto value = toJSON(doc.GetAllocator());
+    doc.Swap(value);
+    return doc;
+}
+
+} // namespace nr::dune2
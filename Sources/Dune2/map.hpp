@@ -0,0 +1,169 @@
+#pragma once
+
+#include <Dune2/icon_set.hpp>
+#include <Dune2/image_set.hpp>
+#include <Dune2/surface.hpp>
+
+#include <rapidjson/document.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class nr::dune2::Map
+/// A 64x64 cells Dune2 landscape. Each cell holds the index of an icon in the
+/// landscape group of `ICON.MAP` (see `nr::dune2::IconSet::LandscapeGroup`):
+/// - `0` - sand,
+/// - `1..16` - rock,
+/// - `17..32` - dunes,
+/// - `33..48` - mountains,
+/// - `49..64` - spice,
+/// - `65..80` - thick spice.
+///
+/// For the border icons the index minus the first icon of the kind is a mask
+/// of the neighbours of the same kind: `1` up, `2` right, `4` down and `8`
+/// left.
+class Map {
+public:
+    using IconIndex = std::uint16_t;
+
+    static constexpr std::size_t Width = 64;
+    static constexpr std::size_t Height = 64;
+
+    /// ### class `nr::dune2::Map::Surface`
+    /// A surface on a map rendered with the landscape icons of an `IconSet`.
+    /// The map, the icon set and the image set must outlive the surface.
+    class Surface : public nr::dune2::Surface {
+    public:
+        /// ### constructor `nr::dune2::Map::Surface`
+        /// Throw `std::invalid_argument` if the icon set has no landscape
+        /// group.
+        /// #### Parameters
+        /// - `const Map &map` - the map
+        /// - `const IconSet &icons` - icons loaded from `ICON.MAP`
+        /// - `const ImageSet &images` - images loaded from `ICON.ICN`
+        Surface(const Map &, const IconSet &, const ImageSet &);
+
+    public:
+        /// ### method `nr::dune2::Map::Surface.getWidth`
+        /// See [`nr::dune2::Surface.getWidth`](/docs/nr/dune2/surface#getWidth)
+        /// for more details.
+        virtual std::size_t getWidth() const override;
+
+        /// ### method `nr::dune2::Map::Surface.getHeight`
+        /// See [`nr::dune2::Surface.getHeight`](/docs/nr/dune2/surface#getHeight)
+        /// for more details.
+        virtual std::size_t getHeight() const override;
+
+        /// ### method `nr::dune2::Map::Surface.getPixel`
+        /// See [`nr::dune2::Surface.getPixel`](/docs/nr/dune2/surface#getPixel)
+        /// for more details.
+        virtual std::size_t getPixel(std::size_t, std::size_t) const override;
+
+    private:
+        const Map *map_;
+        std::vector<const Image *> landscape_;
+        std::size_t tileWidth_;
+        std::size_t tileHeight_;
+    };
+
+    /// ### class `nr::dune2::Map::Minimap`
+    /// A surface on a map rendered one pixel per cell, the color of a cell
+    /// being looked up in a table of a color index per landscape icon (see
+    /// `nr::dune2::createLandscapeLUT`). The map must outlive the surface.
+    class Minimap : public nr::dune2::Surface {
+    public:
+        /// ### constructor `nr::dune2::Map::Minimap`
+        /// Throw `std::invalid_argument` if the map uses an icon past the end
+        /// of the table.
+        /// #### Parameters
+        /// - `const Map &map` - the map
+        /// - `std::vector<std::uint8_t> lut` - a color index per landscape
+        ///   icon
+        Minimap(const Map &, std::vector<std::uint8_t> lut);
+
+    public:
+        /// ### method `nr::dune2::Map::Minimap.getWidth`
+        /// See [`nr::dune2::Surface.getWidth`](/docs/nr/dune2/surface#getWidth)
+        /// for more details.
+        virtual std::size_t getWidth() const override;
+
+        /// ### method `nr::dune2::Map::Minimap.getHeight`
+        /// See [`nr::dune2::Surface.getHeight`](/docs/nr/dune2/surface#getHeight)
+        /// for more details.
+        virtual std::size_t getHeight() const override;
+
+        /// ### method `nr::dune2::Map::Minimap.getPixel`
+        /// See [`nr::dune2::Surface.getPixel`](/docs/nr/dune2/surface#getPixel)
+        /// for more details.
+        virtual std::size_t getPixel(std::size_t, std::size_t) const override;
+
+    private:
+        const Map *map_;
+        std::vector<std::uint8_t> lut_;
+    };
+
+public:
+    /// ### method `nr::dune2::Map.generate`
+    /// Generate the landscape the same way the game does for a scenario
+    /// given its `MapSeed`. The same seed always produces the same map.
+    /// #### Parameters
+    /// - `std::uint32_t seed` - the map seed
+    void generate(std::uint32_t seed);
+
+    /// ### method `nr::dune2::Map.loadFromJSON`
+    /// Load a map from the given _JSON_ value.
+    /// #### Parameters
+    /// - `const rapidjson::Value &` - a _JSON_ value as produced by `toJSON`
+    void loadFromJSON(const rapidjson::Value &);
+
+    /// ### method `nr::dune2::Map.loadFromJSON`
+    /// Load a map from the given _JSON_ file.
+    /// #### Parameters
+    /// - `const std::filesystem::path &` - a path to `*.json` file
+    void loadFromJSON(const std::filesystem::path &);
+
+public:
+    /// ### method `nr::dune2::Map.toJSON`
+    /// Transform this map to a _JSON_ value.
+    /// #### Parameters
+    /// - `rapidjson::Document::AllocatorType &` - the document allocator
+    /// #### Return
+    /// `rapidjson::Value` - a json value
+    rapidjson::Value toJSON(rapidjson::Document::AllocatorType &) const;
+
+    /// ### method `nr::dune2::Map.toJSON`
+    /// Transform this map to a _JSON_ document
+    /// #### Return
+    /// `rapidjson::Document` - a json document
+    rapidjson::Document toJSON() const;
+
+public:
+    /// ### method `nr::dune2::Map.getSeed`
+    /// #### Return
+    /// `std::uint32_t` - the seed this map was generated from.
+    std::uint32_t getSeed() const
+    { return seed_; }
+
+    /// ### method `nr::dune2::Map.getIcon`
+    /// #### Parameters
+    /// - `std::size_t x` - the cell column
+    /// - `std::size_t y` - the cell row
+    /// #### Return
+    /// `IconIndex` - the index of the icon of the cell in the landscape group.
+    IconIndex getIcon(std::size_t x, std::size_t y) const
+    { return cells_.at(y*Width + x); }
+
+    /// ### method `nr::dune2::Map.data`
+    /// #### Return
+    /// `const IconIndex *` - the cells, row by row.
+    const IconIndex *data() const
+    { return cells_.data(); }
+
+private:
+    std::uint32_t seed_{0};
+    std::array<IconIndex, Width*Height> cells_{};
+};
+} // namespace nr::dune2
@@ -0,0 +1,395 @@
+#include "map.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace nr::dune2 {
+
+namespace {
+
+constexpr std::size_t CellCount = Map::Width*Map::Height;
+
+// Landscape types used while the map is being generated.
+enum Landscape : std::uint8_t {
+    NormalSand = 0,
+    EntirelyDune = 2,
+    EntirelyRock = 4,
+    EntirelyMountain = 6,
+    Spice = 8,
+    ThickSpice = 9,
+};
+
+using LandscapeGrid = std::array<std::uint16_t, CellCount>;
+
+// The game pseudo random number generator.
+class Random {
+public:
+    explicit Random(std::uint32_t seed)
+        : state_{
+            static_cast<std::uint8_t>(seed >>  0),
+            static_cast<std::uint8_t>(seed >>  8),
+            static_cast<std::uint8_t>(seed >> 16),
+        } {
+    }
+
+    std::uint8_t next() {
+        std::uint16_t val16 = (state_[1] << 8) | state_[2];
+        std::uint8_t val8 = ((val16 ^ 0x8000) >> 15) & 1;
+
+        val16 = (val16 << 1) | ((state_[0] >> 1) & 1);
+        val8 = (state_[0] >> 2) - state_[0] - val8;
+
+        state_[0] = (val8 << 7) | (state_[0] >> 1);
+        state_[1] = val16 >> 8;
+        state_[2] = val16 & 0xFF;
+
+        return state_[0] ^ state_[1];
+    }
+
+private:
+    std::array<std::uint8_t, 3> state_;
+};
+
+// Positions are packed the way the game does: 6 bits for x, 6 bits for y.
+constexpr std::uint16_t
+pack(std::uint16_t x, std::uint16_t y) {
+    return (y << 6) | x;
+}
+
+bool
+can_become_spice(std::uint16_t landscape) {
+    switch (landscape) {
+    case NormalSand:
+    case EntirelyDune:
+    case Spice:
+    case ThickSpice:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Unit vectors for the 256 orientations of the game, scaled by 127, as
+// stored in the game executable.
+constexpr std::array<std::int16_t, 256> step_x{
+       0,    3,    6,    9,   12,   15,   18,   21,   24,   27,   30,   33,   36,   39,   42,   45,
+      48,   51,   54,   57,   59,   62,   65,   67,   70,   73,   75,   78,   80,   82,   85,   87,
+      89,   91,   94,   96,   98,  100,  102,  103,  105,  107,  108,  110,  112,  113,  114,  116,
+     117,  118,  119,  120,  121,  122,  123,  123,  124,  125,  125,  126,  126,  126,  126,  126,
+     127,  126,  126,  126,  126,  126,  125,  125,  124,  123,  123,  122,  121,  120,  119,  118,
+     117,  116,  114,  113,  112,  110,  108,  107,  105,  103,  102,  100,   98,   96,   94,   91,
+      89,   87,   85,   82,   80,   78,   75,   73,   70,   67,   65,   62,   59,   57,   54,   51,
+      48,   45,   42,   39,   36,   33,   30,   27,   24,   21,   18,   15,   12,    9,    6,    3,
+       0,   -3,   -6,   -9,  -12,  -15,  -18,  -21,  -24,  -27,  -30,  -33,  -36,  -39,  -42,  -45,
+     -48,  -51,  -54,  -57,  -59,  -62,  -65,  -67,  -70,  -73,  -75,  -78,  -80,  -82,  -85,  -87,
+     -89,  -91,  -94,  -96,  -98, -100, -102, -103, -105, -107, -108, -110, -112, -113, -114, -116,
+    -117, -118, -119, -120, -121, -122, -123, -123, -124, -125, -125, -126, -126, -126, -126, -126,
+    -127, -126, -126, -126, -126, -126, -125, -125, -124, -123, -123, -122, -121, -120, -119, -118,
+    -117, -116, -114, -113, -112, -110, -108, -107, -105, -103, -102, -100,  -98,  -96,  -94,  -91,
+     -89,  -87,  -85,  -82,  -80,  -78,  -75,  -73,  -70,  -67,  -65,  -62,  -59,  -57,  -54,  -51,
+     -48,  -45,  -42,  -39,  -36,  -33,  -30,  -27,  -24,  -21,  -18,  -15,  -12,   -9,   -6,   -3,
+};
+
+constexpr std::array<std::int16_t, 256> step_y{
+     127,  126,  126,  126,  126,  126,  125,  125,  124,  123,  123,  122,  121,  120,  119,  118,
+     117,  116,  114,  113,  112,  110,  108,  107,  105,  103,  102,  100,   98,   96,   94,   91,
+      89,   87,   85,   82,   80,   78,   75,   73,   70,   67,   65,   62,   59,   57,   54,   51,
+      48,   45,   42,   39,   36,   33,   30,   27,   24,   21,   18,   15,   12,    9,    6,    3,
+       0,   -3,   -6,   -9,  -12,  -15,  -18,  -21,  -24,  -27,  -30,  -33,  -36,  -39,  -42,  -45,
+     -48,  -51,  -54,  -57,  -59,  -62,  -65,  -67,  -70,  -73,  -75,  -78,  -80,  -82,  -85,  -87,
+     -89,  -91,  -94,  -96,  -98, -100, -102, -103, -105, -107, -108, -110, -112, -113, -114, -116,
+    -117, -118, -119, -120, -121, -122, -123, -123, -124, -125, -125, -126, -126, -126, -126, -126,
+    -127, -126, -126, -126, -126, -126, -125, -125, -124, -123, -123, -122, -121, -120, -119, -118,
+    -117, -116, -114, -113, -112, -110, -108, -107, -105, -103, -102, -100,  -98,  -96,  -94,  -91,
+     -89,  -87,  -85,  -82,  -80,  -78,  -75,  -73,  -70,  -67,  -65,  -62,  -59,  -57,  -54,  -51,
+     -48,  -45,  -42,  -39,  -36,  -33,  -30,  -27,  -24,  -21,  -18,  -15,  -12,   -9,   -6,   -3,
+       0,    3,    6,    9,   12,   15,   18,   21,   24,   27,   30,   33,   36,   39,   42,   45,
+      48,   51,   54,   57,   59,   62,   65,   67,   70,   73,   75,   78,   80,   82,   85,   87,
+      89,   91,   94,   96,   98,  100,  102,  103,  105,  107,  108,  110,  112,  113,  114,  116,
+     117,  118,  119,  120,  121,  122,  123,  123,  124,  125,  125,  126,  126,  126,  126,  126,
+};
+
+// Move a cell of a random distance in a random orientation. Positions are
+// expressed in 1/256th of cell.
+std::uint16_t
+move_by_random(Random &random, std::uint16_t packed, std::uint16_t distance) {
+    if (distance == 0) {
+        return packed;
+    }
+
+    std::uint16_t new_distance = random.next();
+    while (new_distance > distance) {
+        new_distance /= 2;
+    }
+    distance = new_distance;
+
+    const auto orientation = random.next();
+    const std::uint16_t x = ((packed & 0x3F) << 8) | 0x80;
+    const std::uint16_t y = ((packed >> 6) << 8) | 0x80;
+    const std::uint16_t new_x = x + ((step_x[orientation]*distance)/128)*16;
+    const std::uint16_t new_y = y - ((step_y[orientation]*distance)/128)*16;
+
+    if (new_x > Map::Width*256 || new_y > Map::Height*256) {
+        return packed;
+    }
+    return pack((new_x >> 8) & 0x3F, (new_y >> 8) & 0x3F);
+}
+
+void
+add_spice(LandscapeGrid &grid, std::uint16_t packed) {
+    auto &landscape = grid[packed];
+
+    switch (landscape) {
+    case Spice:
+        landscape = ThickSpice;
+        add_spice(grid, packed);
+        break;
+
+    case ThickSpice: {
+        // Thick spice spreads spice around it, it falls back to spice when
+        // one of its neighbours can not hold spice.
+        // Neighbours are packed the way the game does, without clamping: a
+        // negative coordinate or a row past the bottom gives a position out
+        // of the map, but a column past the right edge sets the low bit of
+        // the row, landing on the first column of that row or the next one.
+        const int x = packed & 0x3F;
+        const int y = packed >> 6;
+        for (auto j = y - 1; j <= y + 1; ++j) {
+            for (auto i = x - 1; i <= x + 1; ++i) {
+                const auto neighbour_packed = pack(std::uint16_t(i), std::uint16_t(j));
+                if ((neighbour_packed & 0xF000) != 0) {
+                    continue;
+                }
+
+                auto &neighbour = grid[neighbour_packed];
+                if (!can_become_spice(neighbour)) {
+                    landscape = Spice;
+                    continue;
+                }
+                if (neighbour != ThickSpice) {
+                    neighbour = Spice;
+                }
+            }
+        }
+        break;
+    }
+
+    default:
+        if (can_become_spice(landscape)) {
+            landscape = Spice;
+        }
+        break;
+    }
+}
+
+// Spread random values on a coarse 16x16 grid (one value every 4 cells) then
+// fill the cells between them with the average of their neighbours.
+void
+generate_heights(Random &random, LandscapeGrid &grid) {
+    static constexpr std::array<std::int16_t, 21> around{
+        0, -1, 1, -16, 16, -17, 17, -15, 15, -2, 2, -32, 32, -4, 4, -64, 64, -30, 30, -34, 34
+    };
+
+    static constexpr std::int8_t offsets[2][21][4] = {
+        {
+            {0, 0, 4, 0}, {4, 0, 4, 4}, {0, 0, 0, 4}, {0, 4, 4, 4}, {0, 0, 0, 2},
+            {0, 2, 0, 4}, {0, 0, 2, 0}, {2, 0, 4, 0}, {4, 0, 4, 2}, {4, 2, 4, 4},
+            {0, 4, 2, 4}, {2, 4, 4, 4}, {0, 0, 4, 4}, {2, 0, 2, 2}, {0, 0, 2, 2},
+            {4, 0, 2, 2}, {0, 2, 2, 2}, {2, 2, 4, 2}, {2, 2, 0, 4}, {2, 2, 4, 4},
+            {2, 2, 2, 4},
+        },
+        {
+            {0, 0, 4, 0}, {4, 0, 4, 4}, {0, 0, 0, 4}, {0, 4, 4, 4}, {0, 0, 0, 2},
+            {0, 2, 0, 4}, {0, 0, 2, 0}, {2, 0, 4, 0}, {4, 0, 4, 2}, {4, 2, 4, 4},
+            {0, 4, 2, 4}, {2, 4, 4, 4}, {4, 0, 0, 4}, {2, 0, 2, 2}, {0, 0, 2, 2},
+            {4, 0, 2, 2}, {0, 2, 2, 2}, {2, 2, 4, 2}, {2, 2, 0, 4}, {2, 2, 4, 4},
+            {2, 2, 2, 4},
+        },
+    };
+
+    constexpr std::size_t memory_size = 272;
+    std::array<std::uint8_t, memory_size + 1> memory{};
+
+    for (auto i = 0u; i < memory_size; ++i) {
+        memory[i] = std::min(random.next() & 0x0F, 0x0A);
+    }
+
+    const auto spread = [&](unsigned count, auto &&value) {
+        while (count-- != 0) {
+            const int base = random.next();
+            for (auto offset: around) {
+                const auto index = std::clamp<int>(base + offset, 0, memory_size);
+                memory[index] = value(memory[index]);
+            }
+        }
+    };
+
+    spread((random.next() & 0x0F) + 1, [&](std::uint8_t v) {
+        return (v + (random.next() & 0x0F)) & 0x0F;
+    });
+    spread((random.next() & 0x03) + 1, [&](std::uint8_t) {
+        return random.next() & 0x03;
+    });
+
+    for (auto j = 0u; j < 16; ++j) {
+        for (auto i = 0u; i < 16; ++i) {
+            grid[pack(i*4, j*4)] = memory[j*16 + i];
+        }
+    }
+
+    for (auto j = 0u; j < 16; ++j) {
+        for (auto i = 0u; i < 16; ++i) {
+            for (const auto &offset: offsets[(i + 1) % 2]) {
+                const auto x1 = i*4 + offset[0], y1 = j*4 + offset[1];
+                const auto x2 = i*4 + offset[2], y2 = j*4 + offset[3];
+                const std::uint16_t packed = (pack(x1, y1) + pack(x2, y2))/2;
+
+                if (packed >= CellCount) {
+                    continue;
+                }
+
+                const auto packed1 = pack(x1 & 0x3F, y1);
+                const auto packed2 = pack(x2 & 0x3F, y2);
+                const auto value1 = packed1 < CellCount ? grid[packed1] : 0;
+                const auto value2 = packed2 < CellCount ? grid[packed2] : 0;
+
+                grid[packed] = (value1 + value2 + 1)/2;
+            }
+        }
+    }
+}
+
+// Average each cell with its 8 neighbours. Out of map neighbours are
+// replaced by the cell itself.
+void
+smooth_heights(LandscapeGrid &grid) {
+    const auto source = grid;
+
+    for (auto y = 0u; y < Map::Height; ++y) {
+        const auto *row = source.data() + y*Map::Width;
+        const auto *up = y > 0 ? row - Map::Width : nullptr;
+        const auto *down = y + 1 < Map::Height ? row + Map::Width : nullptr;
+
+        for (auto x = 0u; x < Map::Width; ++x) {
+            const auto center = row[x];
+            const auto has_left = x > 0;
+            const auto has_right = x + 1 < Map::Width;
+
+            unsigned total = center;
+            total += has_left ? row[x - 1] : center;
+            total += has_right ? row[x + 1] : center;
+            total += up && has_left ? up[x - 1] : center;
+            total += up ? up[x] : center;
+            total += up && has_right ? up[x + 1] : center;
+            total += down && has_left ? down[x - 1] : center;
+            total += down ? down[x] : center;
+            total += down && has_right ? down[x + 1] : center;
+
+            grid[y*Map::Width + x] = total/9;
+        }
+    }
+}
+
+// Turn heights into landscape types, the two thresholds are random.
+void
+classify_heights(Random &random, LandscapeGrid &grid) {
+    const std::uint16_t rock = std::clamp(random.next() & 0x0F, 0x08, 0x0C);
+    std::uint16_t dune = (random.next() & 0x03) - 1;
+    dune = std::min<std::uint16_t>(dune, rock - 3);
+
+    std::transform(grid.begin(), grid.end(), grid.begin(), [=](auto height) {
+        if (height > rock + 4) return EntirelyMountain;
+        if (height >= rock) return EntirelyRock;
+        if (height <= dune) return EntirelyDune;
+        return NormalSand;
+    });
+}
+
+void
+add_spice_fields(Random &random, LandscapeGrid &grid) {
+    // The game loops forever on maps without any cell able to hold spice.
+    if (std::none_of(grid.begin(), grid.end(), can_become_spice)) {
+        return;
+    }
+
+    auto fields = random.next() & 0x2F;
+    while (fields-- != 0) {
+        std::uint16_t center;
+        do {
+            const auto y = random.next() & 0x3F;
+            const auto x = random.next() & 0x3F;
+            center = pack(x, y);
+        } while (!can_become_spice(grid[center]));
+
+        auto count = random.next() & 0x1F;
+        while (count-- != 0) {
+            const auto distance = random.next() & 0x3F;
+            add_spice(grid, move_by_random(random, center, distance));
+        }
+    }
+}
+
+// Select the landscape icon of each cell given its neighbours.
+Map::IconIndex
+landscape_icon(
+    std::uint16_t current,
+    std::uint16_t up,
+    std::uint16_t right,
+    std::uint16_t down,
+    std::uint16_t left
+) {
+    const auto mask = [&](std::uint16_t landscape) {
+        return (up == landscape ? 1 : 0)
+             | (right == landscape ? 2 : 0)
+             | (down == landscape ? 4 : 0)
+             | (left == landscape ? 8 : 0);
+    };
+
+    switch (current) {
+    case EntirelyRock:
+        return 1 + (mask(EntirelyRock) | mask(EntirelyMountain));
+    case EntirelyDune:
+        return 17 + mask(EntirelyDune);
+    case EntirelyMountain:
+        return 33 + mask(EntirelyMountain);
+    case Spice:
+        return 49 + (mask(Spice) | mask(ThickSpice));
+    case ThickSpice:
+        return 65 + mask(ThickSpice);
+    default:
+        return 0;
+    }
+}
+} // namespace
+
+void
+Map::generate(std::uint32_t seed) {
+    trace::Span span("map.generate");
+
+    Random random(seed);
+    LandscapeGrid grid{};
+
+    generate_heights(random, grid);
+    smooth_heights(grid);
+    classify_heights(random, grid);
+    add_spice_fields(random, grid);
+
+    for (auto y = 0u; y < Height; ++y) {
+        for (auto x = 0u; x < Width; ++x) {
+            const auto current = grid[pack(x, y)];
+            cells_[y*Width + x] = landscape_icon(
+                current,
+                y > 0 ? grid[pack(x, y - 1)] : current,
+                x + 1 < Width ? grid[pack(x + 1, y)] : current,
+                y + 1 < Height ? grid[pack(x, y + 1)] : current,
+                x > 0 ? grid[pack(x - 1, y)] : current
+            );
+        }
+    }
+
+    seed_ = seed;
+}
+
+} // namespace nr::dune2
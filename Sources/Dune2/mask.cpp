@@ -0,0 +1,195 @@
+#include "mask.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr size_t WordBits = 64;
+
+constexpr size_t
+words_per_row(size_t width) {
+    return (width + WordBits - 1)/WordBits;
+}
+
+// Return the 64 bits of a row starting at the given bit, bits past the end of
+// the row are 0.
+std::uint64_t
+read_bits(const std::uint64_t *row, size_t word_count, size_t bit) {
+    const auto index = bit/WordBits;
+    const auto shift = bit%WordBits;
+
+    const auto lo = index < word_count ? row[index] : 0;
+    if (shift == 0) {
+        return lo;
+    }
+    const auto hi = index + 1 < word_count ? row[index + 1] : 0;
+    return (lo >> shift) | (hi << (WordBits - shift));
+}
+} // namespace
+
+Mask::Mask()
+    : width_{0}
+    , height_{0}
+    , left_{0}
+    , top_{0}
+    , boxWidth_{0}
+    , boxHeight_{0}
+    , wordsPerRow_{0} {
+}
+
+Mask::Mask(const Image &image)
+    : Mask() {
+    trace::Span span("mask.create");
+
+    width_ = image.getWidth();
+    height_ = image.getHeight();
+
+    // Only the data box of a trimmed image is stored, pixels outside of it
+    // are transparent.
+    const auto data = reinterpret_cast<const std::uint8_t *>(image.getData().data());
+    const auto data_width = image.getDataWidth();
+    const auto data_height = image.getDataHeight();
+
+    // Bounding box of the opaque pixels in the data box
+    auto x_min = data_width, x_max = size_t{0};
+    auto y_min = data_height, y_max = size_t{0};
+    for (auto y = 0u; y < data_height; ++y) {
+        const auto row = data + y*data_width;
+        const auto first = std::find_if(row, row + data_width, [](auto c) { return c != 0; });
+        if (first == row + data_width) {
+            continue;
+        }
+        const auto last = std::find_if(
+            std::make_reverse_iterator(row + data_width),
+            std::make_reverse_iterator(first),
+            [](auto c) { return c != 0; }
+        ).base();
+        x_min = std::min(x_min, size_t(first - row));
+        x_max = std::max(x_max, size_t(last - row));
+        y_min = std::min(y_min, size_t(y));
+        y_max = y + 1;
+    }
+    if (y_min >= y_max) {
+        return;
+    }
+
+    left_ = image.getLeft() + x_min;
+    top_ = image.getTop() + y_min;
+    boxWidth_ = x_max - x_min;
+    boxHeight_ = y_max - y_min;
+    wordsPerRow_ = words_per_row(boxWidth_);
+    words_.assign(wordsPerRow_*boxHeight_, 0);
+
+    for (auto y = 0u; y < boxHeight_; ++y) {
+        const auto row = data + (y_min + y)*data_width + x_min;
+        const auto bits = words_.data() + y*wordsPerRow_;
+        for (auto x = 0u; x < boxWidth_; ++x) {
+            if (row[x] != 0) {
+                bits[x/WordBits] |= std::uint64_t{1} << (x%WordBits);
+            }
+        }
+    }
+}
+
+Mask::Mask(
+    size_t width, size_t height,
+    size_t left, size_t top,
+    size_t box_width, size_t box_height,
+    std::vector<std::uint64_t> words
+)
+    : width_{width}
+    , height_{height}
+    , left_{left}
+    , top_{top}
+    , boxWidth_{box_width}
+    , boxHeight_{box_height}
+    , wordsPerRow_{words_per_row(box_width)}
+    , words_{std::move(words)} {
+    if (left_ + boxWidth_ > width_
+            || top_ + boxHeight_ > height_
+            || words_.size() != wordsPerRow_*boxHeight_) {
+        throw std::invalid_argument("corrupted data");
+    }
+
+    // Clear the bits past the box width so that they never match.
+    const auto tail = boxWidth_%WordBits;
+    if (tail != 0) {
+        for (auto y = 0u; y < boxHeight_; ++y) {
+            words_[(y + 1)*wordsPerRow_ - 1] &= (std::uint64_t{1} << tail) - 1;
+        }
+    }
+}
+
+size_t
+Mask::getPixelCount() const {
+    size_t count = 0;
+    for (auto word: words_) {
+        count += __builtin_popcountll(word);
+    }
+    return count;
+}
+
+bool
+Mask::test(std::ptrdiff_t x, std::ptrdiff_t y) const {
+    x -= left_;
+    y -= top_;
+    if (x < 0 || y < 0 || size_t(x) >= boxWidth_ || size_t(y) >= boxHeight_) {
+        return false;
+    }
+    const auto word = words_[y*wordsPerRow_ + x/WordBits];
+    return (word >> (x%WordBits)) & 1;
+}
+
+// Call fn(bits) with the AND of the two masks rows for each 64 pixels of
+// their intersection, until fn returns false.
+template <typename F>
+void
+Mask::forEachOverlap(const Mask &other, std::ptrdiff_t dx, std::ptrdiff_t dy, F &&fn) const {
+    const auto ax = std::ptrdiff_t(left_);
+    const auto ay = std::ptrdiff_t(top_);
+    const auto bx = dx + std::ptrdiff_t(other.left_);
+    const auto by = dy + std::ptrdiff_t(other.top_);
+
+    const auto x0 = std::max(ax, bx);
+    const auto x1 = std::min(ax + std::ptrdiff_t(boxWidth_), bx + std::ptrdiff_t(other.boxWidth_));
+    const auto y0 = std::max(ay, by);
+    const auto y1 = std::min(ay + std::ptrdiff_t(boxHeight_), by + std::ptrdiff_t(other.boxHeight_));
+
+    for (auto y = y0; y < y1; ++y) {
+        const auto row_a = words_.data() + (y - ay)*wordsPerRow_;
+        const auto row_b = other.words_.data() + (y - by)*other.wordsPerRow_;
+        // Past the end of the intersection one of the two rows is 0.
+        for (auto x = x0; x < x1; x += WordBits) {
+            const auto bits = read_bits(row_a, wordsPerRow_, x - ax)
+                & read_bits(row_b, other.wordsPerRow_, x - bx);
+            if (!fn(bits)) {
+                return;
+            }
+        }
+    }
+}
+
+bool
+Mask::intersects(const Mask &other, std::ptrdiff_t dx, std::ptrdiff_t dy) const {
+    bool overlap = false;
+    forEachOverlap(other, dx, dy, [&](std::uint64_t bits) {
+        overlap = bits != 0;
+        return !overlap;
+    });
+    return overlap;
+}
+
+size_t
+Mask::getOverlapCount(const Mask &other, std::ptrdiff_t dx, std::ptrdiff_t dy) const {
+    size_t count = 0;
+    forEachOverlap(other, dx, dy, [&](std::uint64_t bits) {
+        count += __builtin_popcountll(bits);
+        return true;
+    });
+    return count;
+}
+
+} // namespace nr::dune2
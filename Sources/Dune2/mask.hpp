@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Dune2/image.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::Mask`
+/// The opacity mask of an image, one bit per pixel, the color `0` being
+/// transparent. Only the bounding box of the opaque pixels is stored, each
+/// of its rows packed in 64 bits words, the leftmost pixel in the least
+/// significant bit. Bits past the box width are `0`.
+///
+/// Coordinates are relative to the top left corner of the image, not of the
+/// bounding box.
+class Mask {
+public:
+    Mask();
+
+    /// ### constructor `nr::dune2::Mask`
+    /// Compute the mask of an image.
+    /// #### Parameters
+    /// - `const Image &image` - an image
+    explicit Mask(const Image &);
+
+    /// ### constructor `nr::dune2::Mask`
+    /// Build a mask from its words, as returned by `getWords`. Throw
+    /// `std::invalid_argument` if the box does not fit in the image or if the
+    /// number of words does not match the box size.
+    /// #### Parameters
+    /// - `size_t width` - the image width
+    /// - `size_t height` - the image height
+    /// - `size_t left` - the bounding box left column
+    /// - `size_t top` - the bounding box top row
+    /// - `size_t box_width` - the bounding box width
+    /// - `size_t box_height` - the bounding box height
+    /// - `std::vector<std::uint64_t> words` - the packed rows
+    Mask(
+        size_t width, size_t height,
+        size_t left, size_t top,
+        size_t box_width, size_t box_height,
+        std::vector<std::uint64_t> words
+    );
+
+public:
+    size_t getWidth() const
+    { return width_; }
+
+    size_t getHeight() const
+    { return height_; }
+
+    size_t getLeft() const
+    { return left_; }
+
+    size_t getTop() const
+    { return top_; }
+
+    size_t getBoxWidth() const
+    { return boxWidth_; }
+
+    size_t getBoxHeight() const
+    { return boxHeight_; }
+
+    /// ### method `nr::dune2::Mask.getWordsPerRow`
+    /// #### Return
+    /// `size_t` - the number of words of a bounding box row.
+    size_t getWordsPerRow() const
+    { return wordsPerRow_; }
+
+    /// ### method `nr::dune2::Mask.getWords`
+    /// #### Return
+    /// `const std::vector<std::uint64_t> &` - the bounding box rows, from top
+    /// to bottom.
+    const std::vector<std::uint64_t> &getWords() const
+    { return words_; }
+
+    /// ### method `nr::dune2::Mask.getPixelCount`
+    /// #### Return
+    /// `size_t` - the number of opaque pixels.
+    size_t getPixelCount() const;
+
+public:
+    /// ### method `nr::dune2::Mask.test`
+    /// #### Parameters
+    /// - `std::ptrdiff_t x` - a column
+    /// - `std::ptrdiff_t y` - a row
+    /// #### Return
+    /// `bool` - `true` if the pixel is opaque, `false` if it is transparent
+    /// or outside of the image.
+    bool test(std::ptrdiff_t x, std::ptrdiff_t y) const;
+
+    /// ### method `nr::dune2::Mask.intersects`
+    /// Test if two masks have an opaque pixel in common, the other mask
+    /// being moved by _(dx, dy)_ relatively to this one.
+    /// #### Parameters
+    /// - `const Mask &other` - another mask
+    /// - `std::ptrdiff_t dx` - the other mask horizontal offset
+    /// - `std::ptrdiff_t dy` - the other mask vertical offset
+    /// #### Return
+    /// `bool` - `true` if the masks overlap.
+    bool intersects(const Mask &, std::ptrdiff_t dx, std::ptrdiff_t dy) const;
+
+    /// ### method `nr::dune2::Mask.getOverlapCount`
+    /// Like `intersects` but count the opaque pixels in common.
+    /// #### Return
+    /// `size_t` - the number of pixels opaque in both masks.
+    size_t getOverlapCount(const Mask &, std::ptrdiff_t dx, std::ptrdiff_t dy) const;
+
+private:
+    template <typename F>
+    void forEachOverlap(const Mask &, std::ptrdiff_t dx, std::ptrdiff_t dy, F &&) const;
+
+private:
+    size_t width_;
+    size_t height_;
+    size_t left_;
+    size_t top_;
+    size_t boxWidth_;
+    size_t boxHeight_;
+    size_t wordsPerRow_;
+    std::vector<std::uint64_t> words_;
+};
+} // namespace nr::dune2
@@ -0,0 +1,275 @@
+#include "memory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#if defined(DUNE2_MEMORY_STATS) && defined(__GLIBC__)
+#include <malloc.h>
+#define NR_MEMORY_USABLE_SIZE(p) malloc_usable_size(p)
+#endif
+
+namespace nr::dune2::memory {
+
+namespace detail {
+std::atomic<bool> enabled{false};
+} // namespace detail
+
+namespace {
+// Counters are constant initialized so that they can be used by allocations
+// made before main.
+struct Counter {
+    std::atomic<std::size_t> allocationCount{0};
+    std::atomic<std::size_t> allocatedBytes{0};
+};
+
+constexpr std::size_t MaxSubsystemCount = 64;
+
+std::array<Counter, MaxSubsystemCount> counters;
+std::atomic<std::size_t> heap_bytes{0};
+std::atomic<std::size_t> peak_heap_bytes{0};
+
+// Index of the active subsystem of the current thread, 0 is 'other'.
+thread_local std::size_t current_subsystem{0};
+
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, std::size_t, std::less<>> indexes{{"other", 0}};
+    std::vector<std::string> names{"other"};
+};
+
+Registry &
+registry() {
+    static Registry registry;
+    return registry;
+}
+
+std::size_t
+subsystem_index(std::string_view name) {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    if (const auto it = reg.indexes.find(name); it != reg.indexes.end()) {
+        return it->second;
+    }
+    if (reg.names.size() == MaxSubsystemCount) {
+        return 0;
+    }
+    const auto index = reg.names.size();
+    reg.names.emplace_back(name);
+    reg.indexes.emplace(name, index);
+    return index;
+}
+
+#if defined(DUNE2_MEMORY_STATS)
+void
+account_allocation(void *p, std::size_t size) {
+    if (!isEnabled()) {
+        return;
+    }
+    auto &counter = counters[current_subsystem];
+    counter.allocationCount.fetch_add(1, std::memory_order_relaxed);
+    counter.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+#if defined(NR_MEMORY_USABLE_SIZE)
+    const auto bytes = heap_bytes.fetch_add(NR_MEMORY_USABLE_SIZE(p), std::memory_order_relaxed)
+        + NR_MEMORY_USABLE_SIZE(p);
+    auto peak = peak_heap_bytes.load(std::memory_order_relaxed);
+    while (bytes > peak && !peak_heap_bytes.compare_exchange_weak(peak, bytes)) {
+    }
+#endif
+}
+
+void
+account_deallocation(void *p) {
+#if defined(NR_MEMORY_USABLE_SIZE)
+    if (p == nullptr || !isEnabled()) {
+        return;
+    }
+    // Blocks allocated before accounting was enabled are not counted, do not
+    // let the counter wrap around.
+    const auto size = NR_MEMORY_USABLE_SIZE(p);
+    auto bytes = heap_bytes.load(std::memory_order_relaxed);
+    while (!heap_bytes.compare_exchange_weak(bytes, bytes - std::min(bytes, size))) {
+    }
+#endif
+}
+
+void *
+allocate(std::size_t size) {
+    if (const auto p = std::malloc(size == 0 ? 1 : size)) {
+        account_allocation(p, size);
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void
+deallocate(void *p) noexcept {
+    account_deallocation(p);
+    std::free(p);
+}
+#endif
+} // namespace
+
+bool
+isAccountingAvailable() {
+#if defined(DUNE2_MEMORY_STATS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+enable() {
+    registry();
+    detail::enabled = true;
+}
+
+std::size_t
+getPeakRSS() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss)*1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+Report
+getReport() {
+    Report report{isAccountingAvailable() && isEnabled(), {}, 0, getPeakRSS()};
+
+    if (report.accounting) {
+        auto &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (std::size_t i = 0; i < reg.names.size(); ++i) {
+            const auto count = counters[i].allocationCount.load();
+            if (count > 0) {
+                report.subsystems.push_back(Subsystem{
+                    reg.names[i],
+                    count,
+                    counters[i].allocatedBytes.load()
+                });
+            }
+        }
+        std::sort(
+            report.subsystems.begin(),
+            report.subsystems.end(),
+            [](const auto &a, const auto &b) { return a.allocatedBytes > b.allocatedBytes; }
+        );
+        report.peakHeapBytes = peak_heap_bytes.load();
+    }
+
+    return report;
+}
+
+rapidjson::Document
+Report::toJSON() const {
+    using rapidjson::Value;
+
+    rapidjson::Document doc;
+    auto &allocator = doc.GetAllocator();
+
+    const auto size = [](std::size_t value) {
+        return Value(static_cast<uint64_t>(value));
+    };
+
+    Value items(rapidjson::kArrayType);
+    for (const auto &subsystem: subsystems) {
+        Value value(rapidjson::kObjectType);
+        value.AddMember(
+            "name",
+            Value().SetString(subsystem.name.c_str(), allocator),
+            allocator
+        );
+        value.AddMember("allocations", size(subsystem.allocationCount), allocator);
+        value.AddMember("bytes", size(subsystem.allocatedBytes), allocator);
+        items.PushBack(value, allocator);
+    }
+
+    doc.SetObject();
+    doc.AddMember("accounting", Value(accounting), allocator);
+    doc.AddMember("subsystems", items, allocator);
+    doc.AddMember("peakHeapBytes", size(peakHeapBytes), allocator);
+    doc.AddMember("peakRSS", size(peakRSS), allocator);
+
+    return doc;
+}
+
+Scope::Scope(std::string_view subsystem)
+    : previous_{current_subsystem} {
+    current_subsystem = subsystem_index(subsystem);
+}
+
+Scope::~Scope() {
+    current_subsystem = previous_;
+}
+
+} // namespace nr::dune2::memory
+
+#if defined(DUNE2_MEMORY_STATS)
+// Replace the global allocation functions, the aligned ones are left to the
+// standard library.
+void *
+operator new(std::size_t size) {
+    return nr::dune2::memory::allocate(size);
+}
+
+void *
+operator new[](std::size_t size) {
+    return nr::dune2::memory::allocate(size);
+}
+
+void *
+operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return nr::dune2::memory::allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *
+operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return nr::dune2::memory::allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void
+operator delete(void *p) noexcept {
+    nr::dune2::memory::deallocate(p);
+}
+
+void
+operator delete[](void *p) noexcept {
+    nr::dune2::memory::deallocate(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept {
+    nr::dune2::memory::deallocate(p);
+}
+
+void
+operator delete[](void *p, std::size_t) noexcept {
+    nr::dune2::memory::deallocate(p);
+}
+#endif
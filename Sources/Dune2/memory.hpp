@@ -0,0 +1,103 @@
+#pragma once
+
+#include <rapidjson/document.h>
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nr::dune2::memory {
+/// ### struct `nr::dune2::memory::Subsystem`
+/// The allocations made while a subsystem was active on the allocating
+/// thread.
+struct Subsystem {
+    std::string name;
+    std::size_t allocationCount;
+    std::size_t allocatedBytes;
+};
+
+/// ### struct `nr::dune2::memory::Report`
+/// A summary of the memory used by the process.
+struct Report {
+    /// #### attribute `accounting`
+    /// `true` if allocations were counted, see `isAccountingAvailable`.
+    bool accounting;
+
+    /// #### attribute `subsystems`
+    /// The allocations per subsystem, sorted by decreasing allocated bytes.
+    /// Allocations made outside any subsystem are reported as `other`.
+    std::vector<Subsystem> subsystems;
+
+    /// #### attribute `peakHeapBytes`
+    /// The peak of heap bytes in use since accounting was enabled, `0` when
+    /// unknown.
+    std::size_t peakHeapBytes;
+
+    /// #### attribute `peakRSS`
+    /// The peak resident set size of the process in bytes, `0` when unknown.
+    std::size_t peakRSS;
+
+    /// ### method `nr::dune2::memory::Report.toJSON`
+    /// Transform this report to a _JSON_ document.
+    /// #### Return
+    /// `rapidjson::Document` - a json document
+    rapidjson::Document toJSON() const;
+};
+
+/// ### function `nr::dune2::memory::isAccountingAvailable`
+/// Allocations are only counted when the library is built with the
+/// `MEMORY_STATS` option, which replaces the global allocation functions.
+/// #### Return
+/// `bool` - `true` if allocations can be counted.
+bool isAccountingAvailable();
+
+/// ### function `nr::dune2::memory::enable`
+/// Start counting allocations.
+void enable();
+
+/// ### function `nr::dune2::memory::isEnabled`
+/// #### Return
+/// `bool` - `true` if allocations are counted.
+bool isEnabled();
+
+/// ### function `nr::dune2::memory::getPeakRSS`
+/// #### Return
+/// `std::size_t` - the peak resident set size of the process in bytes, `0`
+/// when unknown.
+std::size_t getPeakRSS();
+
+/// ### function `nr::dune2::memory::getReport`
+/// #### Return
+/// `Report` - the memory used so far.
+Report getReport();
+
+/// ### class `nr::dune2::memory::Scope`
+/// Attribute the allocations made by the current thread to the given
+/// subsystem for the lifetime of the scope. Scopes can be nested.
+class Scope {
+public:
+    /// ### constructor `nr::dune2::memory::Scope`
+    /// #### Parameters
+    /// - `std::string_view subsystem` - the subsystem name
+    explicit Scope(std::string_view subsystem);
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+    ~Scope();
+
+private:
+    std::size_t previous_;
+};
+
+namespace detail {
+extern std::atomic<bool> enabled;
+} // namespace detail
+
+inline bool
+isEnabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+} // namespace nr::dune2::memory
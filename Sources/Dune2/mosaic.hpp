@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Dune2/surface.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::Mosaic`
+/// A surface made of surfaces of the same size laid out in a grid, row by
+/// row. The surfaces must outlive the mosaic. Unused cells of the last row are
+/// filled with the color `0`.
+class Mosaic : public Surface {
+public:
+    /// ### constructor `nr::dune2::Mosaic`
+    /// #### Parameters
+    /// - `size_t columns` - the number of surfaces on a row of the mosaic
+    explicit Mosaic(size_t columns)
+        : columns_{columns} {
+        if (columns_ == 0) {
+            throw std::invalid_argument("mosaic must have at least one column");
+        }
+    }
+
+public:
+    /// ### method `nr::dune2::Mosaic.push_back`
+    /// Append a surface. All surfaces must have the same size.
+    /// #### Parameters
+    /// - `const Surface &surface` - a surface
+    void push_back(const Surface &surface) {
+        if (!surfaces_.empty()
+                && (surface.getWidth() != cellWidth_ || surface.getHeight() != cellHeight_)) {
+            throw std::invalid_argument("mosaic surfaces must have the same size");
+        }
+        cellWidth_ = surface.getWidth();
+        cellHeight_ = surface.getHeight();
+        surfaces_.push_back(&surface);
+    }
+
+public:
+    /// ### method `nr::dune2::Mosaic.getWidth`
+    /// See [`nr::dune2::Surface.getWidth`](/docs/nr/dune2/surface#getWidth)
+    /// for more details.
+    virtual size_t getWidth() const override
+    { return std::min(columns_, surfaces_.size())*cellWidth_; }
+
+    /// ### method `nr::dune2::Mosaic.getHeight`
+    /// See [`nr::dune2::Surface.getHeight`](/docs/nr/dune2/surface#getHeight)
+    /// for more details.
+    virtual size_t getHeight() const override
+    { return ((surfaces_.size() + columns_ - 1)/columns_)*cellHeight_; }
+
+    /// ### method `nr::dune2::Mosaic.getPixel`
+    /// See [`nr::dune2::Surface.getPixel`](/docs/nr/dune2/surface#getPixel)
+    /// for more details.
+    virtual size_t getPixel(size_t x, size_t y) const override {
+        const auto index = (y/cellHeight_)*columns_ + x/cellWidth_;
+        if (index >= surfaces_.size()) {
+            return 0;
+        }
+        return surfaces_[index]->getPixel(x%cellWidth_, y%cellHeight_);
+    }
+
+private:
+    size_t columns_;
+    size_t cellWidth_{0};
+    size_t cellHeight_{0};
+    std::vector<const Surface *> surfaces_;
+};
+} // namespace nr::dune2
@@ -1,8 +1,11 @@
 #include "pak.hpp"
 #include "io.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <istream>
+#include <stdexcept>
 #include <utility>
 
 namespace fs = std::filesystem;
@@ -43,7 +46,11 @@ PAK::load(const fs::path &filepath) {
     std::ifstream input;
 
     input.open(filepath, std::ios::binary);
+    load(input, filepath);
+}
 
+void
+PAK::load(std::istream &input, const fs::path &filepath) {
     std::vector<PAKRawEntry> raw_entries;
     std::copy(
         std::istream_iterator<PAKRawEntry>(input),
@@ -51,6 +58,10 @@ PAK::load(const fs::path &filepath) {
         std::back_inserter(raw_entries)
     );
 
+    if (raw_entries.empty()) {
+        throw std::invalid_argument("corrupted file");
+    }
+
     std::transform(
         std::begin(raw_entries),
         std::end(raw_entries) - 1,
@@ -87,6 +98,20 @@ PAK::cend() const {
     return end();
 }
 
+PAK::const_iterator
+PAK::find(const std::string &name) const {
+    const auto iequal = [](unsigned char a, unsigned char b) {
+        return std::toupper(a) == std::toupper(b);
+    };
+    return std::find_if(begin(), end(), [&](const Entry &entry) {
+        return std::equal(
+            entry.name.begin(), entry.name.end(),
+            name.begin(), name.end(),
+            iequal
+        );
+    });
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // PAK::Entry
 
@@ -20,6 +20,14 @@ public:
 public:
     void load(const std::filesystem::path &);
 
+    /// ### method `nr::dune2::PAK.load`
+    /// Read the entries of a PAK file from a stream holding its content.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    /// - `const std::filesystem::path &filepath` - the path of the PAK file,
+    ///   the entries read their data from it
+    void load(std::istream &, const std::filesystem::path &);
+
 public:
     using const_iterator = std::vector<Entry>::const_iterator;
 
@@ -29,6 +37,14 @@ public:
     const_iterator cbegin() const;
     const_iterator cend() const;
 
+    /// ### method `nr::dune2::PAK.find`
+    /// Find an entry by name. Names are compared case insensitively.
+    /// #### Parameters
+    /// - `const std::string &name` - the entry name
+    /// #### Return
+    /// `const_iterator` - an iterator on the entry or `end()`.
+    const_iterator find(const std::string &) const;
+
 private:
     std::vector<Entry> entries_;
 };
@@ -18,6 +18,11 @@ Palette::loadFromPAL(const fs::path &filepath) {
     input.exceptions(std::ifstream::failbit);
     input.open(filepath, std::ios::binary);
 
+    loadFromPAL(input);
+}
+
+void
+Palette::loadFromPAL(std::istream &input) {
     std::generate(
         colors_.begin(),
         colors_.end(),
@@ -73,6 +78,23 @@ Palette::toJSON() const {
     return doc;
 }
 
+size_t
+Palette::findNearestColor(const Color &color) const {
+    size_t nearest = 0;
+    auto nearest_distance = std::numeric_limits<int>::max();
+    for (auto i = 0u; i < colors_.size(); ++i) {
+        const auto dr = int(colors_[i].red) - int(color.red);
+        const auto dg = int(colors_[i].green) - int(color.green);
+        const auto db = int(colors_[i].blue) - int(color.blue);
+        const auto distance = dr*dr + dg*dg + db*db;
+        if (distance < nearest_distance) {
+            nearest = i;
+            nearest_distance = distance;
+        }
+    }
+    return nearest;
+}
+
 BMP 
 Palette::toBMP() const {
     const auto color_per_row = 8;
@@ -3,6 +3,7 @@
 #include <rapidjson/document.h>
 
 #include <filesystem>
+#include <istream>
 #include <limits>
 #include <vector>
 
@@ -23,6 +24,7 @@ public:
 
 public:
     void loadFromPAL(const std::filesystem::path &);
+    void loadFromPAL(std::istream &);
     void loadFromJSON(const std::filesystem::path &);
 
 public:
@@ -45,6 +47,14 @@ public:
     Color &operator[](size_t index)
     { return at(index); }
 
+    /// ### method `nr::dune2::Palette.findNearestColor`
+    /// #### Parameters
+    /// - `const Color &color` - a color
+    /// #### Return
+    /// `size_t` - the index of the palette color the nearest to the given
+    /// color, the lowest one on ties.
+    size_t findNearestColor(const Color &) const;
+
 public:
     using iterator = std::vector<Color>::iterator;
     using const_iterator = std::vector<Color>::const_iterator;
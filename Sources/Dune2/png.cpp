@@ -0,0 +1,156 @@
+#include "png.hpp"
+#include "trace.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr std::array<char, 8> png_signature{'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n'};
+
+void
+append_u32(std::string &output, std::uint32_t value) {
+    output.push_back(char(value >> 24));
+    output.push_back(char(value >> 16));
+    output.push_back(char(value >> 8));
+    output.push_back(char(value));
+}
+
+// Append a chunk, its length, type, data and CRC of type and data.
+void
+append_chunk(std::string &output, const char *type, const std::string &data) {
+    append_u32(output, data.size());
+    const auto offset = output.size();
+    output.append(type, 4);
+    output.append(data);
+    const auto crc = crc32(
+        0,
+        reinterpret_cast<const Bytef *>(output.data() + offset),
+        output.size() - offset
+    );
+    append_u32(output, crc);
+}
+
+std::string
+deflate_data(const std::string &input, int level) {
+    z_stream stream{};
+    if (deflateInit(&stream, level) != Z_OK) {
+        throw std::runtime_error("deflateInit failed");
+    }
+
+    std::string output(deflateBound(&stream, input.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream.avail_in = input.size();
+    stream.next_out = reinterpret_cast<Bytef *>(output.data());
+    stream.avail_out = output.size();
+
+    const auto status = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END) {
+        throw std::runtime_error("deflate failed");
+    }
+    return output;
+}
+} // namespace
+
+PNG::PNG(size_t width, size_t height)
+    : width_{width}
+    , height_{height}
+    , pixels_(width*height, 0) {
+    if (width == 0 || height == 0
+            || width > std::numeric_limits<std::int32_t>::max()
+            || height > std::numeric_limits<std::int32_t>::max()) {
+        throw std::invalid_argument("invalid png size");
+    }
+}
+
+void
+PNG::drawSurface(size_t x, size_t y, const Surface &surface) {
+    trace::Span span("png.draw");
+
+    if (x >= width_ || y >= height_) {
+        return;
+    }
+    const auto w = std::min(surface.getWidth(), width_ - x);
+    const auto h = std::min(surface.getHeight(), height_ - y);
+    for (auto sy = 0u; sy < h; ++sy) {
+        auto out = pixels_.data() + (y + sy)*width_ + x;
+        for (auto sx = 0u; sx < w; ++sx) {
+            out[sx] = surface.getPixel(sx, sy);
+        }
+    }
+}
+
+std::string
+PNG::encode(const Palette &palette, const Options &options) const {
+    trace::Span span("png.encode");
+
+    if (options.level < 0 || options.level > 9) {
+        throw std::invalid_argument("invalid deflate level");
+    }
+
+    std::string png(png_signature.data(), png_signature.size());
+
+    std::string header;
+    append_u32(header, width_);
+    append_u32(header, height_);
+    header.push_back(8);    // bit depth
+    header.push_back(3);    // color type, indexed
+    header.push_back(0);    // compression method
+    header.push_back(0);    // filter method
+    header.push_back(0);    // interlace method
+    append_chunk(png, "IHDR", header);
+
+    // Decoders reject indexes past the end of the palette.
+    const size_t color_count = *std::max_element(pixels_.begin(), pixels_.end()) + 1;
+    std::string colors;
+    for (auto i = 0u; i < color_count; ++i) {
+        const auto color = i < palette.size() ? palette[i] : Palette::Color{};
+        colors.push_back(char(color.red));
+        colors.push_back(char(color.green));
+        colors.push_back(char(color.blue));
+    }
+    append_chunk(png, "PLTE", colors);
+
+    // Colors past the end of the transparency table are opaque.
+    if (options.transparent) {
+        append_chunk(png, "tRNS", std::string(1, '\0'));
+    }
+
+    // Rows are not filtered, the filters predict color intensities which
+    // indexes do not follow.
+    std::string filtered;
+    filtered.reserve((width_ + 1)*height_);
+    for (auto y = 0u; y < height_; ++y) {
+        filtered.push_back(0);
+        filtered.append(reinterpret_cast<const char *>(pixels_.data() + y*width_), width_);
+    }
+    append_chunk(png, "IDAT", deflate_data(filtered, options.level));
+    append_chunk(png, "IEND", std::string());
+
+    return png;
+}
+
+void
+PNG::store(std::ostream &output, const Palette &palette, const Options &options) const {
+    const auto data = encode(palette, options);
+
+    trace::Span span("png.write");
+    output.write(data.data(), data.size());
+}
+
+void
+PNG::store(const std::filesystem::path &filepath, const Palette &palette, const Options &options) const {
+    std::ofstream output(filepath, std::ofstream::binary);
+    store(output, palette, options);
+}
+
+} // namespace nr::dune2
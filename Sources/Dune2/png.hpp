@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Dune2/palette.hpp>
+#include <Dune2/surface.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::PNG`
+/// An 8 bits indexed image written as a palette _PNG_. Pixels are color
+/// indexes, the palette is only given when the image is encoded.
+class PNG {
+public:
+    /// ### struct `nr::dune2::PNG::Options`
+    /// - `level` - the deflate level from `0` (store) to `9` (best),
+    /// - `transparent` - `true` to make the color `0` transparent.
+    struct Options {
+        int level{6};
+        bool transparent{false};
+    };
+
+public:
+    PNG(size_t width, size_t height);
+
+public:
+    size_t width() const { return width_; }
+    size_t height() const { return height_; }
+
+public:
+    /// ### method `nr::dune2::PNG.drawSurface`
+    /// Copy the color indexes of a surface, clipped to the image.
+    /// #### Parameters
+    /// - `size_t x` - the column of the surface left side
+    /// - `size_t y` - the row of the surface top side
+    /// - `const Surface &surface` - the surface
+    void drawSurface(size_t x, size_t y, const Surface &);
+
+public:
+    /// ### method `nr::dune2::PNG.encode`
+    /// Rows are deflated at once without filtering, which compresses color
+    /// indexes better than the filters. The `PLTE` chunk only holds the
+    /// colors up to the highest index used.
+    /// #### Parameters
+    /// - `const Palette &palette` - the palette
+    /// - `const Options &options` - the encoding options
+    /// #### Return
+    /// `std::string` - the _PNG_ file data.
+    std::string encode(const Palette &, const Options &) const;
+
+    /// ### method `nr::dune2::PNG.store`
+    /// Write the image on the given output stream.
+    /// #### Parameters
+    /// - `std::ostream &output` - an output stream
+    /// - `const Palette &palette` - the palette
+    /// - `const Options &options` - the encoding options
+    void store(std::ostream &, const Palette &, const Options &) const;
+
+    /// ### method `nr::dune2::PNG.store`
+    /// Write the image to the given file.
+    /// #### Parameters
+    /// - `const std::filesystem::path &filepath` - a path to a `*.png` file
+    /// - `const Palette &palette` - the palette
+    /// - `const Options &options` - the encoding options
+    void store(const std::filesystem::path &, const Palette &, const Options &) const;
+
+private:
+    size_t width_;
+    size_t height_;
+    std::vector<std::uint8_t> pixels_;
+};
+} // namespace nr::dune2
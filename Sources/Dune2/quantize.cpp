@@ -0,0 +1,199 @@
+#include "quantize.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr size_t cube_size = 64;
+
+constexpr std::array<const char *, 3> dither_names{
+    "none",
+    "floyd-steinberg",
+    "ordered",
+};
+
+// 8x8 Bayer matrix, values in [0, 64).
+constexpr std::array<std::array<int, 8>, 8> bayer_matrix{{
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+}};
+
+std::uint8_t
+clamp_channel(int value) {
+    return std::uint8_t(std::clamp(value, 0, 255));
+}
+} // namespace
+
+ColorCube::ColorCube(const Palette &palette, size_t first_color)
+    : palette_{palette}
+    , cells_(cube_size*cube_size*cube_size, 0) {
+    trace::Span span("quantize.cube");
+
+    if (first_color >= palette.size()) {
+        throw std::invalid_argument("invalid first color");
+    }
+
+    // Distances are computed on doubled coordinates so that the cell
+    // centers, at 4*k + 1.5, are integers.
+    struct Candidate {
+        int distance;
+        std::uint8_t index;
+        int blue;
+    };
+    std::vector<Candidate> candidates(palette.size() - first_color);
+
+    for (auto r = 0u; r < cube_size; ++r) {
+        for (auto g = 0u; g < cube_size; ++g) {
+            const auto red = int(8*r + 3);
+            const auto green = int(8*g + 3);
+            for (auto i = first_color; i < palette.size(); ++i) {
+                const auto dr = 2*int(palette[i].red) - red;
+                const auto dg = 2*int(palette[i].green) - green;
+                candidates[i - first_color] = Candidate{
+                    dr*dr + dg*dg,
+                    std::uint8_t(i),
+                    2*int(palette[i].blue)
+                };
+            }
+
+            // With the candidates sorted by their red and green distance,
+            // the search of a cell stops at the first candidate too far
+            // whatever its blue.
+            std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+                return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+            });
+
+            const auto column = cells_.data() + (r*cube_size + g)*cube_size;
+            for (auto b = 0u; b < cube_size; ++b) {
+                const auto blue = int(8*b + 3);
+                auto nearest = candidates.front().index;
+                auto nearest_distance = std::numeric_limits<int>::max();
+                for (const auto &candidate: candidates) {
+                    if (candidate.distance > nearest_distance) {
+                        break;
+                    }
+                    const auto db = candidate.blue - blue;
+                    const auto distance = candidate.distance + db*db;
+                    if (distance < nearest_distance
+                            || (distance == nearest_distance && candidate.index < nearest)) {
+                        nearest = candidate.index;
+                        nearest_distance = distance;
+                    }
+                }
+                column[b] = nearest;
+            }
+        }
+    }
+}
+
+const char *
+getDitherName(Dither dither) {
+    return dither_names.at(static_cast<size_t>(dither));
+}
+
+std::optional<Dither>
+findDither(const std::string &name) {
+    const auto it = std::find(dither_names.begin(), dither_names.end(), name);
+    if (it == dither_names.end()) {
+        return std::nullopt;
+    }
+    return static_cast<Dither>(it - dither_names.begin());
+}
+
+Image
+quantizeImage(const RGBImage &image, const ColorCube &cube, Dither dither, bool transparent) {
+    trace::Span span("quantize.image");
+
+    const auto width = image.getWidth();
+    const auto height = image.getHeight();
+    const auto &palette = cube.getPalette();
+    const auto is_transparent = [&](const RGBImage::Pixel &pixel) {
+        return transparent && pixel.alpha < 128;
+    };
+
+    std::string data(width*height, '\0');
+
+    switch (dither) {
+    case Dither::None:
+        for (auto y = 0u; y < height; ++y) {
+            for (auto x = 0u; x < width; ++x) {
+                const auto &pixel = image.at(x, y);
+                if (!is_transparent(pixel)) {
+                    data[y*width + x] = char(cube.find(pixel.red, pixel.green, pixel.blue));
+                }
+            }
+        }
+        break;
+
+    case Dither::Ordered:
+        for (auto y = 0u; y < height; ++y) {
+            for (auto x = 0u; x < width; ++x) {
+                const auto &pixel = image.at(x, y);
+                if (is_transparent(pixel)) {
+                    continue;
+                }
+                const auto offset = (2*bayer_matrix[y%8][x%8] - 63)/4;
+                data[y*width + x] = char(cube.find(
+                    clamp_channel(pixel.red + offset),
+                    clamp_channel(pixel.green + offset),
+                    clamp_channel(pixel.blue + offset)
+                ));
+            }
+        }
+        break;
+
+    case Dither::FloydSteinberg: {
+        // Errors of the current and the next rows in 1/16th, one column of
+        // margin on each side.
+        using Errors = std::vector<std::array<int, 3>>;
+        Errors current(width + 2), next(width + 2);
+        for (auto y = 0u; y < height; ++y) {
+            std::fill(next.begin(), next.end(), std::array<int, 3>{});
+            for (auto x = 0u; x < width; ++x) {
+                const auto &pixel = image.at(x, y);
+                if (is_transparent(pixel)) {
+                    continue;
+                }
+                const auto &error = current[x + 1];
+                const std::array<int, 3> value{
+                    clamp_channel(pixel.red + error[0]/16),
+                    clamp_channel(pixel.green + error[1]/16),
+                    clamp_channel(pixel.blue + error[2]/16),
+                };
+                const auto index = cube.find(value[0], value[1], value[2]);
+                data[y*width + x] = char(index);
+
+                const auto &color = palette[index];
+                const std::array<int, 3> diff{
+                    value[0] - color.red,
+                    value[1] - color.green,
+                    value[2] - color.blue,
+                };
+                for (auto c = 0u; c < 3; ++c) {
+                    current[x + 2][c] += 7*diff[c];
+                    next[x][c] += 3*diff[c];
+                    next[x + 1][c] += 5*diff[c];
+                    next[x + 2][c] += diff[c];
+                }
+            }
+            std::swap(current, next);
+        }
+        break;
+    }
+    }
+
+    return Image(width, height, std::move(data));
+}
+
+} // namespace nr::dune2
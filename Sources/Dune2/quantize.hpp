@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Dune2/image.hpp>
+#include <Dune2/palette.hpp>
+#include <Dune2/rgb_image.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::ColorCube`
+/// A lookup table giving the nearest palette color of any true color.
+/// Channels are reduced to 6 bits, the precision of the game palettes, so
+/// the cube has _64×64×64_ cells, each holding the palette color nearest to
+/// its center. The cube is built once per palette, then a lookup is a single
+/// memory access instead of a search through the palette.
+class ColorCube {
+public:
+    /// ### constructor `nr::dune2::ColorCube`
+    /// #### Parameters
+    /// - `const Palette &palette` - the palette
+    /// - `size_t first_color` - the first palette color which can be
+    ///   returned, `1` to keep the transparent color `0` out of the cube
+    explicit ColorCube(const Palette &, size_t first_color = 0);
+
+public:
+    /// ### method `nr::dune2::ColorCube.find`
+    /// #### Parameters
+    /// - `std::uint8_t red` - the red channel
+    /// - `std::uint8_t green` - the green channel
+    /// - `std::uint8_t blue` - the blue channel
+    /// #### Return
+    /// `std::uint8_t` - the index of the nearest palette color.
+    std::uint8_t find(std::uint8_t red, std::uint8_t green, std::uint8_t blue) const
+    { return cells_[(red >> 2) << 12 | (green >> 2) << 6 | (blue >> 2)]; }
+
+    /// ### method `nr::dune2::ColorCube.getPalette`
+    /// #### Return
+    /// `const Palette &` - the palette of the cube.
+    const Palette &getPalette() const
+    { return palette_; }
+
+private:
+    Palette palette_;
+    std::vector<std::uint8_t> cells_;
+};
+
+/// ### enum `nr::dune2::Dither`
+/// - `None` - each pixel gets its nearest color,
+/// - `FloydSteinberg` - the error of each pixel is spread on its right and
+///   bottom neighbours,
+/// - `Ordered` - a _8×8_ Bayer threshold matrix is added to the pixels before
+///   their lookup.
+enum class Dither {
+    None,
+    FloydSteinberg,
+    Ordered,
+};
+
+/// ### function `nr::dune2::getDitherName`
+/// #### Return
+/// `const char *` - the name of the given dither.
+const char *getDitherName(Dither);
+
+/// ### function `nr::dune2::findDither`
+/// #### Parameters
+/// - `const std::string &name` - a dither name
+/// #### Return
+/// `std::optional<Dither>` - the dither of the given name if any.
+std::optional<Dither> findDither(const std::string &);
+
+/// ### function `nr::dune2::quantizeImage`
+/// Map a true color image to the colors of a palette.
+/// #### Parameters
+/// - `const RGBImage &image` - the true color image
+/// - `const ColorCube &cube` - the cube of the target palette
+/// - `Dither dither` - the dither
+/// - `bool transparent` - `true` to give the color `0` to the pixels whose
+///   alpha is below `128`, they are left out of the error diffusion
+/// #### Return
+/// `Image` - the indexed image, without remap table.
+Image quantizeImage(
+    const RGBImage &,
+    const ColorCube &,
+    Dither = Dither::None,
+    bool transparent = false
+);
+} // namespace nr::dune2
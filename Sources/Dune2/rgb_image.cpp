@@ -0,0 +1,46 @@
+#include "rgb_image.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+namespace nr::dune2 {
+
+RGBImage::RGBImage()
+    : width_{0}
+    , height_{0} {
+}
+
+RGBImage::RGBImage(size_t width, size_t height)
+    : width_{width}
+    , height_{height}
+    , pixels_(width*height, Pixel{0, 0, 0, 255}) {
+}
+
+void
+RGBImage::load(const fs::path &filepath) {
+    std::ifstream input;
+
+    input.exceptions(std::ifstream::failbit);
+    input.open(filepath, std::ios::binary);
+
+    load(input);
+}
+
+void
+RGBImage::load(std::istream &input) {
+    char signature[2]{0, 0};
+    const auto pos = input.tellg();
+    input.read(signature, 2);
+    input.seekg(pos);
+
+    if (signature[0] == 'B' && signature[1] == 'M') {
+        loadFromBMP(input);
+    } else if (signature[0] == '\x89' && signature[1] == 'P') {
+        loadFromPNG(input);
+    } else {
+        throw std::invalid_argument("corrupted file");
+    }
+}
+
+} // namespace nr::dune2
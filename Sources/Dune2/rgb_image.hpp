@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::RGBImage`
+/// A true color image with an alpha channel, as drawn by tools outside of
+/// the game. It is turned into a palette indexed image with
+/// `nr::dune2::quantizeImage`.
+class RGBImage {
+public:
+    /// ### struct `nr::dune2::RGBImage::Pixel`
+    /// 8 bits channels, an `alpha` of `0` being fully transparent.
+    struct Pixel {
+        std::uint8_t red{0};
+        std::uint8_t green{0};
+        std::uint8_t blue{0};
+        std::uint8_t alpha{255};
+    };
+
+public:
+    RGBImage();
+
+    /// ### constructor `nr::dune2::RGBImage`
+    /// Build an opaque black image.
+    /// #### Parameters
+    /// - `size_t width` - the image width
+    /// - `size_t height` - the image height
+    RGBImage(size_t width, size_t height);
+
+public:
+    /// ### method `nr::dune2::RGBImage.load`
+    /// Load a `.bmp` or a `.png` file, the format is told by the file
+    /// signature.
+    /// #### Parameters
+    /// - `const std::filesystem::path &filepath` - a path to an image file
+    void load(const std::filesystem::path &);
+
+    /// ### method `nr::dune2::RGBImage.load`
+    /// Load a `.bmp` or a `.png` data stream, the format is told by the
+    /// stream signature.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    void load(std::istream &);
+
+    /// ### method `nr::dune2::RGBImage.loadFromBMP`
+    /// Load an uncompressed 1, 4, 8, 16, 24 or 32 bits bitmap. Only 32 bits
+    /// bitmaps with an alpha mask have transparent pixels.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    void loadFromBMP(std::istream &);
+
+    /// ### method `nr::dune2::RGBImage.loadFromPNG`
+    /// Load a _PNG_ of any color type and bit depth, interlaced or not. 16
+    /// bits samples are truncated to 8 bits.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    void loadFromPNG(std::istream &);
+
+public:
+    size_t getWidth() const
+    { return width_; }
+
+    size_t getHeight() const
+    { return height_; }
+
+    const Pixel &at(size_t x, size_t y) const
+    { return pixels_[y*width_ + x]; }
+
+    Pixel &at(size_t x, size_t y)
+    { return pixels_[y*width_ + x]; }
+
+    /// ### method `nr::dune2::RGBImage.getPixels`
+    /// #### Return
+    /// `const std::vector<Pixel> &` - the pixels, row by row from the top.
+    const std::vector<Pixel> &getPixels() const
+    { return pixels_; }
+
+private:
+    size_t width_;
+    size_t height_;
+    std::vector<Pixel> pixels_;
+};
+} // namespace nr::dune2
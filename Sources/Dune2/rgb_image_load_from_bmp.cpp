@@ -0,0 +1,192 @@
+#include "rgb_image.hpp"
+#include "io.hpp"
+#include "trace.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr std::uint32_t bi_rgb = 0;
+constexpr std::uint32_t bi_bitfields = 3;
+
+std::uint32_t
+read_u32(const std::string &data, size_t offset) {
+    if (offset + 4 > data.size()) {
+        throw std::invalid_argument("corrupted file");
+    }
+    return std::uint32_t(std::uint8_t(data[offset]))
+        | std::uint32_t(std::uint8_t(data[offset + 1])) << 8
+        | std::uint32_t(std::uint8_t(data[offset + 2])) << 16
+        | std::uint32_t(std::uint8_t(data[offset + 3])) << 24;
+}
+
+std::uint16_t
+read_u16(const std::string &data, size_t offset) {
+    if (offset + 2 > data.size()) {
+        throw std::invalid_argument("corrupted file");
+    }
+    return std::uint16_t(std::uint8_t(data[offset]))
+        | std::uint16_t(std::uint8_t(data[offset + 1])) << 8;
+}
+
+// Extract the channel selected by a mask of a 16 or 32 bits pixel and scale
+// it to 8 bits.
+struct ChannelMask {
+    explicit ChannelMask(std::uint32_t mask)
+        : mask{mask}
+        , shift{0}
+        , max{0} {
+        if (mask != 0) {
+            while (((mask >> shift) & 1) == 0) {
+                ++shift;
+            }
+            max = mask >> shift;
+        }
+    }
+
+    std::uint8_t operator()(std::uint32_t pixel, std::uint8_t value_if_none) const {
+        if (mask == 0) {
+            return value_if_none;
+        }
+        return std::uint8_t((((pixel & mask) >> shift)*255 + max/2)/max);
+    }
+
+    std::uint32_t mask;
+    unsigned int shift;
+    std::uint32_t max;
+};
+} // namespace
+
+void
+RGBImage::loadFromBMP(std::istream &input) {
+    trace::Span span("bmp.load");
+
+    const auto data = io::readAll(input);
+    if (data.size() < 14 + 40 || data[0] != 'B' || data[1] != 'M') {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    const auto pixels_offset = read_u32(data, 10);
+    const auto header_size = read_u32(data, 14);
+    if (header_size < 40) {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    const auto width = std::int32_t(read_u32(data, 18));
+    const auto height = std::int32_t(read_u32(data, 22));
+    const auto bit_count = read_u16(data, 28);
+    const auto compression = read_u32(data, 30);
+    auto color_count = read_u32(data, 46);
+
+    // Rows are stored bottom-up unless the height is negative.
+    const auto top_down = height < 0;
+    const auto w = size_t(width);
+    const auto h = size_t(std::abs(std::int64_t(height)));
+    if (width <= 0 || h == 0 || w > 0x8000 || h > 0x8000) {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    if (compression != bi_rgb
+            && !(compression == bi_bitfields && (bit_count == 16 || bit_count == 32))) {
+        throw std::invalid_argument("unsupported codec");
+    }
+
+    // Masks follow a 40 bytes header, they are part of larger headers.
+    std::uint32_t red_mask = 0, green_mask = 0, blue_mask = 0, alpha_mask = 0;
+    if (compression == bi_bitfields) {
+        red_mask = read_u32(data, 14 + 40);
+        green_mask = read_u32(data, 14 + 44);
+        blue_mask = read_u32(data, 14 + 48);
+        if (header_size >= 56) {
+            alpha_mask = read_u32(data, 14 + 52);
+        }
+    } else if (bit_count == 16) {
+        red_mask = 0x7c00;
+        green_mask = 0x03e0;
+        blue_mask = 0x001f;
+    } else if (bit_count == 24 || bit_count == 32) {
+        red_mask = 0x00ff0000;
+        green_mask = 0x0000ff00;
+        blue_mask = 0x000000ff;
+    }
+    const ChannelMask red(red_mask), green(green_mask), blue(blue_mask), alpha(alpha_mask);
+
+    std::array<Pixel, 256> colors{};
+    if (bit_count <= 8) {
+        if (bit_count != 1 && bit_count != 4 && bit_count != 8) {
+            throw std::invalid_argument("corrupted file");
+        }
+        if (color_count == 0 || color_count > (1u << bit_count)) {
+            color_count = 1u << bit_count;
+        }
+        const auto colors_offset = 14 + header_size + (compression == bi_bitfields ? 12 : 0);
+        for (auto i = 0u; i < color_count; ++i) {
+            const auto bgrx = read_u32(data, colors_offset + 4*i);
+            colors[i] = Pixel{
+                std::uint8_t(bgrx >> 16),
+                std::uint8_t(bgrx >> 8),
+                std::uint8_t(bgrx),
+                255
+            };
+        }
+    } else if (bit_count != 16 && bit_count != 24 && bit_count != 32) {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    const auto row_size = ((w*bit_count + 31)/32)*4;
+    if (pixels_offset > data.size() || row_size*h > data.size() - pixels_offset) {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    width_ = w;
+    height_ = h;
+    pixels_.assign(w*h, Pixel{});
+
+    for (auto y = 0u; y < h; ++y) {
+        const auto row = reinterpret_cast<const std::uint8_t *>(data.data())
+            + pixels_offset
+            + (top_down ? y : h - 1 - y)*row_size;
+        auto out = pixels_.data() + y*w;
+
+        switch (bit_count) {
+        case 1:
+        case 4:
+        case 8: {
+            const auto per_byte = 8/bit_count;
+            const auto index_mask = (1u << bit_count) - 1;
+            for (auto x = 0u; x < w; ++x) {
+                const auto shift = 8 - bit_count*(x%per_byte + 1);
+                out[x] = colors[(row[x/per_byte] >> shift) & index_mask];
+            }
+            break;
+        }
+        case 24:
+            for (auto x = 0u; x < w; ++x) {
+                out[x] = Pixel{row[3*x + 2], row[3*x + 1], row[3*x], 255};
+            }
+            break;
+        default: {
+            const auto bytes = bit_count/8u;
+            for (auto x = 0u; x < w; ++x) {
+                std::uint32_t pixel = 0;
+                for (auto i = 0u; i < bytes; ++i) {
+                    pixel |= std::uint32_t(row[bytes*x + i]) << (8*i);
+                }
+                out[x] = Pixel{
+                    red(pixel, 0),
+                    green(pixel, 0),
+                    blue(pixel, 0),
+                    alpha(pixel, 255)
+                };
+            }
+            break;
+        }
+        }
+    }
+}
+
+} // namespace nr::dune2
@@ -0,0 +1,335 @@
+#include "rgb_image.hpp"
+#include "io.hpp"
+#include "trace.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr char png_signature[] = "\x89PNG\r\n\x1a\n";
+
+enum ColorType {
+    Gray = 0,
+    RGB = 2,
+    Indexed = 3,
+    GrayAlpha = 4,
+    RGBA = 6,
+};
+
+std::uint32_t
+read_u32(const std::uint8_t *data) {
+    return std::uint32_t(data[0]) << 24
+        | std::uint32_t(data[1]) << 16
+        | std::uint32_t(data[2]) << 8
+        | std::uint32_t(data[3]);
+}
+
+struct Header {
+    size_t width;
+    size_t height;
+    unsigned int bitDepth;
+    unsigned int colorType;
+    bool interlaced;
+
+    size_t getChannelCount() const {
+        switch (colorType) {
+        case RGB:
+            return 3;
+        case GrayAlpha:
+            return 2;
+        case RGBA:
+            return 4;
+        default:
+            return 1;
+        }
+    }
+
+    // Number of bytes of a pixel, at least 1, as used by the filters.
+    size_t getFilterStride() const
+    { return std::max<size_t>(1, getChannelCount()*bitDepth/8); }
+
+    size_t getRowSize(size_t width) const
+    { return (width*getChannelCount()*bitDepth + 7)/8; }
+};
+
+// Adam7 passes: first column, first row, column step and row step.
+constexpr std::array<std::array<size_t, 4>, 7> adam7_passes{{
+    {0, 0, 8, 8},
+    {4, 0, 8, 8},
+    {0, 4, 4, 8},
+    {2, 0, 4, 4},
+    {0, 2, 2, 4},
+    {1, 0, 2, 2},
+    {0, 1, 1, 2},
+}};
+
+std::uint8_t
+paeth(int a, int b, int c) {
+    const auto p = a + b - c;
+    const auto pa = std::abs(p - a);
+    const auto pb = std::abs(p - b);
+    const auto pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+void
+unfilter_row(
+    std::uint8_t filter,
+    std::uint8_t *row,
+    const std::uint8_t *prior,
+    size_t size,
+    size_t stride
+) {
+    switch (filter) {
+    case 0:
+        break;
+    case 1:
+        for (auto i = stride; i < size; ++i) {
+            row[i] += row[i - stride];
+        }
+        break;
+    case 2:
+        for (auto i = 0u; i < size; ++i) {
+            row[i] += prior[i];
+        }
+        break;
+    case 3:
+        for (auto i = 0u; i < size; ++i) {
+            const int a = i >= stride ? row[i - stride] : 0;
+            row[i] += (a + prior[i])/2;
+        }
+        break;
+    case 4:
+        for (auto i = 0u; i < size; ++i) {
+            const int a = i >= stride ? row[i - stride] : 0;
+            const int c = i >= stride ? prior[i - stride] : 0;
+            row[i] += paeth(a, prior[i], c);
+        }
+        break;
+    default:
+        throw std::invalid_argument("corrupted file");
+    }
+}
+
+std::string
+inflate_data(const std::string &deflated, size_t inflated_size) {
+    std::string inflated(inflated_size, '\0');
+
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit(&stream) != Z_OK) {
+        throw std::runtime_error("inflateInit failed");
+    }
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(deflated.data()));
+    stream.avail_in = uInt(deflated.size());
+    stream.next_out = reinterpret_cast<Bytef *>(inflated.data());
+    stream.avail_out = uInt(inflated.size());
+
+    const auto status = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+
+    // Trailing data after the image rows is ignored.
+    if (stream.avail_out != 0 || (status != Z_STREAM_END && status != Z_BUF_ERROR)) {
+        throw std::invalid_argument("corrupted file");
+    }
+    return inflated;
+}
+} // namespace
+
+void
+RGBImage::loadFromPNG(std::istream &input) {
+    trace::Span span("png.load");
+
+    const auto data = io::readAll(input);
+    if (data.size() < 8 || data.compare(0, 8, png_signature, 8) != 0) {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    Header header{0, 0, 0, 0, false};
+    std::array<Pixel, 256> palette{};
+    bool has_key = false;
+    std::array<std::uint16_t, 3> key{};
+    std::string deflated;
+
+    // Read the chunks, checking their CRC.
+    for (size_t offset = 8;;) {
+        if (data.size() - offset < 12) {
+            throw std::invalid_argument("corrupted file");
+        }
+        const auto chunk = reinterpret_cast<const std::uint8_t *>(data.data()) + offset;
+        const auto length = read_u32(chunk);
+        if (length > data.size() - offset - 12) {
+            throw std::invalid_argument("corrupted file");
+        }
+        if (crc32(0, chunk + 4, length + 4) != read_u32(chunk + 8 + length)) {
+            throw std::invalid_argument("corrupted file");
+        }
+        const auto type = std::string(reinterpret_cast<const char *>(chunk + 4), 4);
+        const auto body = chunk + 8;
+        offset += length + 12;
+
+        if (type == "IHDR") {
+            if (length != 13) {
+                throw std::invalid_argument("corrupted file");
+            }
+            header.width = read_u32(body);
+            header.height = read_u32(body + 4);
+            header.bitDepth = body[8];
+            header.colorType = body[9];
+            header.interlaced = body[12] == 1;
+        } else if (type == "PLTE") {
+            for (auto i = 0u; i < length/3 && i < palette.size(); ++i) {
+                palette[i] = Pixel{body[3*i], body[3*i + 1], body[3*i + 2], 255};
+            }
+        } else if (type == "tRNS") {
+            if (header.colorType == Indexed) {
+                for (auto i = 0u; i < length && i < palette.size(); ++i) {
+                    palette[i].alpha = body[i];
+                }
+            } else if (header.colorType == Gray && length >= 2) {
+                has_key = true;
+                key[0] = std::uint16_t(body[0] << 8 | body[1]);
+            } else if (header.colorType == RGB && length >= 6) {
+                has_key = true;
+                for (auto i = 0u; i < 3; ++i) {
+                    key[i] = std::uint16_t(body[2*i] << 8 | body[2*i + 1]);
+                }
+            }
+        } else if (type == "IDAT") {
+            deflated.append(reinterpret_cast<const char *>(body), length);
+        } else if (type == "IEND") {
+            break;
+        }
+    }
+
+    const auto depth = header.bitDepth;
+    const auto valid_depth = [&] {
+        switch (header.colorType) {
+        case Gray:
+            return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+        case Indexed:
+            return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+        case RGB:
+        case GrayAlpha:
+        case RGBA:
+            return depth == 8 || depth == 16;
+        default:
+            return false;
+        }
+    }();
+    if (!valid_depth
+            || header.width == 0 || header.height == 0
+            || header.width > 0x8000 || header.height > 0x8000) {
+        throw std::invalid_argument("corrupted file");
+    }
+
+    // Sub images of the passes, a single one when not interlaced.
+    struct Pass {
+        size_t x, y, dx, dy, width, height;
+    };
+    std::vector<Pass> passes;
+    if (header.interlaced) {
+        for (const auto &[x, y, dx, dy]: adam7_passes) {
+            const auto width = header.width > x ? (header.width - x + dx - 1)/dx : 0;
+            const auto height = header.height > y ? (header.height - y + dy - 1)/dy : 0;
+            if (width > 0 && height > 0) {
+                passes.push_back(Pass{x, y, dx, dy, width, height});
+            }
+        }
+    } else {
+        passes.push_back(Pass{0, 0, 1, 1, header.width, header.height});
+    }
+
+    size_t inflated_size = 0;
+    for (const auto &pass: passes) {
+        inflated_size += (header.getRowSize(pass.width) + 1)*pass.height;
+    }
+    auto inflated = inflate_data(deflated, inflated_size);
+
+    width_ = header.width;
+    height_ = header.height;
+    pixels_.assign(width_*height_, Pixel{});
+
+    const auto channels = header.getChannelCount();
+    const auto stride = header.getFilterStride();
+
+    // Return the sample of the given index of a row, scaled to 8 bits, and
+    // the raw sample for the transparency key.
+    const auto sample = [&](const std::uint8_t *row, size_t index, std::uint16_t &raw) -> std::uint8_t {
+        switch (depth) {
+        case 16:
+            raw = std::uint16_t(row[2*index] << 8 | row[2*index + 1]);
+            return row[2*index];
+        case 8:
+            raw = row[index];
+            return row[index];
+        default: {
+            const auto per_byte = 8/depth;
+            const auto shift = 8 - depth*(index%per_byte + 1);
+            raw = (row[index/per_byte] >> shift) & ((1u << depth) - 1);
+            return header.colorType == Indexed ? raw : raw*255/((1u << depth) - 1);
+        }
+        }
+    };
+
+    auto data_offset = size_t{0};
+    for (const auto &pass: passes) {
+        const auto row_size = header.getRowSize(pass.width);
+        std::vector<std::uint8_t> zero(row_size, 0);
+        const std::uint8_t *prior = zero.data();
+
+        for (auto y = 0u; y < pass.height; ++y) {
+            auto row = reinterpret_cast<std::uint8_t *>(inflated.data()) + data_offset;
+            unfilter_row(row[0], row + 1, prior, row_size, stride);
+            ++row;
+            prior = row;
+            data_offset += row_size + 1;
+
+            const auto dst = pixels_.data() + (pass.y + y*pass.dy)*width_ + pass.x;
+            for (auto x = 0u; x < pass.width; ++x) {
+                const auto out = dst + x*pass.dx;
+                std::array<std::uint16_t, 4> raw{};
+                std::array<std::uint8_t, 4> values{};
+                for (auto c = 0u; c < channels; ++c) {
+                    values[c] = sample(row, x*channels + c, raw[c]);
+                }
+                switch (header.colorType) {
+                case Gray:
+                    *out = Pixel{values[0], values[0], values[0], 255};
+                    if (has_key && raw[0] == key[0]) {
+                        out->alpha = 0;
+                    }
+                    break;
+                case RGB:
+                    *out = Pixel{values[0], values[1], values[2], 255};
+                    if (has_key && raw[0] == key[0] && raw[1] == key[1] && raw[2] == key[2]) {
+                        out->alpha = 0;
+                    }
+                    break;
+                case Indexed:
+                    *out = palette[values[0]];
+                    break;
+                case GrayAlpha:
+                    *out = Pixel{values[0], values[0], values[0], values[1]};
+                    break;
+                case RGBA:
+                    *out = Pixel{values[0], values[1], values[2], values[3]};
+                    break;
+                }
+            }
+        }
+    }
+}
+
+} // namespace nr::dune2
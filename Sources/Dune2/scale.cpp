@@ -0,0 +1,150 @@
+#include "scale.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr std::array<const char *, 2> filter_names{
+    "nearest",
+    "scalex",
+};
+
+using Pixels = std::vector<std::uint8_t>;
+
+Pixels
+scale_nearest(const Pixels &src, size_t width, size_t height, size_t factor) {
+    const auto &kernels = simd::getKernels();
+
+    Pixels dst(width*factor*height*factor, 0);
+    const auto dst_width = width*factor;
+    for (auto y = 0u; y < height; ++y) {
+        const auto row = src.data() + y*width;
+        const auto out = dst.data() + y*factor*dst_width;
+        if (factor == 2) {
+            kernels.doubleBytes(row, width, out);
+        } else {
+            for (auto x = 0u; x < width; ++x) {
+                std::fill_n(out + x*factor, factor, row[x]);
+            }
+        }
+        for (auto k = 1u; k < factor; ++k) {
+            std::memcpy(out + k*dst_width, out, dst_width);
+        }
+    }
+    return dst;
+}
+
+Pixels
+scale_2x(const Pixels &src, size_t width, size_t height) {
+    const auto &kernels = simd::getKernels();
+
+    Pixels dst(4*width*height, 0);
+    for (auto y = 0u; y < height; ++y) {
+        const auto row = src.data() + y*width;
+        const auto above = y > 0 ? row - width : row;
+        const auto below = y + 1 < height ? row + width : row;
+        const auto out = dst.data() + 2*y*2*width;
+        kernels.scale2xRow(above, row, below, width, out, out + 2*width);
+    }
+    return dst;
+}
+
+Pixels
+scale_3x(const Pixels &src, size_t width, size_t height) {
+    Pixels dst(9*width*height, 0);
+    const auto dst_width = 3*width;
+    for (auto y = 0u; y < height; ++y) {
+        const auto row = src.data() + y*width;
+        const auto above = y > 0 ? row - width : row;
+        const auto below = y + 1 < height ? row + width : row;
+        auto out = dst.data() + 3*y*dst_width;
+        for (auto x = 0u; x < width; ++x, out += 3) {
+            // A B C
+            // D E F
+            // G H I
+            const auto l = x > 0 ? x - 1 : x;
+            const auto r = x + 1 < width ? x + 1 : x;
+            const auto a = above[l], b = above[x], c = above[r];
+            const auto d = row[l], e = row[x], f = row[r];
+            const auto g = below[l], h = below[x], i = below[r];
+
+            std::array<std::uint8_t, 9> block;
+            block.fill(e);
+            if (b != h && d != f) {
+                block[0] = d == b ? d : e;
+                block[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+                block[2] = b == f ? f : e;
+                block[3] = (d == b && e != g) || (d == h && e != a) ? d : e;
+                block[5] = (b == f && e != i) || (h == f && e != c) ? f : e;
+                block[6] = d == h ? d : e;
+                block[7] = (d == h && e != i) || (h == f && e != g) ? h : e;
+                block[8] = h == f ? f : e;
+            }
+            for (auto k = 0u; k < 3; ++k) {
+                std::copy_n(block.data() + 3*k, 3, out + k*dst_width);
+            }
+        }
+    }
+    return dst;
+}
+} // namespace
+
+const char *
+getScaleFilterName(ScaleFilter filter) {
+    return filter_names.at(static_cast<size_t>(filter));
+}
+
+std::optional<ScaleFilter>
+findScaleFilter(const std::string &name) {
+    const auto it = std::find(filter_names.begin(), filter_names.end(), name);
+    if (it == filter_names.end()) {
+        return std::nullopt;
+    }
+    return static_cast<ScaleFilter>(it - filter_names.begin());
+}
+
+Image
+scaleSurface(const Surface &surface, size_t factor, ScaleFilter filter) {
+    trace::Span span("image.scale");
+
+    if (factor == 0 || (filter == ScaleFilter::ScaleX && factor > 4)) {
+        throw std::invalid_argument("unsupported scale factor");
+    }
+
+    const auto width = surface.getWidth();
+    const auto height = surface.getHeight();
+
+    Pixels pixels(width*height, 0);
+    for (auto y = 0u; y < height; ++y) {
+        for (auto x = 0u; x < width; ++x) {
+            pixels[y*width + x] = surface.getPixel(x, y);
+        }
+    }
+
+    if (filter == ScaleFilter::Nearest || factor == 1) {
+        pixels = scale_nearest(pixels, width, height, factor);
+    } else if (factor == 3) {
+        pixels = scale_3x(pixels, width, height);
+    } else {
+        pixels = scale_2x(pixels, width, height);
+        if (factor == 4) {
+            pixels = scale_2x(pixels, 2*width, 2*height);
+        }
+    }
+
+    return Image(
+        width*factor,
+        height*factor,
+        std::string(reinterpret_cast<const char *>(pixels.data()), pixels.size())
+    );
+}
+
+} // namespace nr::dune2
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Dune2/image.hpp>
+#include <Dune2/surface.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace nr::dune2 {
+/// ### enum `nr::dune2::ScaleFilter`
+/// - `Nearest` - each pixel becomes a block of pixels, any factor,
+/// - `ScaleX` - the Scale2x (also known as EPX) and Scale3x pixel art
+///   algorithms, factors `2`, `3` and `4` (Scale2x applied twice).
+enum class ScaleFilter {
+    Nearest,
+    ScaleX,
+};
+
+/// ### function `nr::dune2::getScaleFilterName`
+/// #### Return
+/// `const char *` - the name of the given filter.
+const char *getScaleFilterName(ScaleFilter);
+
+/// ### function `nr::dune2::findScaleFilter`
+/// #### Parameters
+/// - `const std::string &name` - a filter name
+/// #### Return
+/// `std::optional<ScaleFilter>` - the filter of the given name if any.
+std::optional<ScaleFilter> findScaleFilter(const std::string &);
+
+/// ### function `nr::dune2::scaleSurface`
+/// Scale the color indexes of a surface. Colors are only copied, never
+/// blended, so that the result uses the palette of the source. Throw
+/// `std::invalid_argument` if the filter does not support the factor.
+/// #### Parameters
+/// - `const Surface &surface` - a surface
+/// - `size_t factor` - the scale factor
+/// - `ScaleFilter filter` - the filter
+/// #### Return
+/// `Image` - the scaled image, without remap table.
+Image scaleSurface(const Surface &, size_t factor, ScaleFilter = ScaleFilter::Nearest);
+} // namespace nr::dune2
@@ -0,0 +1,289 @@
+#include "simd.hpp"
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace nr::dune2::simd {
+
+namespace {
+constexpr std::array<const char *, 4> level_names{
+    "scalar",
+    "sse2",
+    "ssse3",
+    "avx2",
+};
+
+Level
+select_level() {
+    const auto detected = detectLevel();
+    const auto forced = std::getenv("DUNE2_SIMD_LEVEL");
+
+    if (forced == nullptr) {
+        return detected;
+    }
+
+    const auto it = std::find_if(
+        level_names.begin(),
+        level_names.end(),
+        [&](const char *name) { return std::strcmp(name, forced) == 0; }
+    );
+    if (it == level_names.end()) {
+        std::cerr
+            << "warning: unknown DUNE2_SIMD_LEVEL '" << forced << "', "
+            << "using " << getLevelName(detected) << "\n";
+        return detected;
+    }
+
+    const auto level = static_cast<Level>(it - level_names.begin());
+    if (level > detected) {
+        std::cerr
+            << "warning: DUNE2_SIMD_LEVEL " << forced << " is not supported by "
+            << "this CPU, using " << getLevelName(detected) << "\n";
+        return detected;
+    }
+    return level;
+}
+} // namespace
+
+namespace scalar {
+
+void
+unpackNibbles(const std::uint8_t *src, std::size_t count, const std::uint8_t *lut, std::uint8_t *dst) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[2*i + 0] = lut[src[i] >> 4];
+        dst[2*i + 1] = lut[src[i] & 0x0f];
+    }
+}
+
+void
+xorCopy(std::uint8_t *dst, const std::uint8_t *src, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+void
+xorFill(std::uint8_t *dst, std::uint8_t value, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] ^= value;
+    }
+}
+
+void
+remapRange(const std::uint8_t *src, std::size_t count, std::uint8_t first, const std::uint8_t *lut, std::uint8_t *dst) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint8_t index = src[i] - first;
+        dst[i] = index < 16 ? lut[index] : src[i];
+    }
+}
+
+void
+doubleBytes(const std::uint8_t *src, std::size_t count, std::uint8_t *dst) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[2*i + 0] = src[i];
+        dst[2*i + 1] = src[i];
+    }
+}
+
+std::uint8_t
+orAccumulate(std::uint8_t *dst, const std::uint8_t *src, std::size_t count) {
+    std::uint8_t any = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] |= src[i];
+        any |= src[i];
+    }
+    return any;
+}
+
+void
+packNibbles(const std::uint8_t *src, std::size_t count, std::uint8_t *dst) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = std::uint8_t(src[2*i] << 4 | src[2*i + 1]);
+    }
+}
+
+void
+overlapCopy(std::uint8_t *dst, std::size_t distance, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = dst[i - distance];
+    }
+}
+
+void
+expandPalette(const std::uint8_t *src, std::size_t count, const std::uint8_t *lut, std::uint8_t *dst) {
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[3*i + 0] = lut[3*src[i] + 0];
+        dst[3*i + 1] = lut[3*src[i] + 1];
+        dst[3*i + 2] = lut[3*src[i] + 2];
+    }
+}
+
+void
+resampleLinear(const std::uint8_t *src, std::uint64_t pos, std::uint64_t step, std::size_t count, std::uint8_t *dst) {
+    for (std::size_t i = 0; i < count; ++i, pos += step) {
+        const auto index = pos >> 16;
+        const auto frac = static_cast<std::int32_t>(pos & 0xffff);
+        const std::int32_t s0 = src[index];
+        const std::int32_t s1 = src[index + 1];
+        dst[i] = static_cast<std::uint8_t>(s0 + (((s1 - s0)*frac + 0x8000) >> 16));
+    }
+}
+
+void
+scale2xSpan(
+    const std::uint8_t *above,
+    const std::uint8_t *row,
+    const std::uint8_t *below,
+    std::size_t width,
+    std::size_t first,
+    std::size_t last,
+    std::uint8_t *dst0,
+    std::uint8_t *dst1
+) {
+    //   A
+    // C P B
+    //   D
+    for (std::size_t x = first; x < last; ++x) {
+        const auto a = above[x];
+        const auto b = row[x + 1 < width ? x + 1 : x];
+        const auto c = row[x > 0 ? x - 1 : x];
+        const auto d = below[x];
+        const auto p = row[x];
+        if (b != c && a != d) {
+            dst0[2*x + 0] = c == a ? a : p;
+            dst0[2*x + 1] = a == b ? b : p;
+            dst1[2*x + 0] = c == d ? c : p;
+            dst1[2*x + 1] = d == b ? d : p;
+        } else {
+            dst0[2*x + 0] = dst0[2*x + 1] = p;
+            dst1[2*x + 0] = dst1[2*x + 1] = p;
+        }
+    }
+}
+
+void
+scale2xRow(
+    const std::uint8_t *above,
+    const std::uint8_t *row,
+    const std::uint8_t *below,
+    std::size_t width,
+    std::uint8_t *dst0,
+    std::uint8_t *dst1
+) {
+    scale2xSpan(above, row, below, width, 0, width, dst0, dst1);
+}
+
+} // namespace scalar
+
+Level
+detectLevel() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Level::AVX2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return Level::SSSE3;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Level::SSE2;
+    }
+#endif
+    return Level::Scalar;
+}
+
+Level
+getLevel() {
+    static const auto level = select_level();
+    return level;
+}
+
+const char *
+getLevelName(Level level) {
+    return level_names.at(static_cast<std::size_t>(level));
+}
+
+const Kernels &
+getKernels() {
+    static const auto &kernels = getKernels(getLevel());
+    return kernels;
+}
+
+const Kernels &
+getKernels(Level level) {
+    static const Kernels scalar_kernels{
+        scalar::unpackNibbles,
+        scalar::xorCopy,
+        scalar::xorFill,
+        scalar::remapRange,
+        scalar::doubleBytes,
+        scalar::scale2xRow,
+        scalar::orAccumulate,
+        scalar::packNibbles,
+        scalar::resampleLinear,
+        scalar::overlapCopy,
+        scalar::expandPalette,
+    };
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    // Each level reuses the kernels of the previous level it does not
+    // improve.
+    static const Kernels sse2_kernels{
+        scalar::unpackNibbles,
+        sse2::xorCopy,
+        sse2::xorFill,
+        scalar::remapRange,
+        sse2::doubleBytes,
+        sse2::scale2xRow,
+        sse2::orAccumulate,
+        sse2::packNibbles,
+        sse2::resampleLinear,
+        sse2::overlapCopy,
+        scalar::expandPalette,
+    };
+    static const Kernels ssse3_kernels{
+        ssse3::unpackNibbles,
+        sse2::xorCopy,
+        sse2::xorFill,
+        ssse3::remapRange,
+        sse2::doubleBytes,
+        sse2::scale2xRow,
+        sse2::orAccumulate,
+        sse2::packNibbles,
+        sse2::resampleLinear,
+        sse2::overlapCopy,
+        scalar::expandPalette,
+    };
+    static const Kernels avx2_kernels{
+        avx2::unpackNibbles,
+        avx2::xorCopy,
+        avx2::xorFill,
+        avx2::remapRange,
+        avx2::doubleBytes,
+        avx2::scale2xRow,
+        avx2::orAccumulate,
+        avx2::packNibbles,
+        avx2::resampleLinear,
+        avx2::overlapCopy,
+        avx2::expandPalette,
+    };
+
+    switch (level) {
+    case Level::AVX2:
+        return avx2_kernels;
+    case Level::SSSE3:
+        return ssse3_kernels;
+    case Level::SSE2:
+        return sse2_kernels;
+    case Level::Scalar:
+        break;
+    }
+#endif
+    return scalar_kernels;
+}
+
+} // namespace nr::dune2::simd
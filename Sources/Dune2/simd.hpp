@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nr::dune2::simd {
+/// ### enum `nr::dune2::simd::Level`
+/// Instruction set levels, each level implies the previous ones.
+enum class Level {
+    Scalar,
+    SSE2,
+    SSSE3,
+    AVX2,
+};
+
+/// ### struct `nr::dune2::simd::Kernels`
+/// A set of kernels bound to one instruction set level.
+struct Kernels {
+    /// #### attribute `unpackNibbles`
+    /// Split each source byte in two 4 bits indexes, high nibble first, and
+    /// map them through a 16 entries lookup table.
+    /// `dst` must be able to hold _2*count_ bytes.
+    void (*unpackNibbles)(const std::uint8_t *src, std::size_t count, const std::uint8_t *lut, std::uint8_t *dst);
+
+    /// #### attribute `xorCopy`
+    /// _dst[i] ^= src[i]_ for _i_ in _[0, count)_.
+    void (*xorCopy)(std::uint8_t *dst, const std::uint8_t *src, std::size_t count);
+
+    /// #### attribute `xorFill`
+    /// _dst[i] ^= value_ for _i_ in _[0, count)_.
+    void (*xorFill)(std::uint8_t *dst, std::uint8_t value, std::size_t count);
+
+    /// #### attribute `remapRange`
+    /// Map the source bytes in _[first, first + 16)_ through a 16 entries
+    /// lookup table, copy the other bytes as is.
+    /// `dst` must be able to hold _count_ bytes.
+    void (*remapRange)(const std::uint8_t *src, std::size_t count, std::uint8_t first, const std::uint8_t *lut, std::uint8_t *dst);
+
+    /// #### attribute `doubleBytes`
+    /// _dst[2*i] = dst[2*i + 1] = src[i]_ for _i_ in _[0, count)_.
+    void (*doubleBytes)(const std::uint8_t *src, std::size_t count, std::uint8_t *dst);
+
+    /// #### attribute `scale2xRow`
+    /// Scale a row of _width_ pixels with the Scale2x algorithm given the
+    /// rows above and below it, pixels outside of the row repeat its edges.
+    /// `dst0` and `dst1` receive the two output rows of _2*width_ pixels.
+    void (*scale2xRow)(const std::uint8_t *above, const std::uint8_t *row, const std::uint8_t *below, std::size_t width, std::uint8_t *dst0, std::uint8_t *dst1);
+
+    /// #### attribute `orAccumulate`
+    /// _dst[i] |= src[i]_ for _i_ in _[0, count)_, return a non zero value
+    /// if one of the source bytes is not `0`.
+    std::uint8_t (*orAccumulate)(std::uint8_t *dst, const std::uint8_t *src, std::size_t count);
+
+    /// #### attribute `packNibbles`
+    /// _dst[i] = src[2*i] << 4 | src[2*i + 1]_ for _i_ in _[0, count)_, the
+    /// source bytes being 4 bits indexes. The reverse of `unpackNibbles`
+    /// without lookup table.
+    void (*packNibbles)(const std::uint8_t *src, std::size_t count, std::uint8_t *dst);
+
+    /// #### attribute `resampleLinear`
+    /// Interpolate _count_ unsigned 8 bits samples between the source
+    /// samples at the 16.16 fixed point positions _pos + i*step_. The
+    /// samples at the integer part of each position and the next one are
+    /// read, they must be in the source.
+    void (*resampleLinear)(const std::uint8_t *src, std::uint64_t pos, std::uint64_t step, std::size_t count, std::uint8_t *dst);
+
+    /// #### attribute `overlapCopy`
+    /// _dst[i] = dst[i - distance]_ for _i_ in _[0, count)_, in order, so
+    /// that a distance below _count_ repeats the last _distance_ bytes, the
+    /// way LCW copies do. `distance` must not be `0`.
+    void (*overlapCopy)(std::uint8_t *dst, std::size_t distance, std::size_t count);
+
+    /// #### attribute `expandPalette`
+    /// Map each source byte through a 256 entries table of 3 bytes colors.
+    /// `lut` must be readable up to _3*256 + 1_ bytes, `dst` must be able
+    /// to hold _3*count_ bytes.
+    void (*expandPalette)(const std::uint8_t *src, std::size_t count, const std::uint8_t *lut, std::uint8_t *dst);
+};
+
+/// ### function `nr::dune2::simd::detectLevel`
+/// #### Return
+/// `Level` - the highest level supported by the CPU and the OS.
+Level detectLevel();
+
+/// ### function `nr::dune2::simd::getLevel`
+/// The active level is detected once. It can be lowered by setting the
+/// `DUNE2_SIMD_LEVEL` environment variable to `scalar`, `sse2`, `ssse3` or
+/// `avx2`. A warning is written on the standard error when the name is
+/// unknown or the level is not supported by the CPU, the detected level is
+/// used instead.
+/// #### Return
+/// `Level` - the active level.
+Level getLevel();
+
+/// ### function `nr::dune2::simd::getLevelName`
+/// #### Return
+/// `const char *` - the name of the given level.
+const char *getLevelName(Level);
+
+/// ### function `nr::dune2::simd::getKernels`
+/// #### Return
+/// `const Kernels &` - the kernels of the active level.
+const Kernels &getKernels();
+
+/// ### function `nr::dune2::simd::getKernels`
+/// The caller is responsible for checking that the CPU supports the given
+/// level.
+/// #### Parameters
+/// - `Level level` - an instruction set level
+/// #### Return
+/// `const Kernels &` - the kernels of the given level.
+const Kernels &getKernels(Level);
+} // namespace nr::dune2::simd
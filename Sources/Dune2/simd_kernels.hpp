@@ -0,0 +1,59 @@
+#pragma once
+
+// Kernels implementations, see `simd.hpp` for their description.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nr::dune2::simd {
+
+namespace scalar {
+void unpackNibbles(const std::uint8_t *, std::size_t, const std::uint8_t *, std::uint8_t *);
+void xorCopy(std::uint8_t *, const std::uint8_t *, std::size_t);
+void xorFill(std::uint8_t *, std::uint8_t, std::size_t);
+void remapRange(const std::uint8_t *, std::size_t, std::uint8_t, const std::uint8_t *, std::uint8_t *);
+void doubleBytes(const std::uint8_t *, std::size_t, std::uint8_t *);
+void scale2xRow(const std::uint8_t *, const std::uint8_t *, const std::uint8_t *, std::size_t, std::uint8_t *, std::uint8_t *);
+std::uint8_t orAccumulate(std::uint8_t *, const std::uint8_t *, std::size_t);
+void packNibbles(const std::uint8_t *, std::size_t, std::uint8_t *);
+void resampleLinear(const std::uint8_t *, std::uint64_t, std::uint64_t, std::size_t, std::uint8_t *);
+void overlapCopy(std::uint8_t *, std::size_t, std::size_t);
+void expandPalette(const std::uint8_t *, std::size_t, const std::uint8_t *, std::uint8_t *);
+
+// Scale2x of the pixels [first, last) of a row, see `scale2xRow`.
+void scale2xSpan(const std::uint8_t *, const std::uint8_t *, const std::uint8_t *, std::size_t, std::size_t first, std::size_t last, std::uint8_t *, std::uint8_t *);
+} // namespace scalar
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+namespace sse2 {
+void xorCopy(std::uint8_t *, const std::uint8_t *, std::size_t);
+void xorFill(std::uint8_t *, std::uint8_t, std::size_t);
+void doubleBytes(const std::uint8_t *, std::size_t, std::uint8_t *);
+void scale2xRow(const std::uint8_t *, const std::uint8_t *, const std::uint8_t *, std::size_t, std::uint8_t *, std::uint8_t *);
+std::uint8_t orAccumulate(std::uint8_t *, const std::uint8_t *, std::size_t);
+void packNibbles(const std::uint8_t *, std::size_t, std::uint8_t *);
+void resampleLinear(const std::uint8_t *, std::uint64_t, std::uint64_t, std::size_t, std::uint8_t *);
+void overlapCopy(std::uint8_t *, std::size_t, std::size_t);
+} // namespace sse2
+
+namespace ssse3 {
+void unpackNibbles(const std::uint8_t *, std::size_t, const std::uint8_t *, std::uint8_t *);
+void remapRange(const std::uint8_t *, std::size_t, std::uint8_t, const std::uint8_t *, std::uint8_t *);
+} // namespace ssse3
+
+namespace avx2 {
+void unpackNibbles(const std::uint8_t *, std::size_t, const std::uint8_t *, std::uint8_t *);
+void xorCopy(std::uint8_t *, const std::uint8_t *, std::size_t);
+void xorFill(std::uint8_t *, std::uint8_t, std::size_t);
+void remapRange(const std::uint8_t *, std::size_t, std::uint8_t, const std::uint8_t *, std::uint8_t *);
+void doubleBytes(const std::uint8_t *, std::size_t, std::uint8_t *);
+void scale2xRow(const std::uint8_t *, const std::uint8_t *, const std::uint8_t *, std::size_t, std::uint8_t *, std::uint8_t *);
+std::uint8_t orAccumulate(std::uint8_t *, const std::uint8_t *, std::size_t);
+void packNibbles(const std::uint8_t *, std::size_t, std::uint8_t *);
+void resampleLinear(const std::uint8_t *, std::uint64_t, std::uint64_t, std::size_t, std::uint8_t *);
+void overlapCopy(std::uint8_t *, std::size_t, std::size_t);
+void expandPalette(const std::uint8_t *, std::size_t, const std::uint8_t *, std::uint8_t *);
+} // namespace avx2
+#endif
+
+} // namespace nr::dune2::simd
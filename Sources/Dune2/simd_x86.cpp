@@ -0,0 +1,497 @@
+#include "simd_kernels.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Functions are compiled for their instruction set with the target
+// attribute so that the rest of the library keeps the baseline instruction
+// set and runs on any CPU.
+#define NR_TARGET(isa) __attribute__((target(isa)))
+
+namespace nr::dune2::simd {
+
+namespace sse2 {
+
+NR_TARGET("sse2") void
+xorCopy(std::uint8_t *dst, const std::uint8_t *src, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(a, b));
+    }
+    scalar::xorCopy(dst + i, src + i, count - i);
+}
+
+NR_TARGET("sse2") void
+xorFill(std::uint8_t *dst, std::uint8_t value, std::size_t count) {
+    const auto v = _mm_set1_epi8(static_cast<char>(value));
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(a, v));
+    }
+    scalar::xorFill(dst + i, value, count - i);
+}
+
+NR_TARGET("sse2") void
+doubleBytes(const std::uint8_t *src, std::size_t count, std::uint8_t *dst) {
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2*i), _mm_unpacklo_epi8(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2*i + 16), _mm_unpackhi_epi8(v, v));
+    }
+    scalar::doubleBytes(src + i, count - i, dst + 2*i);
+}
+
+// The OR of the source bytes is kept in a register and folded at the end.
+NR_TARGET("sse2") std::uint8_t
+orAccumulate(std::uint8_t *dst, const std::uint8_t *src, std::size_t count) {
+    auto any = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(a, b));
+        any = _mm_or_si128(any, b);
+    }
+    const auto zero = _mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) == 0xffff;
+    return scalar::orAccumulate(dst + i, src + i, count - i) | (zero ? 0 : 1);
+}
+
+// Each 16 bits word holds a pair of nibbles, the first one in its low byte.
+NR_TARGET("sse2") void
+packNibbles(const std::uint8_t *src, std::size_t count, std::uint8_t *dst) {
+    const auto low_byte = _mm_set1_epi16(0x00ff);
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2*i));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2*i + 16));
+        const auto pa = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, low_byte), 4), _mm_srli_epi16(a, 8));
+        const auto pb = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, low_byte), 4), _mm_srli_epi16(b, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(pa, pb));
+    }
+    scalar::packNibbles(src + 2*i, count - i, dst + i);
+}
+
+// Bytes repeat every distance bytes, so a distance below 16 is widened to
+// its smallest multiple of at least 16 once the bytes before the first
+// widened source are copied.
+NR_TARGET("sse2") void
+overlapCopy(std::uint8_t *dst, std::size_t distance, std::size_t count) {
+    const auto step = distance < 16 ? (15/distance + 1)*distance : distance;
+
+    std::size_t i = std::min(count, step - distance);
+    scalar::overlapCopy(dst, distance, i);
+    for (; i + 16 <= count; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i - step));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+    }
+    scalar::overlapCopy(dst + i, distance, count - i);
+}
+
+// Pairs of consecutive source samples are loaded in 16 bits words, the
+// first sample in the low byte. The 32 bits product of the signed sample
+// difference by the unsigned fraction is rebuilt from the signed 16 bits
+// multiplications: a fraction above 0x7fff is read as negative, which
+// takes the difference out of the high word.
+NR_TARGET("sse2") void
+resampleLinear(const std::uint8_t *src, std::uint64_t pos, std::uint64_t step, std::size_t count, std::uint8_t *dst) {
+    const auto low_byte = _mm_set1_epi16(0x00ff);
+    const auto zero = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        alignas(16) std::uint16_t pairs[8];
+        alignas(16) std::uint16_t fracs[8];
+        for (auto k = 0u; k < 8; ++k, pos += step) {
+            std::memcpy(&pairs[k], src + (pos >> 16), 2);
+            fracs[k] = static_cast<std::uint16_t>(pos & 0xffff);
+        }
+        const auto w = _mm_load_si128(reinterpret_cast<const __m128i *>(pairs));
+        const auto frac = _mm_load_si128(reinterpret_cast<const __m128i *>(fracs));
+
+        const auto s0 = _mm_and_si128(w, low_byte);
+        const auto diff = _mm_sub_epi16(_mm_srli_epi16(w, 8), s0);
+        const auto lo = _mm_mullo_epi16(diff, frac);
+        const auto hi = _mm_add_epi16(
+            _mm_mulhi_epi16(diff, frac),
+            _mm_and_si128(_mm_cmplt_epi16(frac, zero), diff)
+        );
+        // Rounding carries into the high word when the low word is at least
+        // 0x8000.
+        const auto delta = _mm_add_epi16(hi, _mm_srli_epi16(lo, 15));
+        const auto v = _mm_add_epi16(s0, delta);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(v, v));
+    }
+    scalar::resampleLinear(src, pos, step, count - i, dst + i);
+}
+
+// Select x where the mask is set, y elsewhere.
+NR_TARGET("sse2") inline __m128i
+select_si128(__m128i mask, __m128i x, __m128i y) {
+    return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+
+// The four output pixels are computed with compare masks on 16 pixels at
+// once, the left and right neighbours being unaligned loads of the row.
+// Edge pixels are left to the scalar code.
+NR_TARGET("sse2") void
+scale2xRow(
+    const std::uint8_t *above,
+    const std::uint8_t *row,
+    const std::uint8_t *below,
+    std::size_t width,
+    std::uint8_t *dst0,
+    std::uint8_t *dst1
+) {
+    const auto ones = _mm_set1_epi8(-1);
+
+    if (width == 0) {
+        return;
+    }
+
+    std::size_t x = 1;
+    scalar::scale2xSpan(above, row, below, width, 0, x, dst0, dst1);
+    for (; x + 17 <= width; x += 16) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + x));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x + 1));
+        const auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x - 1));
+        const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(below + x));
+        const auto p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+
+        const auto edge = _mm_andnot_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(b, c), _mm_cmpeq_epi8(a, d)),
+            ones
+        );
+        const auto e0 = select_si128(_mm_and_si128(edge, _mm_cmpeq_epi8(c, a)), a, p);
+        const auto e1 = select_si128(_mm_and_si128(edge, _mm_cmpeq_epi8(a, b)), b, p);
+        const auto e2 = select_si128(_mm_and_si128(edge, _mm_cmpeq_epi8(c, d)), c, p);
+        const auto e3 = select_si128(_mm_and_si128(edge, _mm_cmpeq_epi8(d, b)), d, p);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst0 + 2*x), _mm_unpacklo_epi8(e0, e1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst0 + 2*x + 16), _mm_unpackhi_epi8(e0, e1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst1 + 2*x), _mm_unpacklo_epi8(e2, e3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst1 + 2*x + 16), _mm_unpackhi_epi8(e2, e3));
+    }
+    scalar::scale2xSpan(above, row, below, width, x, width, dst0, dst1);
+}
+
+} // namespace sse2
+
+namespace ssse3 {
+
+// Nibbles are split with a shift and a mask, looked up with pshufb then
+// interleaved back, high nibble first.
+NR_TARGET("ssse3") void
+unpackNibbles(const std::uint8_t *src, std::size_t count, const std::uint8_t *lut, std::uint8_t *dst) {
+    const auto table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lut));
+    const auto mask = _mm_set1_epi8(0x0f);
+
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const auto hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        const auto lo = _mm_shuffle_epi8(table, _mm_and_si128(v, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2*i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2*i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    scalar::unpackNibbles(src + i, count - i, lut, dst + 2*i);
+}
+
+// Bytes are rebased on the first color of the range, those which are still
+// below 16 are looked up with pshufb and blended with the source.
+NR_TARGET("ssse3") void
+remapRange(const std::uint8_t *src, std::size_t count, std::uint8_t first, const std::uint8_t *lut, std::uint8_t *dst) {
+    const auto table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lut));
+    const auto base = _mm_set1_epi8(static_cast<char>(first));
+    const auto last = _mm_set1_epi8(15);
+
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const auto index = _mm_sub_epi8(v, base);
+        const auto in_range = _mm_cmpeq_epi8(_mm_min_epu8(index, last), index);
+        const auto remapped = _mm_shuffle_epi8(table, index);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(dst + i),
+            _mm_or_si128(_mm_and_si128(in_range, remapped), _mm_andnot_si128(in_range, v))
+        );
+    }
+    scalar::remapRange(src + i, count - i, first, lut, dst + i);
+}
+
+} // namespace ssse3
+
+namespace avx2 {
+
+NR_TARGET("avx2") void
+unpackNibbles(const std::uint8_t *src, std::size_t count, const std::uint8_t *lut, std::uint8_t *dst) {
+    const auto table = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(lut))
+    );
+    const auto mask = _mm256_set1_epi8(0x0f);
+
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        const auto hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        const auto lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, mask));
+        // Unpack works within 128 bits lanes, put the lanes back in order.
+        const auto a = _mm256_unpacklo_epi8(hi, lo);
+        const auto b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(dst + 2*i),
+            _mm256_permute2x128_si256(a, b, 0x20)
+        );
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(dst + 2*i + 32),
+            _mm256_permute2x128_si256(a, b, 0x31)
+        );
+    }
+    ssse3::unpackNibbles(src + i, count - i, lut, dst + 2*i);
+}
+
+NR_TARGET("avx2") void
+xorCopy(std::uint8_t *dst, const std::uint8_t *src, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(a, b));
+    }
+    sse2::xorCopy(dst + i, src + i, count - i);
+}
+
+NR_TARGET("avx2") void
+xorFill(std::uint8_t *dst, std::uint8_t value, std::size_t count) {
+    const auto v = _mm256_set1_epi8(static_cast<char>(value));
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(a, v));
+    }
+    sse2::xorFill(dst + i, value, count - i);
+}
+
+NR_TARGET("avx2") void
+remapRange(const std::uint8_t *src, std::size_t count, std::uint8_t first, const std::uint8_t *lut, std::uint8_t *dst) {
+    const auto table = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(lut))
+    );
+    const auto base = _mm256_set1_epi8(static_cast<char>(first));
+    const auto last = _mm256_set1_epi8(15);
+
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        const auto index = _mm256_sub_epi8(v, base);
+        const auto in_range = _mm256_cmpeq_epi8(_mm256_min_epu8(index, last), index);
+        const auto remapped = _mm256_shuffle_epi8(table, index);
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(dst + i),
+            _mm256_blendv_epi8(v, remapped, in_range)
+        );
+    }
+    ssse3::remapRange(src + i, count - i, first, lut, dst + i);
+}
+
+// Unpack works within 128 bits lanes, store the lanes back in order.
+NR_TARGET("avx2") inline void
+store_interleaved(std::uint8_t *dst, __m256i lo, __m256i hi) {
+    const auto a = _mm256_unpacklo_epi8(lo, hi);
+    const auto b = _mm256_unpackhi_epi8(lo, hi);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), _mm256_permute2x128_si256(a, b, 0x31));
+}
+
+NR_TARGET("avx2") void
+doubleBytes(const std::uint8_t *src, std::size_t count, std::uint8_t *dst) {
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        store_interleaved(dst + 2*i, v, v);
+    }
+    sse2::doubleBytes(src + i, count - i, dst + 2*i);
+}
+
+NR_TARGET("avx2") std::uint8_t
+orAccumulate(std::uint8_t *dst, const std::uint8_t *src, std::size_t count) {
+    auto any = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_or_si256(a, b));
+        any = _mm256_or_si256(any, b);
+    }
+    const auto zero = _mm256_testz_si256(any, any);
+    return sse2::orAccumulate(dst + i, src + i, count - i) | (zero ? 0 : 1);
+}
+
+// Pack works within 128 bits lanes, the quadwords are put back in order.
+NR_TARGET("avx2") void
+packNibbles(const std::uint8_t *src, std::size_t count, std::uint8_t *dst) {
+    const auto low_byte = _mm256_set1_epi16(0x00ff);
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 2*i));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 2*i + 32));
+        const auto pa = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(a, low_byte), 4), _mm256_srli_epi16(a, 8));
+        const auto pb = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(b, low_byte), 4), _mm256_srli_epi16(b, 8));
+        const auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(pa, pb), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+    }
+    sse2::packNibbles(src + 2*i, count - i, dst + i);
+}
+
+NR_TARGET("avx2") void
+overlapCopy(std::uint8_t *dst, std::size_t distance, std::size_t count) {
+    const auto step = distance < 32 ? (31/distance + 1)*distance : distance;
+
+    std::size_t i = std::min(count, step - distance);
+    scalar::overlapCopy(dst, distance, i);
+    for (; i + 32 <= count; i += 32) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i - step));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+    }
+    sse2::overlapCopy(dst + i, distance, count - i);
+}
+
+// Colors are gathered as 32 bits words, then their first 3 bytes are packed
+// in each 128 bits lane. Both lanes are written with 16 bytes stores, their
+// last 4 bytes being overwritten by the next store.
+NR_TARGET("avx2") void
+expandPalette(const std::uint8_t *src, std::size_t count, const std::uint8_t *lut, std::uint8_t *dst) {
+    const auto pack = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+    );
+
+    std::size_t i = 0;
+    for (; i + 10 <= count; i += 8) {
+        const auto indexes = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i))
+        );
+        const auto offsets = _mm256_add_epi32(indexes, _mm256_slli_epi32(indexes, 1));
+        const auto colors = _mm256_shuffle_epi8(
+            _mm256_i32gather_epi32(reinterpret_cast<const int *>(lut), offsets, 1),
+            pack
+        );
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3*i), _mm256_castsi256_si128(colors));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3*i + 12), _mm256_extracti128_si256(colors, 1));
+    }
+    scalar::expandPalette(src + i, count - i, lut, dst + 3*i);
+}
+
+// Interpolate the samples at the given positions, relative to the sample
+// after base. Each gather reads the 4 bytes ending with the pair of
+// samples.
+NR_TARGET("avx2") inline __m256i
+resample_lanes(const std::uint8_t *base, __m256i positions) {
+    const auto low_byte = _mm256_set1_epi32(0xff);
+    const auto words = _mm256_srli_epi32(
+        _mm256_i32gather_epi32(
+            reinterpret_cast<const int *>(base),
+            _mm256_srli_epi32(positions, 16),
+            1
+        ),
+        16
+    );
+    const auto s0 = _mm256_and_si256(words, low_byte);
+    const auto diff = _mm256_sub_epi32(_mm256_srli_epi32(words, 8), s0);
+    const auto frac = _mm256_and_si256(positions, _mm256_set1_epi32(0xffff));
+    const auto delta = _mm256_srai_epi32(
+        _mm256_add_epi32(_mm256_mullo_epi32(diff, frac), _mm256_set1_epi32(0x8000)),
+        16
+    );
+    return _mm256_add_epi32(s0, delta);
+}
+
+// Positions of 16 samples are computed relative to the first one in 32
+// bits lanes, the samples before the third source sample and steps too
+// large for these lanes are left to SSE2.
+NR_TARGET("avx2") void
+resampleLinear(const std::uint8_t *src, std::uint64_t pos, std::uint64_t step, std::size_t count, std::uint8_t *dst) {
+    if (step >= (std::uint64_t{1} << 26)) {
+        sse2::resampleLinear(src, pos, step, count, dst);
+        return;
+    }
+
+    std::size_t i = 0;
+    while (i < count && ((pos + i*step) >> 16) < 2) {
+        ++i;
+    }
+    sse2::resampleLinear(src, pos, step, i, dst);
+    pos += i*step;
+
+    const auto offsets = _mm256_mullo_epi32(
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+        _mm256_set1_epi32(static_cast<int>(step))
+    );
+    const auto offsets8 = _mm256_set1_epi32(static_cast<int>(8*step));
+    for (; i + 16 <= count; i += 16) {
+        const auto base = src + (pos >> 16) - 2;
+        const auto p0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(pos & 0xffff)), offsets);
+        const auto p1 = _mm256_add_epi32(p0, offsets8);
+        const auto a = resample_lanes(base, p0);
+        const auto b = resample_lanes(base, p1);
+        pos += 16*step;
+
+        // Packs work within 128 bits lanes, put the quad words back in
+        // order after each of them.
+        const auto words = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xd8);
+        const auto bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm256_castsi256_si128(bytes));
+    }
+    sse2::resampleLinear(src, pos, step, count - i, dst + i);
+}
+
+NR_TARGET("avx2") void
+scale2xRow(
+    const std::uint8_t *above,
+    const std::uint8_t *row,
+    const std::uint8_t *below,
+    std::size_t width,
+    std::uint8_t *dst0,
+    std::uint8_t *dst1
+) {
+    if (width < 34) {
+        sse2::scale2xRow(above, row, below, width, dst0, dst1);
+        return;
+    }
+
+    std::size_t x = 1;
+    scalar::scale2xSpan(above, row, below, width, 0, x, dst0, dst1);
+    for (; x + 33 <= width; x += 32) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(above + x));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x + 1));
+        const auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x - 1));
+        const auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(below + x));
+        const auto p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x));
+
+        const auto edge = _mm256_andnot_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(b, c), _mm256_cmpeq_epi8(a, d)),
+            _mm256_set1_epi8(-1)
+        );
+        const auto e0 = _mm256_blendv_epi8(p, a, _mm256_and_si256(edge, _mm256_cmpeq_epi8(c, a)));
+        const auto e1 = _mm256_blendv_epi8(p, b, _mm256_and_si256(edge, _mm256_cmpeq_epi8(a, b)));
+        const auto e2 = _mm256_blendv_epi8(p, c, _mm256_and_si256(edge, _mm256_cmpeq_epi8(c, d)));
+        const auto e3 = _mm256_blendv_epi8(p, d, _mm256_and_si256(edge, _mm256_cmpeq_epi8(d, b)));
+
+        store_interleaved(dst0 + 2*x, e0, e1);
+        store_interleaved(dst1 + 2*x, e2, e3);
+    }
+    scalar::scale2xSpan(above, row, below, width, x, width, dst0, dst1);
+}
+
+} // namespace avx2
+
+} // namespace nr::dune2::simd
+
+#endif
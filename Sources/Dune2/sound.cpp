@@ -0,0 +1,95 @@
+#include "sound.hpp"
+#include "io.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+namespace {
+constexpr std::size_t wav_header_size = 44;
+} // namespace
+
+void
+resampleLinear(
+    const std::uint8_t *src,
+    std::size_t src_count,
+    std::uint8_t *dst,
+    std::size_t dst_count
+) {
+    if (dst_count == 0) {
+        return;
+    }
+    if (src_count == 0) {
+        std::fill_n(dst, dst_count, 0x80);
+        return;
+    }
+
+    // Positions in the source are 16.16 fixed point numbers.
+    const std::uint64_t step = (std::uint64_t{src_count} << 16)/dst_count;
+
+    // Samples before the last source sample are interpolated between two
+    // source samples, the following ones repeat the last source sample.
+    const auto last = std::min<std::size_t>(
+        dst_count,
+        ((std::uint64_t{src_count - 1} << 16) + step - 1)/step
+    );
+    simd::getKernels().resampleLinear(src, 0, step, last, dst);
+    std::fill(dst + last, dst + dst_count, src[src_count - 1]);
+}
+
+void
+Sound::resample(std::size_t sample_rate) {
+    if (sample_rate == 0) {
+        throw std::invalid_argument("invalid sample rate");
+    }
+    if (sample_rate == sampleRate_ || sampleRate_ == 0) {
+        sampleRate_ = sample_rate;
+        return;
+    }
+
+    std::vector<Sample> samples(samples_.size()*sample_rate/sampleRate_);
+    resampleLinear(samples_.data(), samples_.size(), samples.data(), samples.size());
+
+    sampleRate_ = sample_rate;
+    samples_ = std::move(samples);
+}
+
+std::size_t
+Sound::getWAVSize() const {
+    return wav_header_size + samples_.size();
+}
+
+void
+Sound::storeWAV(std::ostream &output) const {
+    trace::Span span("wav.write");
+
+    // RIFF header
+    output.write("RIFF", 4);
+    io::writeInteger<4>(output, getWAVSize() - 8);
+    output.write("WAVE", 4);
+
+    // Format chunk
+    output.write("fmt ", 4);
+    io::writeInteger<4>(output, 16u);          // chunk size
+    io::writeInteger<2>(output, 1u);           // PCM
+    io::writeInteger<2>(output, 1u);           // channels
+    io::writeInteger<4>(output, sampleRate_);  // sample rate
+    io::writeInteger<4>(output, sampleRate_);  // byte rate
+    io::writeInteger<2>(output, 1u);           // block align
+    io::writeInteger<2>(output, 8u);           // bits per sample
+
+    // Data chunk
+    output.write("data", 4);
+    io::writeInteger<4>(output, samples_.size());
+    storePCM(output);
+}
+
+void
+Sound::storePCM(std::ostream &output) const {
+    output.write(reinterpret_cast<const char *>(samples_.data()), samples_.size());
+}
+
+} // namespace nr::dune2
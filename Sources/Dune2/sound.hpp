@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class nr::dune2::Sound
+/// A mono sound made of unsigned 8 bits PCM samples, loaded from a Creative
+/// Voice (`.voc`) file.
+class Sound {
+public:
+    using Sample = std::uint8_t;
+
+public:
+    /// ### method `nr::dune2::Sound::loadFromVOC`
+    /// Load sound from the given `.voc` file.
+    /// #### Parameters
+    /// - `const std::filesystem::path &voc_path` - a path to `*.voc` file
+    void loadFromVOC(const std::filesystem::path &);
+
+    /// ### method `nr::dune2::Sound::loadFromVOC`
+    /// Load sound from the given `.voc` data stream.
+    /// Sound data, silence and repeat blocks are supported. Blocks with a
+    /// sample rate different from the first sound block are resampled. A
+    /// block repeated endlessly is played once.
+    /// #### Parameters
+    /// - `std::istream &input` - an input stream
+    void loadFromVOC(std::istream &);
+
+public:
+    /// ### method `nr::dune2::Sound.getSampleRate`
+    /// #### Return
+    /// `std::size_t` - the sample rate in Hz.
+    std::size_t getSampleRate() const
+    { return sampleRate_; }
+
+    /// ### method `nr::dune2::Sound.getSamples`
+    /// #### Return
+    /// `const std::vector<Sample> &` - the samples.
+    const std::vector<Sample> &getSamples() const
+    { return samples_; }
+
+    /// ### method `nr::dune2::Sound.resample`
+    /// Convert the samples to the given sample rate using linear
+    /// interpolation.
+    /// #### Parameters
+    /// - `std::size_t sample_rate` - the new sample rate in Hz
+    void resample(std::size_t sample_rate);
+
+public:
+    /// ### method `nr::dune2::Sound.getWAVSize`
+    /// #### Return
+    /// `std::size_t` - the number of bytes written by `storeWAV`.
+    std::size_t getWAVSize() const;
+
+    /// ### method `nr::dune2::Sound.storeWAV`
+    /// Write the sound as a `.wav` file on the given output stream.
+    /// #### Parameters
+    /// - `std::ostream &output` - an output stream
+    void storeWAV(std::ostream &) const;
+
+    /// ### method `nr::dune2::Sound.storePCM`
+    /// Write the raw samples on the given output stream.
+    /// #### Parameters
+    /// - `std::ostream &output` - an output stream
+    void storePCM(std::ostream &) const;
+
+private:
+    std::size_t sampleRate_{0};
+    std::vector<Sample> samples_;
+};
+
+/// ### function `nr::dune2::resampleLinear`
+/// Resample unsigned 8 bits samples using linear interpolation.
+/// #### Parameters
+/// - `const std::uint8_t *src, std::size_t src_count` - the source samples
+/// - `std::uint8_t *dst, std::size_t dst_count` - the destination samples
+void resampleLinear(const std::uint8_t *src, std::size_t src_count, std::uint8_t *dst, std::size_t dst_count);
+} // namespace nr::dune2
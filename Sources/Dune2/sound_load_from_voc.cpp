@@ -0,0 +1,223 @@
+#include "sound.hpp"
+#include "io.hpp"
+#include "trace.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std::literals::string_view_literals;
+
+namespace nr::dune2 {
+
+namespace {
+
+enum VOCBlockType : std::uint8_t {
+    Terminator = 0,
+    SoundData = 1,
+    SoundContinuation = 2,
+    Silence = 3,
+    Marker = 4,
+    Text = 5,
+    RepeatStart = 6,
+    RepeatEnd = 7,
+    Extended = 8,
+    NewSoundData = 9,
+};
+
+constexpr std::uint16_t voc_repeat_forever = 0xffff;
+constexpr Sound::Sample voc_silence_sample = 0x80;
+
+constexpr std::size_t
+voc_sample_rate(std::uint8_t frequency_divisor) {
+    return 1000000/(256 - frequency_divisor);
+}
+
+// Append samples, resampled to the sound sample rate.
+void
+append_samples(
+    std::vector<Sound::Sample> &samples,
+    std::size_t sample_rate,
+    const Sound::Sample *data,
+    std::size_t count,
+    std::size_t data_sample_rate
+) {
+    if (data_sample_rate == sample_rate) {
+        samples.insert(samples.end(), data, data + count);
+    } else {
+        const auto resampled_count = count*sample_rate/data_sample_rate;
+        const auto pos = samples.size();
+        samples.resize(pos + resampled_count);
+        resampleLinear(data, count, samples.data() + pos, resampled_count);
+    }
+}
+} // namespace
+
+void
+Sound::loadFromVOC(const std::filesystem::path &voc_path) {
+    std::ifstream input(voc_path, std::ios::binary);
+    input.exceptions(std::ios::failbit|std::ios::badbit);
+    loadFromVOC(input);
+}
+
+void
+Sound::loadFromVOC(std::istream &voc_input) {
+    trace::Span span("decode.voc");
+
+    const auto data = io::readAll(voc_input);
+
+    io::IMemoryStream input(data);
+    input.exceptions(std::ios::failbit);
+
+    io::check(input, []{ return "Creative Voice File\x1a"sv; });
+
+    const auto header_size = io::readLEInteger<2>(input);
+    const auto version = io::readLEInteger<2>(input);
+    const auto checksum = io::readLEInteger<2>(input);
+    if (checksum != ((~version + 0x1234) & 0xffff) || header_size > data.size()) {
+        throw std::invalid_argument("corrupted file");
+    }
+    input.seekg(header_size);
+
+    std::size_t sample_rate{0};
+    std::size_t block_sample_rate{0};
+    std::size_t extended_sample_rate{0};
+    std::vector<Sample> samples;
+
+    std::size_t repeat_start{0};
+    std::uint16_t repeat_count{0};
+
+    const auto set_sample_rate = [&](std::size_t rate) {
+        if (rate == 0) {
+            throw std::invalid_argument("corrupted file");
+        }
+        if (sample_rate == 0) {
+            sample_rate = rate;
+        }
+        block_sample_rate = rate;
+    };
+
+    const auto read_samples = [&](std::size_t count) {
+        const auto pos = static_cast<std::size_t>(input.tellg());
+        if (count > data.size() - pos) {
+            throw std::invalid_argument("corrupted file");
+        }
+        append_samples(
+            samples,
+            sample_rate,
+            reinterpret_cast<const Sample *>(data.data() + pos),
+            count,
+            block_sample_rate
+        );
+        input.seekg(count, std::ios::cur);
+    };
+
+    for (;;) {
+        const auto type = io::readLEInteger<1, std::uint8_t>(input);
+        if (type == Terminator) {
+            break;
+        }
+
+        const auto size = io::readLEInteger<3, std::size_t>(input);
+        const auto block_end = static_cast<std::size_t>(input.tellg()) + size;
+        if (block_end > data.size()) {
+            throw std::invalid_argument("corrupted file");
+        }
+
+        switch (type) {
+        case SoundData: {
+            if (size < 2) {
+                throw std::invalid_argument("corrupted file");
+            }
+            const auto frequency_divisor = io::readLEInteger<1, std::uint8_t>(input);
+            const auto codec = io::readLEInteger<1, std::uint8_t>(input);
+            if (codec != 0) {
+                throw std::invalid_argument("unsupported codec");
+            }
+            set_sample_rate(extended_sample_rate
+                ? extended_sample_rate
+                : voc_sample_rate(frequency_divisor));
+            extended_sample_rate = 0;
+            read_samples(size - 2);
+            break;
+        }
+
+        case SoundContinuation:
+            if (block_sample_rate == 0) {
+                throw std::invalid_argument("corrupted file");
+            }
+            read_samples(size);
+            break;
+
+        case Silence: {
+            const auto length = io::readLEInteger<2, std::size_t>(input) + 1;
+            const auto rate = voc_sample_rate(io::readLEInteger<1, std::uint8_t>(input));
+            if (sample_rate == 0) {
+                sample_rate = rate;
+            }
+            samples.insert(samples.end(), length*sample_rate/rate, voc_silence_sample);
+            break;
+        }
+
+        case RepeatStart:
+            repeat_start = samples.size();
+            repeat_count = io::readLEInteger<2, std::uint16_t>(input);
+            break;
+
+        case RepeatEnd:
+            if (repeat_count != voc_repeat_forever) {
+                const auto repeat_end = samples.size();
+                samples.reserve(repeat_end + (repeat_end - repeat_start)*repeat_count);
+                for (auto i = 0u; i < repeat_count; ++i) {
+                    samples.insert(
+                        samples.end(),
+                        samples.begin() + repeat_start,
+                        samples.begin() + repeat_end
+                    );
+                }
+            }
+            repeat_count = 0;
+            break;
+
+        case Extended: {
+            const auto time_constant = io::readLEInteger<2, std::size_t>(input);
+            const auto pack = io::readLEInteger<1, std::uint8_t>(input);
+            const auto mode = io::readLEInteger<1, std::uint8_t>(input);
+            if (pack != 0 || mode != 0) {
+                throw std::invalid_argument("unsupported codec");
+            }
+            extended_sample_rate = 256000000/(65536 - time_constant);
+            break;
+        }
+
+        case NewSoundData: {
+            if (size < 12) {
+                throw std::invalid_argument("corrupted file");
+            }
+            const auto rate = io::readLEInteger<4, std::size_t>(input);
+            const auto bits = io::readLEInteger<1, std::uint8_t>(input);
+            const auto channels = io::readLEInteger<1, std::uint8_t>(input);
+            const auto codec = io::readLEInteger<2, std::uint16_t>(input);
+            if (bits != 8 || channels != 1 || codec != 0) {
+                throw std::invalid_argument("unsupported codec");
+            }
+            input.seekg(4, std::ios::cur);
+            set_sample_rate(rate);
+            read_samples(size - 12);
+            break;
+        }
+
+        case Marker:
+        case Text:
+        default:
+            break;
+        }
+
+        input.seekg(block_end);
+    }
+
+    sampleRate_ = sample_rate;
+    samples_ = std::move(samples);
+}
+
+} // namespace nr::dune2
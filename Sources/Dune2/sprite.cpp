@@ -0,0 +1,106 @@
+#include "sprite.hpp"
+#include "trace.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+Sprite::Sprite()
+    : width_{0}
+    , height_{0}
+    , rows_(1, 0) {
+}
+
+Sprite::Sprite(const Image &image)
+    : width_{image.getWidth()}
+    , height_{image.getHeight()} {
+    trace::Span span("sprite.create");
+
+    if (width_ > std::numeric_limits<std::uint16_t>::max()) {
+        throw std::length_error("sprite too large");
+    }
+
+    // Rows outside of the data box of a trimmed image have no span.
+    const auto data = reinterpret_cast<const std::uint8_t *>(image.getData().data());
+    const auto left = image.getLeft();
+    const auto top = image.getTop();
+    const auto data_width = image.getDataWidth();
+    const auto data_height = image.getDataHeight();
+
+    rows_.reserve(height_ + 1);
+    rows_.push_back(0);
+    for (auto y = 0u; y < height_; ++y) {
+        if (y < top || y >= top + data_height) {
+            rows_.push_back(spans_.size());
+            continue;
+        }
+        const auto row = data + (y - top)*data_width;
+        for (auto x = 0u; x < data_width;) {
+            if (row[x] == 0) {
+                ++x;
+                continue;
+            }
+            const auto begin = x;
+            while (x < data_width && row[x] != 0) {
+                ++x;
+            }
+            spans_.push_back(Span{
+                std::uint16_t(left + begin),
+                std::uint16_t(x - begin),
+                std::uint32_t(pixels_.size())
+            });
+            pixels_.append(reinterpret_cast<const char *>(row + begin), x - begin);
+        }
+        rows_.push_back(spans_.size());
+    }
+
+    // Tables shorter than 256 entries leave the other colors unchanged.
+    if (image.hasRemapTable()) {
+        const auto &table = image.getRemapTableData();
+        remapTable_.resize(256);
+        for (auto i = 0u; i < 256; ++i) {
+            remapTable_[i] = i < table.size() ? table[i] : char(i);
+        }
+    }
+}
+
+size_t
+Sprite::getPixel(size_t x, size_t y) const {
+    const auto [first, last] = getRowSpans(y);
+    const auto span = std::upper_bound(first, last, x, [](size_t x, const Span &span) {
+        return x < span.x;
+    });
+    if (span == first || x >= size_t((span - 1)->x + (span - 1)->length)) {
+        return 0;
+    }
+
+    const auto pixel = std::uint8_t(pixels_[(span - 1)->offset + x - (span - 1)->x]);
+    return remapTable_.empty() ? pixel : std::uint8_t(remapTable_[pixel]);
+}
+
+void
+Sprite::blit(
+    std::uint8_t *dst,
+    size_t dst_width,
+    size_t dst_height,
+    size_t dst_pitch,
+    std::ptrdiff_t x,
+    std::ptrdiff_t y
+) const {
+    const auto remap = reinterpret_cast<const std::uint8_t *>(remapTable_.data());
+
+    forEachSpan(x, y, dst_width, dst_height, [&](size_t x, size_t y, const std::uint8_t *pixels, size_t count) {
+        auto out = dst + y*dst_pitch + x;
+        if (remapTable_.empty()) {
+            std::memcpy(out, pixels, count);
+        } else {
+            for (auto i = 0u; i < count; ++i) {
+                out[i] = remap[pixels[i]];
+            }
+        }
+    });
+}
+
+} // namespace nr::dune2
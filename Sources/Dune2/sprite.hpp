@@ -0,0 +1,168 @@
+#pragma once
+
+#include <Dune2/image.hpp>
+#include <Dune2/surface.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::Sprite`
+/// An image stored as runs of opaque pixels, the color `0` being
+/// transparent. Each row is a list of spans of consecutive opaque pixels, so
+/// that drawing a sprite costs in proportion to its visible pixels and not
+/// to its size.
+///
+/// Pixels are kept as raw color indexes, the remap table of the image they
+/// come from is applied when the sprite is drawn.
+///
+/// `nr::dune2::Sprite` implements `nr::dune2::Surface`.
+/// See [`nr::dune2::Surface`](/docs/nr/dune2/surface) for more details.
+class Sprite : public Surface {
+public:
+    /// ### struct `nr::dune2::Sprite::Span`
+    /// - `x` - the column of the first pixel of the span
+    /// - `length` - the number of pixels of the span
+    /// - `offset` - the index of the first pixel of the span in `getPixels()`
+    struct Span {
+        std::uint16_t x;
+        std::uint16_t length;
+        std::uint32_t offset;
+    };
+
+public:
+    Sprite();
+
+    /// ### constructor `nr::dune2::Sprite`
+    /// Build a sprite from an image.
+    /// #### Parameters
+    /// - `const Image &image` - an image
+    explicit Sprite(const Image &);
+
+public:
+    /// ### method `nr::dune2::Sprite.getWidth`
+    /// See [`nr::dune2::Surface.getWidth`](/docs/nr/dune2/surface#getWidth)
+    /// for more details.
+    virtual size_t getWidth() const override
+    { return width_; }
+
+    /// ### method `nr::dune2::Sprite.getHeight`
+    /// See [`nr::dune2::Surface.getHeight`](/docs/nr/dune2/surface#getHeight)
+    /// for more details.
+    virtual size_t getHeight() const override
+    { return height_; }
+
+    /// ### method `nr::dune2::Sprite.getPixel`
+    /// See [`nr::dune2::Surface.getPixel`](/docs/nr/dune2/surface#getPixel)
+    /// for more details. This is a binary search in the row spans, prefer
+    /// `blit` or `forEachSpan` to draw a sprite.
+    virtual size_t getPixel(size_t x, size_t y) const override;
+
+    /// ### method `nr::dune2::Sprite.getOpaquePixelCount`
+    /// #### Return
+    /// `size_t` - the number of opaque pixels.
+    size_t getOpaquePixelCount() const
+    { return pixels_.size(); }
+
+    /// ### method `nr::dune2::Sprite.getPixels`
+    /// #### Return
+    /// `const std::string &` - the raw color indexes of the opaque pixels,
+    /// row by row.
+    const std::string &getPixels() const
+    { return pixels_; }
+
+    /// ### method `nr::dune2::Sprite.getRemapTable`
+    /// #### Return
+    /// `const std::string &` - the 256 entries remap table, empty if the
+    /// sprite has none.
+    const std::string &getRemapTable() const
+    { return remapTable_; }
+
+    /// ### method `nr::dune2::Sprite.getRowSpans`
+    /// #### Parameters
+    /// - `size_t y` - a row
+    /// #### Return
+    /// `std::pair<const Span *, const Span *>` - the spans of the row, from
+    /// left to right.
+    std::pair<const Span *, const Span *> getRowSpans(size_t y) const
+    { return {spans_.data() + rows_[y], spans_.data() + rows_[y + 1]}; }
+
+public:
+    /// ### method `nr::dune2::Sprite.forEachSpan`
+    /// Call `fn(dst_x, dst_y, pixels, length)` for each opaque span of the
+    /// sprite drawn at _(x, y)_ on a destination of the given size, clipped
+    /// to the destination. `pixels` are raw color indexes.
+    /// #### Parameters
+    /// - `std::ptrdiff_t x` - the destination column of the sprite left side
+    /// - `std::ptrdiff_t y` - the destination row of the sprite top side
+    /// - `size_t dst_width` - the destination width
+    /// - `size_t dst_height` - the destination height
+    /// - `F &&fn` - the function to call
+    template <typename F>
+    void forEachSpan(
+        std::ptrdiff_t x, std::ptrdiff_t y,
+        size_t dst_width, size_t dst_height,
+        F &&fn
+    ) const {
+        const auto w = std::ptrdiff_t(dst_width);
+        const auto h = std::ptrdiff_t(dst_height);
+
+        const auto row_first = std::max<std::ptrdiff_t>(0, -y);
+        const auto row_last = std::min<std::ptrdiff_t>(height_, h - y);
+
+        for (auto row = row_first; row < row_last; ++row) {
+            const auto [first, last] = getRowSpans(row);
+            for (auto span = first; span != last; ++span) {
+                auto begin = x + span->x;
+                auto end = begin + span->length;
+                if (end <= 0) {
+                    continue;
+                }
+                if (begin >= w) {
+                    break;
+                }
+                const auto skip = std::max<std::ptrdiff_t>(0, -begin);
+                begin += skip;
+                end = std::min(end, w);
+                fn(
+                    size_t(begin),
+                    size_t(y + row),
+                    reinterpret_cast<const std::uint8_t *>(pixels_.data()) + span->offset + skip,
+                    size_t(end - begin)
+                );
+            }
+        }
+    }
+
+    /// ### method `nr::dune2::Sprite.blit`
+    /// Draw the sprite on an 8 bits indexed destination. Transparent pixels
+    /// are left untouched, the remap table is applied to opaque pixels.
+    /// #### Parameters
+    /// - `std::uint8_t *dst` - the destination pixels, row by row
+    /// - `size_t dst_width` - the destination width
+    /// - `size_t dst_height` - the destination height
+    /// - `size_t dst_pitch` - the number of bytes between two rows
+    /// - `std::ptrdiff_t x` - the destination column of the sprite left side
+    /// - `std::ptrdiff_t y` - the destination row of the sprite top side
+    void blit(
+        std::uint8_t *dst,
+        size_t dst_width,
+        size_t dst_height,
+        size_t dst_pitch,
+        std::ptrdiff_t x,
+        std::ptrdiff_t y
+    ) const;
+
+private:
+    size_t width_;
+    size_t height_;
+    std::vector<std::uint32_t> rows_;
+    std::vector<Span> spans_;
+    std::string pixels_;
+    std::string remapTable_;
+};
+} // namespace nr::dune2
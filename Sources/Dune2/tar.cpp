@@ -0,0 +1,129 @@
+#include "tar.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace nr::dune2 {
+
+namespace {
+
+constexpr std::size_t tar_block_size = 512;
+
+using TarBlock = std::array<char, tar_block_size>;
+
+void
+tar_write_octal(char *field, std::size_t field_size, std::uint64_t value) {
+    // Octal digits followed by a NUL character.
+    field[--field_size] = '\0';
+    while (field_size > 0) {
+        field[--field_size] = '0' + (value & 7);
+        value >>= 3;
+    }
+    if (value != 0) {
+        throw std::out_of_range("value too large for tar header field");
+    }
+}
+
+void
+tar_write_name(TarBlock &header, const std::string &name) {
+    char *name_field   = header.data();
+    char *prefix_field = header.data() + 345;
+
+    if (name.size() <= 100) {
+        std::copy(name.begin(), name.end(), name_field);
+        return;
+    }
+
+    // Split long names on a '/' into the prefix (155) and name (100) fields.
+    const auto pos = name.find('/', name.size() - std::min<std::size_t>(name.size(), 101));
+    if (pos == std::string::npos || pos > 155 || name.size() - pos - 1 > 100) {
+        throw std::invalid_argument("name too long for a tar entry: " + name);
+    }
+    std::copy(name.begin(), name.begin() + pos, prefix_field);
+    std::copy(name.begin() + pos + 1, name.end(), name_field);
+}
+
+TarBlock
+tar_header(const std::string &name, std::size_t size) {
+    using std::chrono::system_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::seconds;
+
+    const auto mtime = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+
+    TarBlock header{};
+
+    tar_write_name(header, name);
+    tar_write_octal(header.data() + 100,  8, 0644);  // mode
+    tar_write_octal(header.data() + 108,  8, 0);     // uid
+    tar_write_octal(header.data() + 116,  8, 0);     // gid
+    tar_write_octal(header.data() + 124, 12, size);  // size
+    tar_write_octal(header.data() + 136, 12, mtime); // mtime
+    header[156] = '0';                               // regular file
+    std::memcpy(header.data() + 257, "ustar", 6);    // magic
+    std::memcpy(header.data() + 263, "00", 2);       // version
+
+    // The checksum is computed with its own field filled with spaces.
+    std::fill_n(header.data() + 148, 8, ' ');
+    const auto checksum = std::accumulate(
+        header.begin(),
+        header.end(),
+        0u,
+        [](auto sum, char c) { return sum + static_cast<unsigned char>(c); }
+    );
+    tar_write_octal(header.data() + 148, 7, checksum);
+
+    return header;
+}
+
+} // namespace
+
+TarWriter::TarWriter(std::ostream &output)
+    : output_{output}
+    , closed_{false} {
+}
+
+TarWriter::~TarWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void
+TarWriter::append(
+    const std::string &name,
+    std::size_t size,
+    const DataWriter &write) {
+    if (closed_) {
+        throw std::logic_error("tar archive is closed");
+    }
+
+    const auto header = tar_header(name, size);
+    output_.write(header.data(), header.size());
+
+    write(output_);
+
+    // Entry data is padded to a multiple of the block size.
+    const auto padding = (tar_block_size - size%tar_block_size)%tar_block_size;
+    std::fill_n(std::ostreambuf_iterator<char>(output_), padding, '\0');
+}
+
+void
+TarWriter::close() {
+    if (!closed_) {
+        closed_ = true;
+
+        // The end of an archive is marked by two zero-filled blocks.
+        const TarBlock zeros{};
+        output_.write(zeros.data(), zeros.size());
+        output_.write(zeros.data(), zeros.size());
+        output_.flush();
+    }
+}
+
+} // namespace nr::dune2
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace nr::dune2 {
+/// ### class `nr::dune2::TarWriter`
+/// Write an uncompressed _ustar_ archive on an output stream.
+/// Each entry header is written inline, immediately followed by the entry
+/// data, so the output stream does not need to be seekable.
+class TarWriter {
+public:
+    using DataWriter = std::function<void(std::ostream &)>;
+
+public:
+    explicit TarWriter(std::ostream &);
+    ~TarWriter();
+
+    TarWriter(const TarWriter &) = delete;
+    TarWriter &operator=(const TarWriter &) = delete;
+
+public:
+    /// ### method `nr::dune2::TarWriter.append`
+    /// Append a regular file entry to the archive.
+    /// #### Parameters
+    /// - `const std::string &name` - the entry name
+    /// - `std::size_t size` - the exact number of bytes `write` will produce
+    /// - `const DataWriter &write` - a function writing the entry data
+    void append(const std::string &name, std::size_t size, const DataWriter &);
+
+    /// ### method `nr::dune2::TarWriter.close`
+    /// Write the end of archive marker. No entry can be appended after.
+    void close();
+
+private:
+    std::ostream &output_;
+    bool closed_;
+};
+} // namespace nr::dune2
@@ -0,0 +1,198 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace nr::dune2::trace {
+
+namespace detail {
+std::atomic<bool> enabled{false};
+} // namespace detail
+
+namespace {
+using Clock = std::chrono::steady_clock;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+struct Event {
+    const char *name;
+    Clock::time_point start;
+    Clock::time_point end;
+};
+
+// The events of one thread. Only the owning thread appends events, the lock
+// is there for the readers.
+struct ThreadEvents {
+    std::size_t id;
+    std::mutex mutex;
+    std::vector<Event> events;
+};
+
+struct Registry {
+    std::mutex mutex;
+    Clock::time_point origin;
+    std::vector<std::shared_ptr<ThreadEvents>> threads;
+};
+
+Registry &
+registry() {
+    static Registry registry;
+    return registry;
+}
+
+ThreadEvents &
+thread_events() {
+    thread_local const auto events = [] {
+        auto &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto events = std::make_shared<ThreadEvents>();
+        events->id = reg.threads.size() + 1;
+        reg.threads.push_back(events);
+        return events;
+    }();
+    return *events;
+}
+
+// Call fn(thread_id, event) for each recorded event.
+template<typename F>
+void
+for_each_event(F &&fn) {
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &thread: reg.threads) {
+        std::lock_guard<std::mutex> thread_lock(thread->mutex);
+        for (const auto &event: thread->events) {
+            fn(thread->id, event);
+        }
+    }
+}
+} // namespace
+
+void
+enable() {
+    auto &reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if (!detail::enabled) {
+            reg.origin = Clock::now();
+        }
+    }
+    detail::enabled = true;
+}
+
+std::string_view
+getCategory(std::string_view name) {
+    return name.substr(0, name.find('.'));
+}
+
+void
+Span::begin(const char *name) {
+    name_ = name;
+    if (memory::isEnabled()) {
+        scope_.emplace(getCategory(name));
+    }
+    if (isEnabled()) {
+        recording_ = true;
+        start_ = Clock::now();
+    }
+}
+
+void
+Span::end() {
+    if (recording_) {
+        auto &events = thread_events();
+        std::lock_guard<std::mutex> lock(events.mutex);
+        events.events.push_back(Event{name_, start_, Clock::now()});
+    }
+    scope_.reset();
+}
+
+rapidjson::Document
+toJSON() {
+    using rapidjson::Value;
+
+    rapidjson::Document doc;
+    auto &allocator = doc.GetAllocator();
+
+    const auto origin = registry().origin;
+    const auto us = [&](Clock::duration d) {
+        return Value(static_cast<int64_t>(duration_cast<microseconds>(d).count()));
+    };
+
+    Value events(rapidjson::kArrayType);
+    std::size_t thread_count = 0;
+    for_each_event([&](std::size_t thread_id, const Event &event) {
+        Value value(rapidjson::kObjectType);
+        value.AddMember("name", rapidjson::StringRef(event.name), allocator);
+        const auto category = getCategory(event.name);
+        value.AddMember(
+            "cat",
+            Value().SetString(
+                category.data(),
+                static_cast<rapidjson::SizeType>(category.size()),
+                allocator
+            ),
+            allocator
+        );
+        value.AddMember("ph", "X", allocator);
+        value.AddMember("ts", us(event.start - origin), allocator);
+        value.AddMember("dur", us(event.end - event.start), allocator);
+        value.AddMember("pid", 1, allocator);
+        value.AddMember("tid", Value(static_cast<uint64_t>(thread_id)), allocator);
+        events.PushBack(value, allocator);
+        thread_count = std::max(thread_count, thread_id);
+    });
+
+    // Name the tracks, the first thread recording a span is usually the main
+    // thread.
+    for (std::size_t thread_id = 1; thread_id <= thread_count; ++thread_id) {
+        const auto thread_name = thread_id == 1
+            ? std::string("main")
+            : "thread " + std::to_string(thread_id);
+        Value name;
+        name.SetString(
+            thread_name.c_str(),
+            static_cast<rapidjson::SizeType>(thread_name.size()),
+            allocator
+        );
+        Value args(rapidjson::kObjectType);
+        args.AddMember("name", name, allocator);
+
+        Value value(rapidjson::kObjectType);
+        value.AddMember("name", "thread_name", allocator);
+        value.AddMember("ph", "M", allocator);
+        value.AddMember("pid", 1, allocator);
+        value.AddMember("tid", Value(static_cast<uint64_t>(thread_id)), allocator);
+        value.AddMember("args", args, allocator);
+        events.PushBack(value, allocator);
+    }
+
+    doc.SetObject();
+    doc.AddMember("traceEvents", events, allocator);
+    doc.AddMember("displayTimeUnit", "ms", allocator);
+
+    return doc;
+}
+
+std::vector<Phase>
+getPhases() {
+    std::map<std::string, Phase> phases;
+    for_each_event([&](std::size_t, const Event &event) {
+        auto &phase = phases.try_emplace(event.name, Phase{event.name, 0, {}}).first->second;
+        phase.count += 1;
+        phase.duration += duration_cast<microseconds>(event.end - event.start);
+    });
+
+    std::vector<Phase> result;
+    for (auto &item: phases) {
+        result.push_back(std::move(item.second));
+    }
+    std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
+        return a.duration > b.duration;
+    });
+    return result;
+}
+
+} // namespace nr::dune2::trace
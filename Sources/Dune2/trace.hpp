@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Dune2/memory.hpp>
+
+#include <rapidjson/document.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nr::dune2::trace {
+/// ### struct `nr::dune2::trace::Phase`
+/// The accumulated duration of the spans of a given name.
+struct Phase {
+    std::string name;
+    std::size_t count;
+    std::chrono::microseconds duration;
+};
+
+/// ### function `nr::dune2::trace::enable`
+/// Start recording spans. Spans are recorded per thread until the end of the
+/// process.
+void enable();
+
+/// ### function `nr::dune2::trace::isEnabled`
+/// #### Return
+/// `bool` - `true` if spans are recorded.
+bool isEnabled();
+
+/// ### function `nr::dune2::trace::toJSON`
+/// Transform the recorded spans to a Chrome `trace_event` document, with one
+/// track per thread. The document can be loaded in `chrome://tracing` or in
+/// Perfetto.
+/// #### Return
+/// `rapidjson::Document` - a json document
+rapidjson::Document toJSON();
+
+/// ### function `nr::dune2::trace::getPhases`
+/// #### Return
+/// `std::vector<Phase>` - the recorded spans grouped by name, sorted by
+/// decreasing duration.
+std::vector<Phase> getPhases();
+
+/// ### class `nr::dune2::trace::Span`
+/// Record the lifetime of a scope on the current thread. The span name is
+/// made of a category and a label separated by a dot, e.g. `decode.lcw`.
+/// When memory accounting is enabled, the allocations made during the span
+/// are attributed to its category.
+///
+/// When both tracing and memory accounting are disabled, a span costs two
+/// relaxed atomic loads.
+class Span {
+public:
+    /// ### constructor `nr::dune2::trace::Span`
+    /// #### Parameters
+    /// - `const char *name` - the span name, it must be a string literal
+    explicit Span(const char *name) {
+        if (isEnabled() || memory::isEnabled()) {
+            begin(name);
+        }
+    }
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+    ~Span() {
+        if (name_ != nullptr) {
+            end();
+        }
+    }
+
+private:
+    void begin(const char *name);
+    void end();
+
+private:
+    const char *name_{nullptr};
+    bool recording_{false};
+    std::chrono::steady_clock::time_point start_;
+    std::optional<memory::Scope> scope_;
+};
+
+/// ### function `nr::dune2::trace::getCategory`
+/// #### Parameters
+/// - `std::string_view name` - a span name
+/// #### Return
+/// `std::string_view` - the category of the span name.
+std::string_view getCategory(std::string_view name);
+
+namespace detail {
+extern std::atomic<bool> enabled;
+} // namespace detail
+
+inline bool
+isEnabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+} // namespace nr::dune2::trace
@@ -1,3 +1,4 @@
+#include <Dune2/catalog.hpp>
 #include <Dune2/io.hpp>
 #include <Dune2/pak.hpp>
 
@@ -7,10 +8,84 @@
 
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+namespace {
+struct Entry {
+    std::string name;
+    size_t size;
+    std::function<std::string()> read;
+};
+
+// List the entries of a PAK file.
+std::vector<Entry>
+list_pak_entries(const fs::path &filepath) {
+    auto pak = std::make_shared<nr::dune2::PAK>();
+
+    try {
+        pak->load(filepath);
+    } catch (...) {
+        throw CLI::Error(
+            "PAKFailure",
+            fmt::format("Failed to load '{}'", filepath.string())
+        );
+    }
+
+    std::vector<Entry> entries;
+    for (const auto &entry: *pak) {
+        entries.push_back(Entry{entry.name, entry.size, [pak, &entry] {
+            return entry.read();
+        }});
+    }
+    return entries;
+}
+
+// List the named entries of a catalog, the whole catalog if no name is given.
+std::vector<Entry>
+list_catalog_entries(const fs::path &filepath, const std::vector<std::string> &names) {
+    auto catalog = std::make_shared<nr::dune2::Catalog>();
+
+    try {
+        catalog->load(filepath);
+    } catch (...) {
+        throw CLI::Error(
+            "CatalogFailure",
+            fmt::format("Failed to load '{}'", filepath.string())
+        );
+    }
+
+    std::vector<Entry> entries;
+    const auto push_entry = [&](const nr::dune2::Catalog::Entry &entry) {
+        entries.push_back(Entry{std::string(entry.name), entry.size, [catalog, entry] {
+            return catalog->read(entry);
+        }});
+    };
+
+    if (names.empty()) {
+        for (auto i = 0u; i < catalog->getEntryCount(); ++i) {
+            push_entry(catalog->getEntry(i));
+        }
+    }
+    for (const auto &name: names) {
+        const auto entry = catalog->find(name);
+        if (!entry) {
+            throw CLI::Error(
+                "CatalogFailure",
+                fmt::format("'{}' not found in '{}'", name, filepath.string())
+            );
+        }
+        push_entry(*entry);
+    }
+    return entries;
+}
+} // namespace
+
 int
 main(int argc, char const *argv[]) {
     CLI::App app{"Dune2 PAK file extractor"};
@@ -18,36 +93,51 @@ main(int argc, char const *argv[]) {
     bool list{false};
     bool verbose{false};
     fs::path output_dir{fs::current_path()};
-    nr::dune2::PAK pak;
+    std::optional<fs::path> catalog_filepath;
+    std::vector<std::string> sources;
 
     app.add_flag("-l,--list", list, "List file");
     app.add_flag("-v,--verbose", verbose, "Produce verbose output");
     app.add_option("-d,--output-dir", output_dir, "Set output directory");
-
     app.add_option_function<fs::path>(
-        "filepath",
+        "-c,--catalog",
         [&](const fs::path &filepath) {
-            try {
-                pak.load(filepath);
-            } catch (...) {
-                throw CLI::Error(
-                    "PAKFailure",
-                    fmt::format("Failed to load '{}'", filepath.string())
-                );
-            }
+            catalog_filepath = filepath;
         },
-        "Path to an existing PAK file"
-    )->required()->check(CLI::ExistingFile);
+        "Extract the given entries through a catalog made by 'dune2-rc-toolkit catalog update'"
+    )->check(CLI::ExistingFile);
+
+    app.add_option(
+        "sources",
+        sources,
+        "Path to an existing PAK file, or entry names with --catalog"
+    );
 
     CLI11_PARSE(app, argc, argv);
 
+    std::vector<Entry> entries;
+    try {
+        if (catalog_filepath) {
+            entries = list_catalog_entries(*catalog_filepath, sources);
+        } else if (sources.size() == 1 && fs::is_regular_file(sources.front())) {
+            entries = list_pak_entries(sources.front());
+        } else {
+            throw CLI::ValidationError(
+                "sources",
+                "Expected the path to an existing PAK file"
+            );
+        }
+    } catch (const CLI::Error &e) {
+        return app.exit(e);
+    }
+
     if (list) {
-        for (const auto &entry: pak) {
+        for (const auto &entry: entries) {
             std::cout << entry.name << " " << entry.size << std::endl;
         }
     } else {
         fs::create_directories(output_dir);
-        for (const auto &entry: pak) {
+        for (const auto &entry: entries) {
             auto out = std::fstream(
                 output_dir/entry.name,
                 std::ios::binary | std::ios::out | std::ios::trunc
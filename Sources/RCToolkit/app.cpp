@@ -1,12 +1,195 @@
 #include "app.hpp"
 
+#include <Dune2/gzip.hpp>
+
 #include <fmt/format.h>
 
+#include <fstream>
+#include <iostream>
 #include <regex>
+#include <sstream>
 
 namespace nr {
 namespace fs = std::filesystem;
 
+dune2::Executor &
+getExecutor(AppState &app_state) {
+    if (!app_state.executor) {
+        app_state.executor = std::make_shared<dune2::Executor>(app_state.jobs);
+    }
+    return *app_state.executor;
+}
+
+const dune2::Catalog *
+getCatalog(AppState &app_state) {
+    if (!app_state.catalog && app_state.catalogFilepath) {
+        auto catalog = std::make_shared<dune2::Catalog>();
+        try {
+            catalog->load(*app_state.catalogFilepath);
+        } catch (const std::exception &err) {
+            throw CLI::Error(
+                "CatalogFailure",
+                fmt::format("Failed to load '{}': {}", app_state.catalogFilepath->string(), err.what()),
+                CLI::ExitCodes::FileError
+            );
+        }
+        app_state.catalog = std::move(catalog);
+    }
+    return app_state.catalog.get();
+}
+
+std::unique_ptr<std::istream>
+openAsset(AppState &app_state, const fs::path &source) {
+    std::unique_ptr<std::istream> input;
+
+    const auto catalog = fs::exists(source) ? nullptr : getCatalog(app_state);
+    const auto entry = catalog
+        ? catalog->find(source.filename().string())
+        : std::nullopt;
+
+    if (entry) {
+        input = std::make_unique<std::istringstream>(
+            catalog->read(*entry),
+            std::ios::binary
+        );
+    } else {
+        input = std::make_unique<std::ifstream>(source, std::ios::binary);
+    }
+    if (!*input) {
+        throw CLI::Error(
+            "FileError",
+            fmt::format("Failed to open '{}'", source.string()),
+            CLI::ExitCodes::FileError
+        );
+    }
+    input->exceptions(std::ios::failbit);
+    return input;
+}
+
+CLI::Validator
+existingAsset(AppState &app_state) {
+    return CLI::Validator(
+        [&app_state](std::string &filepath) -> std::string {
+            if (fs::is_regular_file(filepath)) {
+                return {};
+            }
+            const auto catalog = getCatalog(app_state);
+            if (catalog && catalog->find(fs::path(filepath).filename().string())) {
+                return {};
+            }
+            return fmt::format("File does not exist: {}", filepath);
+        },
+        "ASSET"
+    );
+}
+
+void
+addGzipOptions(App &cmd, GzipOptions &options) {
+    cmd.add_flag_function(
+        "--gzip",
+        [&options](auto count) {
+            options.enabled = (count != 0);
+        },
+        "Compress the output with gzip"
+    );
+    cmd.add_option_function<int>(
+        "--gzip-level",
+        [&options](const int &level) {
+            options.level = level;
+        },
+        "Compression level from 1 (fastest) to 9 (best), default to 6"
+    )->check(CLI::Range(1, 9));
+}
+
+void
+addImageFormatOptions(App &cmd, ImageFormat &format) {
+    cmd.add_option_function<std::string>(
+        "-f,--format",
+        [&format](const std::string &name) {
+            format.type = name == "png"
+                ? ImageFormat::Type::PNG
+                : ImageFormat::Type::BMP;
+        },
+        "Image file format, bmp or png (default to bmp)"
+    )->check(CLI::IsMember({"bmp", "png"}));
+    cmd.add_option_function<int>(
+        "--png-level",
+        [&format](const int &level) {
+            format.png.level = level;
+        },
+        "PNG compression level from 0 (none) to 9 (best), default to 6"
+    )->check(CLI::Range(0, 9));
+    cmd.add_flag_function(
+        "-t,--transparent",
+        [&format](auto count) {
+            format.png.transparent = (count != 0);
+        },
+        "Make the color 0 transparent in PNG files"
+    );
+    cmd.add_option_function<std::size_t>(
+        "--scale",
+        [&format](const std::size_t &scale) {
+            format.scale = scale;
+        },
+        "Scale factor from 1 to 4, default to 1"
+    )->check(CLI::Range(1, 4));
+    cmd.add_option_function<std::string>(
+        "--scale-filter",
+        [&format](const std::string &name) {
+            format.scaleFilter = *dune2::findScaleFilter(name);
+        },
+        "Scale filter, nearest or scalex (Scale2x/Scale3x), default to nearest"
+    )->check(CLI::IsMember({"nearest", "scalex"}));
+}
+
+void
+writeJSON(
+    AppState &app_state,
+    const rapidjson::Document &json,
+    bool pretty,
+    const GzipOptions &gzip,
+    const std::optional<fs::path> &output_filepath
+) {
+    // Errors raised while compressing the written data are caught by the
+    // stream which only sets its badbit, so both streams are checked once
+    // done.
+    const auto write = [&](std::ostream &output) {
+        auto ok = true;
+        if (gzip.enabled) {
+            dune2::OGzipStream gzs(output, getExecutor(app_state), gzip.level);
+            flushJSON(json, pretty, gzs);
+            try {
+                gzs.close();
+            } catch (const std::exception &) {
+                ok = false;
+            }
+            ok = ok && !gzs.fail();
+        } else {
+            flushJSON(json, pretty, output);
+        }
+        output.flush();
+        return ok && !output.fail();
+    };
+
+    auto ok = false;
+    if (output_filepath) {
+        std::ofstream ofs(*output_filepath, std::ios::binary);
+        ok = write(ofs);
+    } else {
+        ok = write(std::cout);
+    }
+
+    if (!ok) {
+        throw CLI::Error(
+            "WriteFailure",
+            fmt::format("Failed to write '{}'", output_filepath
+                ? output_filepath->string()
+                : std::string("stdout")),
+            CLI::ExitCodes::FileError
+        );
+    }
+}
+
 bool
 filepathMatch(
     const fs::path &filepath,
@@ -22,11 +205,12 @@ filepathMatch(
 template <>
 void
 load<dune2::Palette>(
+    AppState &app_state,
     dune2::Palette &palette,
     const std::filesystem::path &source
 ) {
     if (filepathMatch(source, ".pal")) {
-        palette.loadFromPAL(source);
+        palette.loadFromPAL(*openAsset(app_state, source));
     } else if (filepathMatch(source, ".json")) {
         palette.loadFromJSON(source);
     } else {
@@ -41,18 +225,29 @@ load<dune2::Palette>(
 template <>
 void
 load<dune2::ImageSet>(
+    AppState &app_state,
     dune2::ImageSet &tileset,
     const std::filesystem::path &source
+) {
+    load(app_state, tileset, source, dune2::ImageSet::LoadPolicy::Eager);
+}
+
+void
+load(
+    AppState &app_state,
+    dune2::ImageSet &tileset,
+    const std::filesystem::path &source,
+    dune2::ImageSet::LoadPolicy policy
 ) {
     if (filepathMatch(source, ".icn")) {
-        tileset.loadFromICN(source);
+        tileset.loadFromICN(*openAsset(app_state, source), policy);
     } else if (filepathMatch(source, ".shp")) {
-        tileset.loadFromSHP(source);
+        tileset.loadFromSHP(*openAsset(app_state, source), policy);
     } else if (filepathMatch(source, ".json")) {
         tileset.loadFromJSON(source);
     } else if (filepathMatch(source, ".cps")) {
         dune2::Image image;
-        image.loadFromCPS(source);
+        image.loadFromCPS(*openAsset(app_state, source));
         tileset.push_back(std::move(image));
     } else {
         throw CLI::Error(
@@ -65,11 +260,12 @@ load<dune2::ImageSet>(
 
 template <>
 void load<dune2::IconSet>(
+    AppState &app_state,
     dune2::IconSet &iconset,
     const std::filesystem::path &source
 ) {
     if (filepathMatch(source, ".map")) {
-        iconset.loadFromMAP(source);
+        iconset.loadFromMAP(*openAsset(app_state, source));
     } else if (filepathMatch(source, ".json")) {
         iconset.loadFromJSON(source);
     } else {
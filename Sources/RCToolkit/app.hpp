@@ -1,11 +1,15 @@
 #pragma once
 
+#include <Dune2/catalog.hpp>
+#include <Dune2/executor.hpp>
 #include <Dune2/io.hpp>
 #include <Dune2/palette.hpp>
 #include <Dune2/icon_set.hpp>
 #include <Dune2/image.hpp>
 #include <Dune2/image_set.hpp>
 
+#include <output.hpp>
+
 #include <CLI/CLI.hpp>
 
 #include <rapidjson/document.h>
@@ -13,6 +17,9 @@
 #include <rapidjson/prettywriter.h>
 
 #include <filesystem>
+#include <istream>
+#include <memory>
+#include <optional>
 
 using CLI::App;
 
@@ -20,8 +27,35 @@ namespace nr {
 
 struct AppState {
     unsigned int verbose{0};
+    unsigned int jobs{0};
+    std::shared_ptr<dune2::Executor> executor;
+    std::optional<std::filesystem::path> catalogFilepath;
+    std::shared_ptr<dune2::Catalog> catalog;
+};
+
+dune2::Executor &getExecutor(AppState &);
+
+// Return the catalog given with --catalog or nullptr.
+const dune2::Catalog *getCatalog(AppState &);
+
+// Open an asset file, or the catalog entry with the same file name when the
+// file does not exist.
+std::unique_ptr<std::istream> openAsset(AppState &, const std::filesystem::path &);
+
+// Check that an asset file exists or is found in the catalog.
+CLI::Validator existingAsset(AppState &);
+
+struct GzipOptions {
+    bool enabled{false};
+    int level{6};
 };
 
+// Add the --gzip and --gzip-level options to a command.
+void addGzipOptions(App &, GzipOptions &);
+
+// Add the --format, --png-level, --transparent, --scale and --scale-filter
+// options to a command.
+void addImageFormatOptions(App &, ImageFormat &);
 
 bool filepathMatch(const std::filesystem::path &, const std::string extension);
 
@@ -42,16 +76,28 @@ void flushJSON(const rapidjson::Document &json, bool pretty, T &output) {
     }
 }
 
+// Write the JSON document to the given file or to the standard output,
+// compressed with gzip when enabled.
+void writeJSON(
+    AppState &,
+    const rapidjson::Document &,
+    bool pretty,
+    const GzipOptions &,
+    const std::optional<std::filesystem::path> &
+);
+
 template <typename T>
-void load(T &data, const std::filesystem::path &);
+void load(AppState &, T &data, const std::filesystem::path &);
 
 template <>
-void load<dune2::Palette>(dune2::Palette &, const std::filesystem::path &);
+void load<dune2::Palette>(AppState &, dune2::Palette &, const std::filesystem::path &);
 
 template <>
-void load<dune2::ImageSet>(dune2::ImageSet &, const std::filesystem::path &);
+void load<dune2::ImageSet>(AppState &, dune2::ImageSet &, const std::filesystem::path &);
+
+void load(AppState &, dune2::ImageSet &, const std::filesystem::path &, dune2::ImageSet::LoadPolicy);
 
 template <>
-void load<dune2::IconSet>(dune2::IconSet &, const std::filesystem::path &);
+void load<dune2::IconSet>(AppState &, dune2::IconSet &, const std::filesystem::path &);
 
 } // namespace nr
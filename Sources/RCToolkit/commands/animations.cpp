@@ -0,0 +1,194 @@
+#include <app.hpp>
+#include <output.hpp>
+
+#include <Dune2/animation.hpp>
+#include <Dune2/bmp.hpp>
+#include <Dune2/gif.hpp>
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+
+namespace {
+namespace fs = std::filesystem;
+
+using nr::AppState;
+
+CLI::App_p
+create_extract_command(AppState &app_state) {
+    struct CmdState {
+        fs::path paletteFilepath;
+        fs::path animationFilepath;
+        fs::path outputDirectory{fs::current_path()};
+        std::optional<fs::path> archiveFilepath;
+        nr::ImageFormat imageFormat;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("extract");
+    cmd->description("Extract animation frames to bmp or png files");
+
+    cmd->add_option_function<fs::path>(
+        "-d,--output-directory",
+        [cmd_state](const fs::path &output_directory) {
+            cmd_state->outputDirectory = output_directory;
+        },
+        "Specify the output directory"
+    )->check(CLI::ExistingDirectory);
+
+    cmd->add_option_function<fs::path>(
+        "-a,--archive",
+        [cmd_state](const fs::path &archiveFilepath) {
+            cmd_state->archiveFilepath = archiveFilepath;
+        },
+        "Write all frames into a single tar archive (use - for stdout)"
+    );
+
+    nr::addImageFormatOptions(*cmd, cmd_state->imageFormat);
+
+    cmd->add_option_function<fs::path>(
+        "PALETTE",
+        [cmd_state](const fs::path &paletteFilepath) {
+            cmd_state->paletteFilepath = paletteFilepath;
+        },
+        "Path to Dune2 .pal or .json file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "ANIMATION",
+        [cmd_state](const fs::path &animationFilepath) {
+            cmd_state->animationFilepath = animationFilepath;
+        },
+        "Path to Dune2 .wsa file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->callback([cmd, cmd_state, &app_state]{
+        using fmt::format;
+
+        nr::dune2::Palette palette;
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
+
+        nr::dune2::Animation animation;
+        animation.loadFromWSA(*nr::openAsset(app_state, cmd_state->animationFilepath));
+
+        const auto output = cmd_state->archiveFilepath
+            ? nr::createTarOutput(*cmd_state->archiveFilepath)
+            : nr::createDirectoryOutput(cmd_state->outputDirectory);
+
+        // Frames are decoded in order, each one from the previous one.
+        for (auto i = 0u; i < animation.getFrameCount(); ++i) {
+            const auto frame = animation.getFrame(i);
+            output->store(format("{}", i + 1), frame, palette, cmd_state->imageFormat);
+        }
+    });
+
+    return cmd;
+}
+CLI::App_p
+create_gif_command(AppState &app_state) {
+    struct CmdState {
+        fs::path paletteFilepath;
+        fs::path animationFilepath;
+        std::optional<fs::path> outputFilepath;
+        std::uint16_t delay{10};
+        bool loop{true};
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("gif");
+    cmd->description("Export an animation to an animated gif file");
+
+    cmd->add_option_function<fs::path>(
+        "-o,--output-file",
+        [cmd_state](const fs::path &outputFilepath) {
+            cmd_state->outputFilepath = outputFilepath;
+        },
+        "Specify the output file"
+    );
+
+    cmd->add_option_function<std::uint16_t>(
+        "--delay",
+        [cmd_state](const std::uint16_t &delay) {
+            cmd_state->delay = delay;
+        },
+        "Frame duration in hundredths of second (default 10)"
+    );
+
+    cmd->add_flag_function(
+        "--no-loop",
+        [cmd_state](auto count) {
+            cmd_state->loop = (count == 0);
+        },
+        "Play the animation once"
+    );
+
+    cmd->add_option_function<fs::path>(
+        "PALETTE",
+        [cmd_state](const fs::path &paletteFilepath) {
+            cmd_state->paletteFilepath = paletteFilepath;
+        },
+        "Path to Dune2 .pal or .json file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "ANIMATION",
+        [cmd_state](const fs::path &animationFilepath) {
+            cmd_state->animationFilepath = animationFilepath;
+        },
+        "Path to Dune2 .wsa file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->callback([cmd, cmd_state, &app_state]{
+        nr::dune2::Palette palette;
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
+
+        nr::dune2::Animation animation;
+        animation.loadFromWSA(*nr::openAsset(app_state, cmd_state->animationFilepath));
+
+        const auto write = [&](std::ostream &output) {
+            nr::dune2::GIFWriter gif(
+                output,
+                animation.getWidth(),
+                animation.getHeight(),
+                palette,
+                cmd_state->loop
+            );
+            // Frames are decoded in order, each one from the previous one.
+            for (auto i = 0u; i < animation.getFrameCount(); ++i) {
+                gif.write(animation.getFrame(i), cmd_state->delay);
+            }
+            gif.close();
+        };
+
+        if (cmd_state->outputFilepath) {
+            std::ofstream ofs(cmd_state->outputFilepath.value(), std::ios::binary);
+            write(ofs);
+        } else {
+            write(std::cout);
+        }
+    });
+
+    return cmd;
+}
+} // namespace
+
+CLI::App_p
+createAnimationCommands(nr::AppState &app_state) {
+    auto cmd = std::make_shared<App>();
+
+    cmd->name("animations");
+    cmd->description("Animation commands");
+    cmd->require_subcommand(1);
+    cmd->add_subcommand(create_extract_command(app_state));
+    cmd->add_subcommand(create_gif_command(app_state));
+
+    return cmd;
+}
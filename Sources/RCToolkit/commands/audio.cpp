@@ -0,0 +1,194 @@
+#include <app.hpp>
+#include <output.hpp>
+
+#include <Dune2/io.hpp>
+#include <Dune2/pak.hpp>
+#include <Dune2/sound.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+
+using nr::AppState;
+
+struct AudioSource {
+    std::string name;
+    std::function<std::string()> read;
+};
+
+// List the sounds of the given files: `.voc` files are converted as is, the
+// `.voc` entries of `.pak` files are converted to '<PAK name>/<entry name>'.
+std::vector<AudioSource>
+list_sources(AppState &app_state, const std::vector<fs::path> &sources) {
+    std::vector<AudioSource> audio_sources;
+
+    // The catalog is loaded now as sources are read concurrently.
+    nr::getCatalog(app_state);
+
+    for (const auto &source: sources) {
+        if (nr::filepathMatch(source, ".pak")) {
+            auto pak = std::make_shared<nr::dune2::PAK>();
+            pak->load(source);
+            for (const auto &entry: *pak) {
+                if (!nr::filepathMatch(entry.name, ".voc")) {
+                    continue;
+                }
+                audio_sources.push_back(AudioSource{
+                    (fs::path(source.stem())/fs::path(entry.name).stem()).string(),
+                    [pak, &entry] { return entry.read(); }
+                });
+            }
+        } else if (nr::filepathMatch(source, ".voc")) {
+            audio_sources.push_back(AudioSource{
+                source.stem().string(),
+                [&app_state, source] {
+                    return nr::dune2::io::readAll(*nr::openAsset(app_state, source));
+                }
+            });
+        } else {
+            throw CLI::Error(
+                "Unsupported file",
+                fmt::format("Unsupported file type: '{}'", source.extension().string()),
+                CLI::ExitCodes::InvalidError
+            );
+        }
+    }
+
+    return audio_sources;
+}
+
+// Decode the sources on the given executor.
+std::vector<nr::dune2::Sound>
+decode_sources(
+    nr::dune2::Executor &executor,
+    const std::vector<AudioSource> &sources,
+    std::optional<std::size_t> sample_rate
+) {
+    return nr::dune2::parallelTransform(executor, sources.size(), [&](std::size_t i) {
+        try {
+            const auto data = sources[i].read();
+            nr::dune2::io::IMemoryStream input(data);
+
+            nr::dune2::Sound sound;
+            sound.loadFromVOC(input);
+            if (sample_rate) {
+                sound.resample(*sample_rate);
+            }
+            return sound;
+        } catch (const std::exception &err) {
+            throw CLI::Error(
+                "AudioFailure",
+                fmt::format("Failed to decode '{}': {}", sources[i].name, err.what())
+            );
+        }
+    });
+}
+
+CLI::App_p
+create_convert_command(AppState &app_state) {
+    struct CmdState {
+        std::vector<fs::path> sources;
+        std::string format{"wav"};
+        std::optional<std::size_t> sampleRate;
+        fs::path outputDirectory{fs::current_path()};
+        std::optional<fs::path> archiveFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("convert");
+    cmd->description("Convert voc files to wav or raw pcm files");
+
+    cmd->add_option_function<fs::path>(
+        "-d,--output-directory",
+        [cmd_state](const fs::path &output_directory) {
+            cmd_state->outputDirectory = output_directory;
+        },
+        "Specify the output directory"
+    )->check(CLI::ExistingDirectory);
+
+    cmd->add_option_function<fs::path>(
+        "-a,--archive",
+        [cmd_state](const fs::path &archiveFilepath) {
+            cmd_state->archiveFilepath = archiveFilepath;
+        },
+        "Write all sounds into a single tar archive (use - for stdout)"
+    );
+
+    cmd->add_option_function<std::string>(
+        "-f,--format",
+        [cmd_state](const std::string &format) {
+            cmd_state->format = format;
+        },
+        "Output format: wav or pcm (unsigned 8 bits mono samples)"
+    )->check(CLI::IsMember({"wav", "pcm"}));
+
+    cmd->add_option_function<std::size_t>(
+        "-r,--sample-rate",
+        [cmd_state](const std::size_t &sampleRate) {
+            cmd_state->sampleRate = sampleRate;
+        },
+        "Resample all sounds to the given sample rate"
+    )->check(CLI::PositiveNumber);
+
+    cmd->add_option_function<std::vector<fs::path>>(
+        "SOURCES",
+        [cmd_state](const std::vector<fs::path> &sources) {
+            cmd_state->sources = sources;
+        },
+        "Path to Dune2 .voc or .pak files"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        using fmt::format;
+
+        const auto sources = list_sources(app_state, cmd_state->sources);
+        const auto sounds = decode_sources(nr::getExecutor(app_state), sources, cmd_state->sampleRate);
+
+        const auto output = cmd_state->archiveFilepath
+            ? nr::createTarOutput(*cmd_state->archiveFilepath)
+            : nr::createDirectoryOutput(cmd_state->outputDirectory);
+
+        const auto wav = cmd_state->format == "wav";
+        for (auto i = 0u; i < sources.size(); ++i) {
+            const auto &sound = sounds[i];
+            if (wav) {
+                output->store(
+                    format("{}.wav", sources[i].name),
+                    sound.getWAVSize(),
+                    [&](std::ostream &out) { sound.storeWAV(out); }
+                );
+            } else {
+                output->store(
+                    format("{}.pcm", sources[i].name),
+                    sound.getSamples().size(),
+                    [&](std::ostream &out) { sound.storePCM(out); }
+                );
+            }
+        }
+    });
+
+    return cmd;
+}
+} // namespace
+
+CLI::App_p
+createAudioCommands(nr::AppState &app_state) {
+    auto cmd = std::make_shared<App>();
+
+    cmd->name("audio");
+    cmd->description("Audio commands");
+    cmd->require_subcommand(1);
+    cmd->add_subcommand(create_convert_command(app_state));
+
+    return cmd;
+}
@@ -0,0 +1,166 @@
+#include <app.hpp>
+
+#include <Dune2/catalog.hpp>
+
+#include <fmt/format.h>
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+
+using nr::AppState;
+using nr::dune2::Catalog;
+
+void
+print_entry(const Catalog &catalog, const Catalog::Entry &entry) {
+    std::cout << fmt::format(
+        "{}/{} {} {}x{} {} {} {:016x}\n",
+        catalog.getArchive(entry.archive).path,
+        entry.name,
+        Catalog::getFormatName(entry.format),
+        entry.width,
+        entry.height,
+        entry.frameCount,
+        entry.size,
+        entry.hash
+    );
+}
+
+CLI::App_p
+create_update_command(AppState &app_state) {
+    struct CmdState {
+        fs::path rootDirectory{fs::current_path()};
+        fs::path catalogFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("update");
+    cmd->description("Create or update the catalog of the .pak files of a directory tree");
+
+    cmd->add_option_function<fs::path>(
+        "-r,--root",
+        [cmd_state](const fs::path &root_directory) {
+            cmd_state->rootDirectory = root_directory;
+        },
+        "Directory to scan (default to the current directory)"
+    )->check(CLI::ExistingDirectory);
+
+    cmd->add_option_function<fs::path>(
+        "CATALOG",
+        [cmd_state](const fs::path &catalog_filepath) {
+            cmd_state->catalogFilepath = catalog_filepath;
+        },
+        "Path to the catalog file"
+    )->required();
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        Catalog catalog;
+
+        // A catalog which cannot be loaded is rebuilt from scratch.
+        if (fs::exists(cmd_state->catalogFilepath)) {
+            try {
+                catalog.load(cmd_state->catalogFilepath);
+            } catch (const std::exception &) {
+                catalog = Catalog();
+            }
+        }
+
+        const auto count = catalog.update(cmd_state->rootDirectory, nr::getExecutor(app_state));
+        catalog.store(cmd_state->catalogFilepath);
+
+        if (app_state.verbose > 0) {
+            std::cerr << fmt::format(
+                "{} archives read, {} archives and {} entries in catalog\n",
+                count,
+                catalog.getArchiveCount(),
+                catalog.getEntryCount()
+            );
+        }
+    });
+
+    return cmd;
+}
+
+CLI::App_p
+create_list_command(AppState &app_state) {
+    struct CmdState {
+        fs::path catalogFilepath;
+        std::vector<std::string> names;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("list");
+    cmd->description("List the entries of a catalog");
+
+    cmd->add_option_function<fs::path>(
+        "CATALOG",
+        [cmd_state](const fs::path &catalog_filepath) {
+            cmd_state->catalogFilepath = catalog_filepath;
+        },
+        "Path to the catalog file"
+    )->required()->check(CLI::ExistingFile);
+
+    cmd->add_option_function<std::vector<std::string>>(
+        "NAMES",
+        [cmd_state](const std::vector<std::string> &names) {
+            cmd_state->names = names;
+        },
+        "Names of the entries to list (default to all entries)"
+    );
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        Catalog catalog;
+
+        try {
+            catalog.load(cmd_state->catalogFilepath);
+        } catch (const std::exception &err) {
+            throw CLI::Error(
+                "CatalogFailure",
+                fmt::format("Failed to load '{}': {}", cmd_state->catalogFilepath.string(), err.what()),
+                CLI::ExitCodes::FileError
+            );
+        }
+
+        if (cmd_state->names.empty()) {
+            for (auto i = 0u; i < catalog.getEntryCount(); ++i) {
+                print_entry(catalog, catalog.getEntry(i));
+            }
+        } else {
+            for (const auto &name: cmd_state->names) {
+                const auto entry = catalog.find(name);
+                if (!entry) {
+                    throw CLI::Error(
+                        "CatalogFailure",
+                        fmt::format("'{}' not found", name),
+                        CLI::ExitCodes::FileError
+                    );
+                }
+                print_entry(catalog, *entry);
+            }
+        }
+    });
+
+    return cmd;
+}
+} // namespace
+
+CLI::App_p
+createCatalogCommands(nr::AppState &app_state) {
+    auto cmd = std::make_shared<App>();
+
+    cmd->name("catalog");
+    cmd->description("Asset catalog commands");
+    cmd->require_subcommand(1);
+    cmd->add_subcommand(create_update_command(app_state));
+    cmd->add_subcommand(create_list_command(app_state));
+
+    return cmd;
+}
@@ -0,0 +1,462 @@
+#include <app.hpp>
+#include <output.hpp>
+
+#include <Dune2/io.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+
+using nr::AppState;
+
+// Files are generated from their own random sequence, derived from the corpus
+// seed and the file index, so that the corpus does not depend on the number
+// of jobs. Numbers are drawn with a SplitMix64 generator instead of the
+// standard distributions, whose output differs between implementations.
+class Random {
+public:
+    Random(std::uint64_t seed, std::uint64_t stream)
+        : state_{seed*0x9e3779b97f4a7c15ull ^ (stream + 1)*0xbf58476d1ce4e5b9ull} {
+    }
+
+    std::uint32_t next() {
+        auto z = (state_ += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27))*0x94d049bb133111ebull;
+        return static_cast<std::uint32_t>((z ^ (z >> 31)) >> 32);
+    }
+
+    // Uniform-enough integer in [first, last].
+    std::size_t range(std::size_t first, std::size_t last) {
+        return first + next()%(last - first + 1);
+    }
+
+    bool chance(unsigned percent) {
+        return next()%100 < percent;
+    }
+
+private:
+    std::uint64_t state_;
+};
+
+void
+put_le(std::string &data, std::uint32_t value, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        data.push_back(static_cast<char>((value >> 8*i) & 0xff));
+    }
+}
+
+void
+put_be(std::string &data, std::uint32_t value, std::size_t size) {
+    for (std::size_t i = size; i > 0; --i) {
+        data.push_back(static_cast<char>((value >> 8*(i - 1)) & 0xff));
+    }
+}
+
+void
+put_le_at(std::string &data, std::size_t pos, std::uint32_t value, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        data[pos + i] = static_cast<char>((value >> 8*i) & 0xff);
+    }
+}
+
+// Sprite-like pixels: a transparent background with a few filled rectangles
+// and ellipses, which compress the way real assets do.
+std::string
+make_pixels(Random &random, std::size_t width, std::size_t height, std::size_t color_count) {
+    std::string pixels(width*height, '\0');
+
+    const auto shape_count = random.range(1, 6);
+    for (std::size_t shape = 0; shape < shape_count; ++shape) {
+        const auto x0 = random.range(0, width - 1);
+        const auto y0 = random.range(0, height - 1);
+        const auto x1 = random.range(x0, width - 1);
+        const auto y1 = random.range(y0, height - 1);
+        const auto color = static_cast<char>(random.range(1, color_count - 1));
+        const auto ellipse = random.chance(50);
+
+        const auto cx = (x0 + x1)/2., cy = (y0 + y1)/2.;
+        const auto rx = (x1 - x0)/2. + .5, ry = (y1 - y0)/2. + .5;
+        for (auto y = y0; y <= y1; ++y) {
+            for (auto x = x0; x <= x1; ++x) {
+                const auto dx = (x - cx)/rx, dy = (y - cy)/ry;
+                if (!ellipse || dx*dx + dy*dy <= 1) {
+                    pixels[y*width + x] = color;
+                }
+            }
+        }
+    }
+    // Some noise so that the data is not only made of runs.
+    const auto noise_count = random.range(0, width*height/8);
+    for (std::size_t i = 0; i < noise_count; ++i) {
+        pixels[random.range(0, pixels.size() - 1)] = static_cast<char>(random.range(1, color_count - 1));
+    }
+
+    return pixels;
+}
+
+std::string
+make_palette(Random &random) {
+    std::string data;
+    for (auto i = 0; i < 3*256; ++i) {
+        data.push_back(static_cast<char>(random.range(0, 63)));
+    }
+    return data;
+}
+
+std::string
+make_cps(Random &random) {
+    const auto pixels = make_pixels(random, 320, 200, 256);
+    const auto lcw = nr::dune2::io::encodeLCWData(
+        reinterpret_cast<const std::uint8_t *>(pixels.data()),
+        pixels.size()
+    );
+
+    std::string data;
+    put_le(data, static_cast<std::uint32_t>(lcw.size() + 8), 2); // file size - 2
+    put_le(data, 4, 2);                                          // LCW
+    put_le(data, static_cast<std::uint32_t>(pixels.size()), 4);
+    put_le(data, 0, 2);                                          // no palette
+    data.append(lcw.begin(), lcw.end());
+    return data;
+}
+
+// Zeros are stored as runs, other values as is.
+std::string
+encode_rle(const std::string &pixels) {
+    std::string rle;
+    for (std::size_t i = 0; i < pixels.size();) {
+        if (pixels[i] != '\0') {
+            rle.push_back(pixels[i++]);
+            continue;
+        }
+        std::size_t count = 0;
+        while (i < pixels.size() && pixels[i] == '\0' && count < 255) {
+            ++count;
+            ++i;
+        }
+        rle.push_back('\0');
+        rle.push_back(static_cast<char>(count));
+    }
+    return rle;
+}
+
+std::string
+make_shp_frame(Random &random, std::size_t max_size) {
+    const auto width = random.range(4, max_size);
+    const auto height = random.range(4, max_size);
+    const auto remap = random.chance(30);
+    const auto custom_remap_size = remap && random.chance(50);
+    const auto lcw = random.chance(70);
+
+    std::string remap_table;
+    if (remap) {
+        const auto remap_size = custom_remap_size ? random.range(2, 16) : 16;
+        for (std::size_t i = 0; i < remap_size; ++i) {
+            remap_table.push_back(static_cast<char>(random.range(0, 255)));
+        }
+    }
+
+    const auto rle = encode_rle(make_pixels(random, width, height, remap ? remap_table.size() : 256));
+    auto payload = rle;
+    if (lcw) {
+        const auto encoded = nr::dune2::io::encodeLCWData(
+            reinterpret_cast<const std::uint8_t *>(rle.data()),
+            rle.size()
+        );
+        payload.assign(encoded.begin(), encoded.end());
+    }
+
+    std::string frame;
+    put_le(frame, (remap ? 1 : 0) | (lcw ? 0 : 2) | (custom_remap_size ? 4 : 0), 2);
+    put_le(frame, 0, 1);
+    put_le(frame, static_cast<std::uint32_t>(width), 2);
+    put_le(frame, static_cast<std::uint32_t>(height), 1);
+    put_le(frame, 0, 2);                                        // frame size
+    put_le(frame, static_cast<std::uint32_t>(rle.size()), 2);
+    if (custom_remap_size) {
+        put_le(frame, static_cast<std::uint32_t>(remap_table.size()), 1);
+    }
+    frame += remap_table;
+    frame += payload;
+    put_le_at(frame, 6, static_cast<std::uint32_t>(frame.size()), 2);
+
+    return frame;
+}
+
+// Version 100 files use 16 bits absolute frame offsets, version 107 files use
+// 32 bits offsets relative to the end of the frame count. The table holds one
+// more offset, the end of the file.
+std::string
+make_shp(Random &random, bool v100, std::size_t frame_count) {
+    const auto offset_size = v100 ? 2u : 4u;
+    const auto header_size = 2 + (frame_count + 1)*offset_size;
+
+    std::string data;
+    put_le(data, static_cast<std::uint32_t>(frame_count), 2);
+    data.resize(header_size);
+
+    for (std::size_t i = 0; i <= frame_count; ++i) {
+        const auto offset = v100 ? data.size() : data.size() - 2;
+        put_le_at(data, 2 + i*offset_size, static_cast<std::uint32_t>(offset), offset_size);
+        if (i < frame_count) {
+            data += make_shp_frame(random, v100 ? 24 : 64);
+        }
+    }
+    return data;
+}
+
+constexpr std::size_t ICNTileSize = 16;
+constexpr std::size_t ICNPaletteCount = 96;
+
+std::string
+make_icn(Random &random, std::size_t tile_count) {
+    const auto tile_data_size = ICNTileSize*ICNTileSize/2;
+
+    std::string sset;
+    put_be(sset, 0, 2);
+    put_le(sset, static_cast<std::uint32_t>(tile_count*tile_data_size), 2);
+    put_le(sset, 0, 4);
+    for (std::size_t i = 0; i < tile_count; ++i) {
+        const auto pixels = make_pixels(random, ICNTileSize, ICNTileSize, 16);
+        for (std::size_t p = 0; p < pixels.size(); p += 2) {
+            sset.push_back(static_cast<char>((pixels[p] << 4) | pixels[p + 1]));
+        }
+    }
+
+    std::string rpal;
+    for (std::size_t i = 0; i < ICNPaletteCount*16; ++i) {
+        rpal.push_back(static_cast<char>(random.range(0, 255)));
+    }
+
+    std::string rtbl;
+    for (std::size_t i = 0; i < tile_count; ++i) {
+        rtbl.push_back(static_cast<char>(random.range(0, ICNPaletteCount - 1)));
+    }
+
+    const auto chunk = [](const char *id, const std::string &content) {
+        std::string data(id);
+        put_be(data, static_cast<std::uint32_t>(content.size()), 4);
+        data += content;
+        if (data.size() % 2 != 0) {
+            data.push_back('\0');
+        }
+        return data;
+    };
+
+    std::string sinf;
+    put_le(sinf, 2, 1);  // width
+    put_le(sinf, 2, 1);  // height
+    put_le(sinf, 3, 1);  // shift
+    put_le(sinf, 4, 1);  // bits per pixel
+
+    const auto form = std::string("ICON")
+        + chunk("SINF", sinf)
+        + chunk("SSET", sset)
+        + chunk("RPAL", rpal)
+        + chunk("RTBL", rtbl);
+    return chunk("FORM", form);
+}
+
+// Number of tiles of the groups with fixed icon shapes, see the ICON.MAP
+// loader. The other groups hold 1x1 icons, their size is capped so that the
+// file fits the 16 bits group offsets.
+std::optional<std::size_t>
+map_group_tile_count(std::size_t group) {
+    switch (group) {
+    case 10: return 4*9;
+    case 11: case 25: return 6*4;
+    case 12: case 13: return 8*6;
+    case 14: case 15: case 16: case 17: case 18: case 24: return 4*4;
+    case 19: return 10*9;
+    case 20: case 21: return 10*6;
+    default: return std::nullopt;
+    }
+}
+
+std::string
+make_map(Random &random, std::size_t tile_count, std::size_t scale) {
+    constexpr std::size_t GroupCount = 27;
+    constexpr std::size_t LandscapeGroup = 8;
+    constexpr std::size_t LandscapeIconCount = 81;
+
+    std::vector<std::size_t> sizes;
+    for (std::size_t group = 0; group < GroupCount; ++group) {
+        sizes.push_back(group == LandscapeGroup
+            ? LandscapeIconCount
+            : map_group_tile_count(group).value_or(random.range(4, 24)*std::min<std::size_t>(scale, 64)));
+    }
+
+    std::string data;
+    put_le(data, GroupCount + 1, 2);
+    auto offset = GroupCount + 1;
+    for (const auto size: sizes) {
+        put_le(data, static_cast<std::uint32_t>(offset), 2);
+        offset += size;
+    }
+    for (const auto size: sizes) {
+        for (std::size_t i = 0; i < size; ++i) {
+            const auto tile = random.range(0, std::min<std::size_t>(tile_count, 0x10000) - 1);
+            put_le(data, static_cast<std::uint32_t>(tile), 2);
+        }
+    }
+    return data;
+}
+
+struct PAKEntry {
+    std::string name;
+    std::string data;
+};
+
+std::string
+make_pak(const std::vector<PAKEntry> &entries) {
+    std::size_t offset = 4;
+    for (const auto &entry: entries) {
+        offset += 4 + entry.name.size() + 1;
+    }
+
+    std::string data;
+    for (const auto &entry: entries) {
+        put_le(data, static_cast<std::uint32_t>(offset), 4);
+        data += entry.name;
+        data.push_back('\0');
+        offset += entry.data.size();
+    }
+    put_le(data, 0, 4);
+    for (const auto &entry: entries) {
+        data += entry.data;
+    }
+    return data;
+}
+
+CLI::App_p
+create_generate_command(AppState &app_state) {
+    struct CmdState {
+        std::uint64_t seed{0};
+        std::size_t scale{1};
+        fs::path outputDirectory{fs::current_path()};
+        std::optional<fs::path> archiveFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("generate");
+    cmd->description("Generate a synthetic corpus of Dune2 files");
+
+    cmd->add_option_function<fs::path>(
+        "-d,--output-directory",
+        [cmd_state](const fs::path &output_directory) {
+            cmd_state->outputDirectory = output_directory;
+        },
+        "Specify the output directory"
+    )->check(CLI::ExistingDirectory);
+
+    cmd->add_option_function<fs::path>(
+        "-a,--archive",
+        [cmd_state](const fs::path &archiveFilepath) {
+            cmd_state->archiveFilepath = archiveFilepath;
+        },
+        "Write all files into a single tar archive (use - for stdout)"
+    );
+
+    cmd->add_option_function<std::uint64_t>(
+        "-s,--seed",
+        [cmd_state](const std::uint64_t &seed) {
+            cmd_state->seed = seed;
+        },
+        "Seed of the corpus (default 0)"
+    );
+
+    cmd->add_option_function<std::size_t>(
+        "-x,--scale",
+        [cmd_state](const std::size_t &scale) {
+            cmd_state->scale = scale;
+        },
+        "Volume of the corpus relative to the game data (default 1)"
+    )->check(CLI::PositiveNumber);
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        using fmt::format;
+
+        const auto seed = cmd_state->seed;
+        const auto scale = cmd_state->scale;
+        const auto tile_count = 400*scale;
+
+        // Each file is generated by a job, the v100 shapes and the screens
+        // are packed into GFX.PAK. Frame counts are bound by the formats, so
+        // shapes and screens grow in number of files.
+        struct Job {
+            std::string name;
+            std::function<std::string(Random &)> make;
+        };
+        std::vector<Job> jobs{
+            {"PALETTE.PAL", [](Random &random) { return make_palette(random); }},
+            {"ICON.ICN", [=](Random &random) { return make_icn(random, tile_count); }},
+            {"ICON.MAP", [=](Random &random) { return make_map(random, tile_count, scale); }},
+        };
+        for (std::size_t i = 0; i < scale; ++i) {
+            jobs.push_back({format("UNITS{}.SHP", i), [](Random &random) {
+                return make_shp(random, false, 120);
+            }});
+        }
+        const auto pak_first = jobs.size();
+        for (std::size_t i = 0; i < 2*scale; ++i) {
+            jobs.push_back({format("SHAPES{}.SHP", i), [](Random &random) {
+                return make_shp(random, true, 40);
+            }});
+        }
+        for (std::size_t i = 0; i < 4*scale; ++i) {
+            jobs.push_back({format("SCREEN{}.CPS", i), [](Random &random) {
+                return make_cps(random);
+            }});
+        }
+
+        auto files = nr::dune2::parallelTransform(
+            nr::getExecutor(app_state),
+            jobs.size(),
+            [&](std::size_t i) {
+                Random random(seed, i);
+                return PAKEntry{jobs[i].name, jobs[i].make(random)};
+            }
+        );
+
+        const auto gfx = make_pak(std::vector<PAKEntry>(files.begin() + pak_first, files.end()));
+        files.erase(files.begin() + pak_first, files.end());
+        files.push_back(PAKEntry{"GFX.PAK", gfx});
+
+        const auto output = cmd_state->archiveFilepath
+            ? nr::createTarOutput(*cmd_state->archiveFilepath)
+            : nr::createDirectoryOutput(cmd_state->outputDirectory);
+
+        for (const auto &file: files) {
+            output->store(file.name, file.data.size(), [&](std::ostream &out) {
+                out.write(file.data.data(), file.data.size());
+            });
+        }
+    });
+
+    return cmd;
+}
+} // namespace
+
+CLI::App_p
+createCorpusCommands(nr::AppState &app_state) {
+    auto cmd = std::make_shared<App>();
+
+    cmd->name("corpus");
+    cmd->description("Synthetic data commands");
+    cmd->require_subcommand(1);
+    cmd->add_subcommand(create_generate_command(app_state));
+
+    return cmd;
+}
@@ -1,6 +1,8 @@
 #include <app.hpp>
+#include <output.hpp>
 
 #include <Dune2/bmp.hpp>
+#include <Dune2/color_stats.hpp>
 
 #include <fmt/format.h>
 
@@ -8,6 +10,7 @@
 #include <rapidjson/prettywriter.h>
 
 #include <filesystem>
+#include <vector>
 
 namespace {
 namespace fs = std::filesystem;
@@ -15,6 +18,7 @@ namespace fs = std::filesystem;
 using nr::AppState;
 
 using rapidjson::OStreamWrapper;
+using rapidjson::Value;
 
 using PrettyWriter = rapidjson::PrettyWriter<OStreamWrapper>;
 using Writer = rapidjson::Writer<OStreamWrapper>;
@@ -23,6 +27,7 @@ CLI::App_p
 create_create_command(AppState &app_state) {
     struct CmdState {
         bool pretty{false};
+        nr::GzipOptions gzip;
         fs::path inputFilepath;
         std::optional<fs::path> outputFilepath;
     };
@@ -49,26 +54,29 @@ create_create_command(AppState &app_state) {
         "Specify the output file"
     );
 
+    nr::addGzipOptions(*cmd, cmd_state->gzip);
+
     cmd->add_option_function<fs::path>(
         "MAP_FILE_PATH",
         [cmd_state](const fs::path &inputFilepath) {
             cmd_state->inputFilepath = inputFilepath;
         },
         "Path to Dune2 .map file"
-    )->required()->check(CLI::ExistingFile);
+    )->required()->check(nr::existingAsset(app_state));
 
     cmd->callback([cmd, cmd_state, &app_state] {
         nr::dune2::IconSet icn;
-        icn.loadFromMAP(cmd_state->inputFilepath);
+        icn.loadFromMAP(*nr::openAsset(app_state, cmd_state->inputFilepath));
 
         const auto json = icn.toJSON();
 
-        if (cmd_state->outputFilepath) {
-            std::ofstream ofs(cmd_state->outputFilepath.value());
-            nr::flushJSON(json, cmd_state->pretty, ofs);
-        } else {
-            nr::flushJSON(json, cmd_state->pretty, std::cout);
-        }
+        nr::writeJSON(
+            app_state,
+            json,
+            cmd_state->pretty,
+            cmd_state->gzip,
+            cmd_state->outputFilepath
+        );
     });
 
     return cmd;
@@ -78,6 +86,8 @@ CLI::App_p
 create_extract_command(AppState &app_state) {
     struct CmdState {
         fs::path outputDirectory{fs::current_path()};
+        std::optional<fs::path> archiveFilepath;
+        nr::ImageFormat imageFormat;
         fs::path paletteFilepath;
         fs::path imageSetFilepath;
         fs::path mapFilepath;
@@ -87,7 +97,7 @@ create_extract_command(AppState &app_state) {
     auto cmd_state = std::make_shared<CmdState>();
 
     cmd->name("extract");
-    cmd->description("Extract iconset to bmp files");
+    cmd->description("Extract iconset to bmp or png files");
 
     cmd->add_option_function<fs::path>(
         "-d,--output-directory",
@@ -97,13 +107,23 @@ create_extract_command(AppState &app_state) {
         "Specify the output directory"
     )->check(CLI::ExistingDirectory);
 
+    cmd->add_option_function<fs::path>(
+        "-a,--archive",
+        [cmd_state](const fs::path &archiveFilepath) {
+            cmd_state->archiveFilepath = archiveFilepath;
+        },
+        "Write all images into a single tar archive (use - for stdout)"
+    );
+
+    nr::addImageFormatOptions(*cmd, cmd_state->imageFormat);
+
     cmd->add_option_function<fs::path>(
         "PALETTE",
         [cmd_state](const fs::path &paletteFilepath) {
             cmd_state->paletteFilepath = paletteFilepath;
         },
         "Path to Dune2 .pal or .json file"
-    )->required()->check(CLI::ExistingFile);
+    )->required()->check(nr::existingAsset(app_state));
 
     cmd->add_option_function<fs::path>(
         "IMAGE_SET",
@@ -111,7 +131,7 @@ create_extract_command(AppState &app_state) {
             cmd_state->imageSetFilepath = imageSetFilepath;
         },
         "Path to Dune2 .icn or .json files"
-    )->required()->check(CLI::ExistingFile);
+    )->required()->check(nr::existingAsset(app_state));
 
     cmd->add_option_function<fs::path>(
         "MAP_FILE_PATH",
@@ -119,32 +139,184 @@ create_extract_command(AppState &app_state) {
             cmd_state->mapFilepath = mapFilepath;
         },
         "Path to Dune2 .map or .json files"
-    )->required()->check(CLI::ExistingFile);
+    )->required()->check(nr::existingAsset(app_state));
 
     cmd->callback([cmd, cmd_state, &app_state]{
         using fmt::format;
-        const auto output_directory = cmd_state->outputDirectory;
 
         nr::dune2::Palette palette;
-        nr::load(palette, cmd_state->paletteFilepath);
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
 
+        // Only the tiles referenced by the icons are decoded.
         nr::dune2::ImageSet images;
-        nr::load(images, cmd_state->imageSetFilepath);
+        nr::load(app_state, images, cmd_state->imageSetFilepath, nr::dune2::ImageSet::LoadPolicy::Lazy);
 
         nr::dune2::IconSet icons;
-        nr::load(icons, cmd_state->mapFilepath);
+        nr::load(app_state, icons, cmd_state->mapFilepath);
+
+        const auto output = cmd_state->archiveFilepath
+            ? nr::createTarOutput(*cmd_state->archiveFilepath)
+            : nr::createDirectoryOutput(cmd_state->outputDirectory);
 
         std::for_each(
             icons.begin(),
             icons.end(),
             [&, i = 0u](const auto &icon) mutable {
                 const auto surface = icon.getSurface(images);
-                const auto filename = format("{}.bmp", ++i);
-                nr::dune2::BMP bmp(surface.getWidth(), surface.getHeight());
+                output->store(format("{}", ++i), surface, palette, cmd_state->imageFormat);
+            }
+        );
+    });
 
-                bmp.drawSurface(0, 0, surface, palette);
-                bmp.store(output_directory/filename);
+    return cmd;
+}
+
+// Transform color statistics to a JSON array.
+Value
+stats_to_json(
+    const std::vector<nr::dune2::ColorStats> &stats,
+    const nr::dune2::Palette &palette,
+    bool histograms,
+    rapidjson::Document::AllocatorType &allocator
+) {
+    Value value(rapidjson::kArrayType);
+    for (const auto &item: stats) {
+        const auto mean = item.getMeanColor(palette);
+
+        Value item_value(rapidjson::kObjectType);
+        item_value.AddMember("mean", Value(rapidjson::kArrayType)
+            .PushBack(Value(mean.red), allocator)
+            .PushBack(Value(mean.green), allocator)
+            .PushBack(Value(mean.blue), allocator),
+            allocator
+        );
+        item_value.AddMember("dominant", Value(item.getDominantColor()), allocator);
+        if (histograms) {
+            Value histogram(rapidjson::kArrayType);
+            for (auto count: item.getHistogram()) {
+                histogram.PushBack(Value(count), allocator);
             }
+            item_value.AddMember("histogram", histogram, allocator);
+        }
+        value.PushBack(item_value, allocator);
+    }
+    return value;
+}
+
+CLI::App_p
+create_stats_command(AppState &app_state) {
+    struct CmdState {
+        bool pretty{false};
+        bool histograms{false};
+        nr::dune2::LUTColor lutColor{nr::dune2::LUTColor::Dominant};
+        nr::GzipOptions gzip;
+        std::optional<fs::path> outputFilepath;
+        fs::path paletteFilepath;
+        fs::path imageSetFilepath;
+        fs::path mapFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("stats");
+    cmd->description("Compute the colors of each tile and icon, and the minimap colors of the landscape icons");
+
+    cmd->add_flag_function(
+        "-p,--pretty",
+        [cmd_state](auto count) {
+            cmd_state->pretty = (count != 0);
+        },
+        "Enable pretty output"
+    );
+
+    cmd->add_flag_function(
+        "--histograms",
+        [cmd_state](auto count) {
+            cmd_state->histograms = (count != 0);
+        },
+        "Include the color histograms"
+    );
+
+    cmd->add_flag_function(
+        "-m,--mean",
+        [cmd_state](auto count) {
+            cmd_state->lutColor = count != 0
+                ? nr::dune2::LUTColor::Mean
+                : nr::dune2::LUTColor::Dominant;
+        },
+        "Use the mean color of the landscape icons instead of their dominant color"
+    );
+
+    cmd->add_option_function<fs::path>(
+        "-o,--output-file",
+        [cmd_state](const fs::path &outputFilepath) {
+            cmd_state->outputFilepath = outputFilepath;
+        },
+        "Specify the output file"
+    );
+
+    nr::addGzipOptions(*cmd, cmd_state->gzip);
+
+    cmd->add_option_function<fs::path>(
+        "PALETTE",
+        [cmd_state](const fs::path &paletteFilepath) {
+            cmd_state->paletteFilepath = paletteFilepath;
+        },
+        "Path to Dune2 .pal or .json file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "IMAGE_SET",
+        [cmd_state](const fs::path &imageSetFilepath) {
+            cmd_state->imageSetFilepath = imageSetFilepath;
+        },
+        "Path to Dune2 .icn or .json files"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "MAP_FILE_PATH",
+        [cmd_state](const fs::path &mapFilepath) {
+            cmd_state->mapFilepath = mapFilepath;
+        },
+        "Path to Dune2 .map or .json files"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        nr::dune2::Palette palette;
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
+
+        // Tiles are decoded while they are counted.
+        nr::dune2::ImageSet images;
+        nr::load(app_state, images, cmd_state->imageSetFilepath, nr::dune2::ImageSet::LoadPolicy::Lazy);
+
+        nr::dune2::IconSet icons;
+        nr::load(app_state, icons, cmd_state->mapFilepath);
+
+        const auto tile_stats = nr::dune2::computeTileColorStats(images, nr::getExecutor(app_state));
+        const auto icon_stats = nr::dune2::computeIconColorStats(icons, tile_stats);
+
+        rapidjson::Document json;
+        auto &allocator = json.GetAllocator();
+
+        json.SetObject();
+        json.AddMember("tiles", stats_to_json(tile_stats, palette, cmd_state->histograms, allocator), allocator);
+        json.AddMember("icons", stats_to_json(icon_stats, palette, cmd_state->histograms, allocator), allocator);
+
+        if (icons.getGroupCount() > nr::dune2::IconSet::LandscapeGroup) {
+            Value landscape(rapidjson::kArrayType);
+            for (auto color: nr::dune2::createLandscapeLUT(icons, icon_stats, palette, cmd_state->lutColor)) {
+                landscape.PushBack(Value(color), allocator);
+            }
+            json.AddMember("landscape", landscape, allocator);
+        }
+
+        nr::writeJSON(
+            app_state,
+            json,
+            cmd_state->pretty,
+            cmd_state->gzip,
+            cmd_state->outputFilepath
         );
     });
 
@@ -162,6 +334,7 @@ createIconsetCommands(AppState &app_state) {
     cmd->require_subcommand(1);
     cmd->add_subcommand(create_create_command(app_state));
     cmd->add_subcommand(create_extract_command(app_state));
+    cmd->add_subcommand(create_stats_command(app_state));
 
     return cmd;
 }
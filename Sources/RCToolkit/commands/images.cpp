@@ -1,13 +1,24 @@
 #include <app.hpp>
+#include <output.hpp>
 
 #include <Dune2/bmp.hpp>
+#include <Dune2/gif.hpp>
+#include <Dune2/house.hpp>
+#include <Dune2/quantize.hpp>
+#include <Dune2/rgb_image.hpp>
 
 #include <fmt/format.h>
 
 #include <rapidjson/ostreamwrapper.h>
 #include <rapidjson/prettywriter.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
 
 namespace {
 namespace fs = std::filesystem;
@@ -23,6 +34,9 @@ CLI::App_p
 create_create_command(AppState &app_state) {
     struct CmdState {
         bool pretty{false};
+        bool masks{false};
+        bool trim{false};
+        nr::GzipOptions gzip;
         std::vector<fs::path> sources;
         std::optional<fs::path> outputFilepath;
     };
@@ -49,6 +63,24 @@ create_create_command(AppState &app_state) {
         "Specify the output file"
     );
 
+    cmd->add_flag_function(
+        "-m,--masks",
+        [cmd_state](auto count) {
+            cmd_state->masks = (count != 0);
+        },
+        "Add the 1 bit opacity mask of each image"
+    );
+
+    cmd->add_flag_function(
+        "-T,--trim",
+        [cmd_state](auto count) {
+            cmd_state->trim = (count != 0);
+        },
+        "Only store the box of the opaque pixels of each image"
+    );
+
+    nr::addGzipOptions(*cmd, cmd_state->gzip);
+
     cmd->add_option_function<std::vector<fs::path>>(
         "SOURCES",
         [cmd_state](const std::vector<fs::path> &sources) {
@@ -60,17 +92,169 @@ create_create_command(AppState &app_state) {
     cmd->callback([cmd, cmd_state, &app_state] {
         nr::dune2::ImageSet tileset;
         for (auto &&source: cmd_state->sources) {
-            nr::load(tileset, source);
+            nr::load(app_state, tileset, source);
         }
 
-        const auto json = tileset.toJSON();
+        if (cmd_state->trim) {
+            nr::getExecutor(app_state).parallelFor(tileset.getImageCount(), [&](std::size_t i) {
+                tileset.trim(i);
+            });
+        }
 
-        if (cmd_state->outputFilepath) {
-            std::ofstream ofs(*cmd_state->outputFilepath);
-            nr::flushJSON(json, cmd_state->pretty, ofs);
-        } else {
-            nr::flushJSON(json, cmd_state->pretty, std::cout);
+        if (cmd_state->masks) {
+            nr::getExecutor(app_state).parallelFor(tileset.getImageCount(), [&](std::size_t i) {
+                tileset.getMask(i);
+            });
         }
+
+        const auto json = tileset.toJSON(cmd_state->masks);
+
+        nr::writeJSON(
+            app_state,
+            json,
+            cmd_state->pretty,
+            cmd_state->gzip,
+            cmd_state->outputFilepath
+        );
+    });
+    return cmd;
+}
+
+CLI::App_p
+create_import_command(AppState &app_state) {
+    struct CmdState {
+        bool pretty{false};
+        bool masks{false};
+        bool trim{false};
+        bool transparent{false};
+        nr::dune2::Dither dither{nr::dune2::Dither::None};
+        nr::GzipOptions gzip;
+        fs::path paletteFilepath;
+        std::vector<fs::path> sources;
+        std::optional<fs::path> outputFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("import");
+    cmd->description("Create a Dune2 image lib from true color .bmp or .png files");
+
+    cmd->add_flag_function(
+        "-p,--pretty",
+        [cmd_state](auto count) {
+            cmd_state->pretty = (count != 0);
+        },
+        "Enable pretty output"
+    );
+
+    cmd->add_option_function<fs::path>(
+        "-o,--output-file",
+        [cmd_state](const fs::path &outputFilepath) {
+            cmd_state->outputFilepath = outputFilepath;
+        },
+        "Specify the output file"
+    );
+
+    cmd->add_flag_function(
+        "-m,--masks",
+        [cmd_state](auto count) {
+            cmd_state->masks = (count != 0);
+        },
+        "Add the 1 bit opacity mask of each image"
+    );
+
+    cmd->add_flag_function(
+        "-T,--trim",
+        [cmd_state](auto count) {
+            cmd_state->trim = (count != 0);
+        },
+        "Only store the box of the opaque pixels of each image"
+    );
+
+    cmd->add_flag_function(
+        "-t,--transparent",
+        [cmd_state](auto count) {
+            cmd_state->transparent = (count != 0);
+        },
+        "Give the color 0 to the pixels whose alpha is below 128, and only to them"
+    );
+
+    cmd->add_option_function<std::string>(
+        "--dither",
+        [cmd_state](const std::string &name) {
+            cmd_state->dither = *nr::dune2::findDither(name);
+        },
+        "Dither, none, floyd-steinberg or ordered, default to none"
+    )->check(CLI::IsMember({"none", "floyd-steinberg", "ordered"}));
+
+    nr::addGzipOptions(*cmd, cmd_state->gzip);
+
+    cmd->add_option_function<fs::path>(
+        "PALETTE",
+        [cmd_state](const fs::path &paletteFilepath) {
+            cmd_state->paletteFilepath = paletteFilepath;
+        },
+        "Path to Dune2 .pal or .json file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<std::vector<fs::path>>(
+        "SOURCES",
+        [cmd_state](const std::vector<fs::path> &sources) {
+            cmd_state->sources = sources;
+        },
+        "Path to .bmp or .png files"
+    )->required()->check(CLI::ExistingFile);
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        nr::dune2::Palette palette;
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
+
+        // The cube is built once and shared by the conversions.
+        const nr::dune2::ColorCube cube(palette, cmd_state->transparent ? 1 : 0);
+
+        auto &executor = nr::getExecutor(app_state);
+        auto images = nr::dune2::parallelTransform(executor, cmd_state->sources.size(), [&](std::size_t i) {
+            const auto &source = cmd_state->sources[i];
+            nr::dune2::RGBImage image;
+            try {
+                image.load(source);
+            } catch (const std::exception &err) {
+                throw CLI::Error(
+                    "ImageFailure",
+                    fmt::format("Failed to load '{}': {}", source.string(), err.what()),
+                    CLI::ExitCodes::FileError
+                );
+            }
+            return nr::dune2::quantizeImage(image, cube, cmd_state->dither, cmd_state->transparent);
+        });
+
+        nr::dune2::ImageSet tileset;
+        for (auto &image: images) {
+            tileset.push_back(std::move(image));
+        }
+
+        if (cmd_state->trim) {
+            executor.parallelFor(tileset.getImageCount(), [&](std::size_t i) {
+                tileset.trim(i);
+            });
+        }
+
+        if (cmd_state->masks) {
+            executor.parallelFor(tileset.getImageCount(), [&](std::size_t i) {
+                tileset.getMask(i);
+            });
+        }
+
+        const auto json = tileset.toJSON(cmd_state->masks);
+
+        nr::writeJSON(
+            app_state,
+            json,
+            cmd_state->pretty,
+            cmd_state->gzip,
+            cmd_state->outputFilepath
+        );
     });
     return cmd;
 }
@@ -81,6 +265,9 @@ create_extract_command(AppState &app_state) {
         fs::path paletteFilepath;
         std::vector<fs::path> sources;
         fs::path outputDirectory{fs::current_path()};
+        std::optional<fs::path> archiveFilepath;
+        nr::ImageFormat imageFormat;
+        std::vector<nr::dune2::House> houses;
     };
 
     auto cmd = std::make_shared<App>();
@@ -97,13 +284,48 @@ create_extract_command(AppState &app_state) {
         "Specify the output directory"
     )->check(CLI::ExistingDirectory);
 
+    cmd->add_option_function<fs::path>(
+        "-a,--archive",
+        [cmd_state](const fs::path &archiveFilepath) {
+            cmd_state->archiveFilepath = archiveFilepath;
+        },
+        "Write all images into a single tar archive (use - for stdout)"
+    );
+
+    nr::addImageFormatOptions(*cmd, cmd_state->imageFormat);
+
+    cmd->add_option_function<std::vector<std::string>>(
+        "-H,--houses",
+        [cmd_state](const std::vector<std::string> &names) {
+            cmd_state->houses.clear();
+            for (const auto &name: names) {
+                if (name == "all") {
+                    for (auto i = 0u; i < nr::dune2::HouseCount; ++i) {
+                        cmd_state->houses.push_back(static_cast<nr::dune2::House>(i));
+                    }
+                } else {
+                    cmd_state->houses.push_back(*nr::dune2::findHouse(name));
+                }
+            }
+        },
+        "Extract a recolored image per house in a directory named after the house (house names or all)"
+    )->delimiter(',')->check(CLI::Validator(
+        [](std::string &name) -> std::string {
+            if (name == "all" || nr::dune2::findHouse(name)) {
+                return {};
+            }
+            return fmt::format("Unknown house: {}", name);
+        },
+        "HOUSE"
+    ));
+
     cmd->add_option_function<fs::path>(
         "PALETTE",
         [cmd_state](const fs::path &paletteFilepath) {
             cmd_state->paletteFilepath = paletteFilepath;
         },
         "Path to Dune2 .pal or .json file"
-    )->required()->check(CLI::ExistingFile);
+    )->required()->check(nr::existingAsset(app_state));
 
     cmd->add_option_function<std::vector<fs::path>>(
         "SOURCES",
@@ -111,34 +333,229 @@ create_extract_command(AppState &app_state) {
             cmd_state->sources = sources;
         },
         "Path to Dune2 .cps, .icn, .shp or .json files"
-    )->required()->check(CLI::ExistingFile);
+    )->required()->check(nr::existingAsset(app_state));
 
     cmd->callback([cmd, cmd_state, &app_state]{
         using fmt::format;
-        const auto output_directory = cmd_state->outputDirectory;
 
         nr::dune2::Palette palette;
-        nr::load(palette, cmd_state->paletteFilepath);
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
 
         nr::dune2::ImageSet images;
         for (auto &&source: cmd_state->sources) {
-            nr::load(images, source);
+            nr::load(app_state, images, source);
         }
 
+        const auto output = cmd_state->archiveFilepath
+            ? nr::createTarOutput(*cmd_state->archiveFilepath)
+            : nr::createDirectoryOutput(cmd_state->outputDirectory);
+
         std::for_each(
             images.begin(),
             images.end(),
             [&, i = 0u](const auto &tile) mutable {
-                const auto filename = format("{}.bmp", ++i);
-                nr::dune2::BMP bmp(tile.getWidth(), tile.getHeight());
-                bmp.drawSurface(0, 0, tile, palette);
-                bmp.store(output_directory/filename);
+                ++i;
+                if (cmd_state->houses.empty()) {
+                    output->store(format("{}", i), tile, palette, cmd_state->imageFormat);
+                    return;
+                }
+
+                // Each image is decoded once for all the houses.
+                const auto variants = nr::dune2::createHouseVariants(tile, cmd_state->houses);
+                for (auto k = 0u; k < variants.size(); ++k) {
+                    const auto house = nr::dune2::getHouseName(cmd_state->houses[k]);
+                    output->store(format("{}/{}", house, i), variants[k], palette, cmd_state->imageFormat);
+                }
             }
         );
     });
 
     return cmd;
 }
+CLI::App_p
+create_gif_command(AppState &app_state) {
+    struct CmdState {
+        fs::path paletteFilepath;
+        std::vector<fs::path> sources;
+        std::optional<fs::path> outputFilepath;
+        std::uint16_t delay{10};
+        bool transparent{false};
+        bool loop{true};
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("gif");
+    cmd->description("Export images as the frames of an animated gif file");
+
+    cmd->add_option_function<fs::path>(
+        "-o,--output-file",
+        [cmd_state](const fs::path &outputFilepath) {
+            cmd_state->outputFilepath = outputFilepath;
+        },
+        "Specify the output file"
+    );
+
+    cmd->add_option_function<std::uint16_t>(
+        "--delay",
+        [cmd_state](const std::uint16_t &delay) {
+            cmd_state->delay = delay;
+        },
+        "Frame duration in hundredths of second (default 10)"
+    );
+
+    cmd->add_flag_function(
+        "-t,--transparent",
+        [cmd_state](auto count) {
+            cmd_state->transparent = (count != 0);
+        },
+        "Make the color 0 transparent"
+    );
+
+    cmd->add_flag_function(
+        "--no-loop",
+        [cmd_state](auto count) {
+            cmd_state->loop = (count == 0);
+        },
+        "Play the animation once"
+    );
+
+    cmd->add_option_function<fs::path>(
+        "PALETTE",
+        [cmd_state](const fs::path &paletteFilepath) {
+            cmd_state->paletteFilepath = paletteFilepath;
+        },
+        "Path to Dune2 .pal or .json file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<std::vector<fs::path>>(
+        "SOURCES",
+        [cmd_state](const std::vector<fs::path> &sources) {
+            cmd_state->sources = sources;
+        },
+        "Path to Dune2 .cps, .icn, .shp or .json files"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->callback([cmd, cmd_state, &app_state]{
+        nr::dune2::Palette palette;
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
+
+        nr::dune2::ImageSet images;
+        for (auto &&source: cmd_state->sources) {
+            nr::load(app_state, images, source);
+        }
+
+        // Frames are drawn in the top left corner of a canvas large enough
+        // for the largest one.
+        std::size_t width = 0, height = 0;
+        for (const auto &image: images) {
+            width = std::max(width, image.getWidth());
+            height = std::max(height, image.getHeight());
+        }
+
+        const auto write = [&](std::ostream &output) {
+            nr::dune2::GIFWriter gif(output, width, height, palette, cmd_state->loop);
+            for (const auto &image: images) {
+                gif.write(image, cmd_state->delay, cmd_state->transparent);
+            }
+            gif.close();
+            output.flush();
+            return !output.fail();
+        };
+
+        auto ok = false;
+        if (cmd_state->outputFilepath) {
+            std::ofstream ofs(cmd_state->outputFilepath.value(), std::ios::binary);
+            ok = write(ofs);
+        } else {
+            ok = write(std::cout);
+        }
+
+        if (!ok) {
+            throw CLI::Error(
+                "WriteFailure",
+                fmt::format("Failed to write '{}'", cmd_state->outputFilepath
+                    ? cmd_state->outputFilepath->string()
+                    : std::string("stdout")),
+                CLI::ExitCodes::FileError
+            );
+        }
+    });
+
+    return cmd;
+}
+
+CLI::App_p
+create_icn_command(AppState &app_state) {
+    struct CmdState {
+        std::vector<fs::path> sources;
+        std::optional<fs::path> outputFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("icn");
+    cmd->description("Encode 16 colors tiles to a Dune2 .icn file");
+
+    cmd->add_option_function<fs::path>(
+        "-o,--output-file",
+        [cmd_state](const fs::path &outputFilepath) {
+            cmd_state->outputFilepath = outputFilepath;
+        },
+        "Specify the output file"
+    );
+
+    cmd->add_option_function<std::vector<fs::path>>(
+        "SOURCES",
+        [cmd_state](const std::vector<fs::path> &sources) {
+            cmd_state->sources = sources;
+        },
+        "Path to Dune2 .cps, .icn, .shp or .json files"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->callback([cmd, cmd_state, &app_state]{
+        nr::dune2::ImageSet images;
+        for (auto &&source: cmd_state->sources) {
+            nr::load(app_state, images, source);
+        }
+
+        const auto write = [&](std::ostream &output) {
+            try {
+                images.storeToICN(output);
+            } catch (const std::logic_error &err) {
+                throw CLI::Error(
+                    "ICNFailure",
+                    fmt::format("Failed to encode tiles: {}", err.what()),
+                    CLI::ExitCodes::InvalidError
+                );
+            }
+            output.flush();
+            return !output.fail();
+        };
+
+        auto ok = false;
+        if (cmd_state->outputFilepath) {
+            std::ofstream ofs(cmd_state->outputFilepath.value(), std::ios::binary);
+            ok = write(ofs);
+        } else {
+            ok = write(std::cout);
+        }
+
+        if (!ok) {
+            throw CLI::Error(
+                "WriteFailure",
+                fmt::format("Failed to write '{}'", cmd_state->outputFilepath
+                    ? cmd_state->outputFilepath->string()
+                    : std::string("stdout")),
+                CLI::ExitCodes::FileError
+            );
+        }
+    });
+
+    return cmd;
+}
 } // namespace
 
 CLI::App_p
@@ -149,7 +566,10 @@ createTilesetCommands(nr::AppState &app_state) {
     cmd->description("Image set commands");
     cmd->require_subcommand(1);
     cmd->add_subcommand(create_create_command(app_state));
+    cmd->add_subcommand(create_import_command(app_state));
     cmd->add_subcommand(create_extract_command(app_state));
+    cmd->add_subcommand(create_gif_command(app_state));
+    cmd->add_subcommand(create_icn_command(app_state));
 
     return cmd;
 }
@@ -0,0 +1,405 @@
+#include <app.hpp>
+
+#include <Dune2/band_renderer.hpp>
+#include <Dune2/bmp.hpp>
+#include <Dune2/color_stats.hpp>
+#include <Dune2/map.hpp>
+#include <Dune2/mosaic.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+namespace {
+namespace fs = std::filesystem;
+
+using nr::AppState;
+
+// Generate the maps for the seeds [first_seed, first_seed + maps.size()).
+void
+generate_maps(
+    nr::dune2::Executor &executor,
+    std::uint32_t first_seed,
+    std::vector<nr::dune2::Map> &maps
+) {
+    executor.parallelFor(maps.size(), [&](std::size_t i) {
+        maps[i].generate(first_seed + i);
+    });
+}
+
+CLI::App_p
+create_generate_command(AppState &app_state) {
+    struct CmdState {
+        bool pretty{false};
+        nr::GzipOptions gzip;
+        std::uint32_t seed{0};
+        std::size_t count{1};
+        std::optional<fs::path> outputFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("generate");
+    cmd->description("Generate Dune2 maps from their seeds");
+
+    cmd->add_flag_function(
+        "-p,--pretty",
+        [cmd_state](auto count) {
+            cmd_state->pretty = (count != 0);
+        },
+        "Enable pretty output"
+    );
+
+    cmd->add_option_function<fs::path>(
+        "-o,--output-file",
+        [cmd_state](const fs::path &outputFilepath) {
+            cmd_state->outputFilepath = outputFilepath;
+        },
+        "Specify the output file"
+    );
+
+    nr::addGzipOptions(*cmd, cmd_state->gzip);
+
+    cmd->add_option_function<std::uint32_t>(
+        "-s,--seed",
+        [cmd_state](const std::uint32_t &seed) {
+            cmd_state->seed = seed;
+        },
+        "Seed of the first map (default 0)"
+    );
+
+    cmd->add_option_function<std::size_t>(
+        "-n,--count",
+        [cmd_state](const std::size_t &count) {
+            cmd_state->count = count;
+        },
+        "Number of maps to generate, seeds are consecutive (default 1)"
+    )->check(CLI::PositiveNumber);
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        std::vector<nr::dune2::Map> maps(cmd_state->count);
+        generate_maps(nr::getExecutor(app_state), cmd_state->seed, maps);
+
+        rapidjson::Document json;
+        auto &allocator = json.GetAllocator();
+
+        json.SetArray();
+        for (const auto &map: maps) {
+            json.PushBack(map.toJSON(allocator), allocator);
+        }
+
+        nr::writeJSON(
+            app_state,
+            json,
+            cmd_state->pretty,
+            cmd_state->gzip,
+            cmd_state->outputFilepath
+        );
+    });
+
+    return cmd;
+}
+
+std::vector<nr::dune2::Map>
+load_maps(const fs::path &filepath) {
+    std::ifstream input(filepath);
+    const auto json = nr::dune2::io::loadJSON(input);
+
+    std::vector<nr::dune2::Map> maps;
+    if (json.IsArray()) {
+        maps.resize(json.Size());
+        for (auto i = 0u; i < json.Size(); ++i) {
+            maps[i].loadFromJSON(json[i]);
+        }
+    } else {
+        maps.emplace_back().loadFromJSON(json);
+    }
+    return maps;
+}
+
+// Render surfaces in a mosaic to a bmp file, or to the standard output if no
+// file is given.
+template<typename S>
+void
+render_mosaic(
+    AppState &app_state,
+    const std::vector<S> &surfaces,
+    const nr::dune2::Palette &palette,
+    std::optional<std::size_t> columns,
+    std::size_t band_height,
+    const std::optional<fs::path> &output_filepath
+) {
+    nr::dune2::Mosaic mosaic(columns.value_or(
+        static_cast<std::size_t>(std::ceil(std::sqrt(surfaces.size())))
+    ));
+    for (const auto &surface: surfaces) {
+        mosaic.push_back(surface);
+    }
+
+    const auto render = [&](std::ostream &output) {
+        nr::dune2::BMPBandWriter bmp(output, mosaic.getWidth(), mosaic.getHeight());
+        nr::dune2::BandRenderer renderer(mosaic, palette, band_height);
+        renderer.render(
+            [&](const auto *pixels, auto row_count) {
+                bmp.write(pixels, row_count);
+            },
+            nr::getExecutor(app_state)
+        );
+    };
+
+    if (output_filepath) {
+        std::ofstream ofs(output_filepath.value(), std::ios::binary);
+        render(ofs);
+    } else {
+        render(std::cout);
+    }
+}
+
+CLI::App_p
+create_render_command(AppState &app_state) {
+    struct CmdState {
+        std::optional<fs::path> outputFilepath;
+        std::size_t bandHeight{64};
+        std::optional<std::size_t> columns;
+        fs::path paletteFilepath;
+        fs::path imageSetFilepath;
+        fs::path iconSetFilepath;
+        fs::path mapsFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("render");
+    cmd->description("Render maps to a bmp file");
+
+    cmd->add_option_function<fs::path>(
+        "-o,--output-file",
+        [cmd_state](const fs::path &outputFilepath) {
+            cmd_state->outputFilepath = outputFilepath;
+        },
+        "Specify the output file"
+    );
+
+    cmd->add_option_function<std::size_t>(
+        "-b,--band-height",
+        [cmd_state](const std::size_t &bandHeight) {
+            cmd_state->bandHeight = bandHeight;
+        },
+        "Number of rows rendered at once (default 64)"
+    )->check(CLI::PositiveNumber);
+
+    cmd->add_option_function<std::size_t>(
+        "-c,--columns",
+        [cmd_state](const std::size_t &columns) {
+            cmd_state->columns = columns;
+        },
+        "Number of maps on a row of the mosaic (default to a square mosaic)"
+    )->check(CLI::PositiveNumber);
+
+    cmd->add_option_function<fs::path>(
+        "PALETTE",
+        [cmd_state](const fs::path &paletteFilepath) {
+            cmd_state->paletteFilepath = paletteFilepath;
+        },
+        "Path to Dune2 .pal or .json file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "IMAGE_SET",
+        [cmd_state](const fs::path &imageSetFilepath) {
+            cmd_state->imageSetFilepath = imageSetFilepath;
+        },
+        "Path to Dune2 ICON.ICN file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "ICON_SET",
+        [cmd_state](const fs::path &iconSetFilepath) {
+            cmd_state->iconSetFilepath = iconSetFilepath;
+        },
+        "Path to Dune2 ICON.MAP file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "MAPS",
+        [cmd_state](const fs::path &mapsFilepath) {
+            cmd_state->mapsFilepath = mapsFilepath;
+        },
+        "Path to a .json file produced by 'maps generate'"
+    )->required()->check(CLI::ExistingFile);
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        nr::dune2::Palette palette;
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
+
+        nr::dune2::ImageSet images;
+        nr::load(app_state, images, cmd_state->imageSetFilepath, nr::dune2::ImageSet::LoadPolicy::Lazy);
+
+        nr::dune2::IconSet icons;
+        nr::load(app_state, icons, cmd_state->iconSetFilepath);
+
+        const auto maps = load_maps(cmd_state->mapsFilepath);
+        if (maps.empty()) {
+            return;
+        }
+
+        std::vector<nr::dune2::Map::Surface> surfaces;
+        for (const auto &map: maps) {
+            surfaces.emplace_back(map, icons, images);
+        }
+
+        render_mosaic(
+            app_state,
+            surfaces,
+            palette,
+            cmd_state->columns,
+            cmd_state->bandHeight,
+            cmd_state->outputFilepath
+        );
+    });
+
+    return cmd;
+}
+
+CLI::App_p
+create_minimap_command(AppState &app_state) {
+    struct CmdState {
+        std::optional<fs::path> outputFilepath;
+        std::optional<std::size_t> columns;
+        nr::dune2::LUTColor lutColor{nr::dune2::LUTColor::Dominant};
+        fs::path paletteFilepath;
+        fs::path imageSetFilepath;
+        fs::path iconSetFilepath;
+        fs::path mapsFilepath;
+    };
+
+    auto cmd = std::make_shared<App>();
+    auto cmd_state = std::make_shared<CmdState>();
+
+    cmd->name("minimap");
+    cmd->description("Render maps to a bmp file, one pixel per cell");
+
+    cmd->add_option_function<fs::path>(
+        "-o,--output-file",
+        [cmd_state](const fs::path &outputFilepath) {
+            cmd_state->outputFilepath = outputFilepath;
+        },
+        "Specify the output file"
+    );
+
+    cmd->add_option_function<std::size_t>(
+        "-c,--columns",
+        [cmd_state](const std::size_t &columns) {
+            cmd_state->columns = columns;
+        },
+        "Number of maps on a row of the mosaic (default to a square mosaic)"
+    )->check(CLI::PositiveNumber);
+
+    cmd->add_flag_function(
+        "-m,--mean",
+        [cmd_state](auto count) {
+            cmd_state->lutColor = count != 0
+                ? nr::dune2::LUTColor::Mean
+                : nr::dune2::LUTColor::Dominant;
+        },
+        "Use the mean color of the landscape icons instead of their dominant color"
+    );
+
+    cmd->add_option_function<fs::path>(
+        "PALETTE",
+        [cmd_state](const fs::path &paletteFilepath) {
+            cmd_state->paletteFilepath = paletteFilepath;
+        },
+        "Path to Dune2 .pal or .json file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "IMAGE_SET",
+        [cmd_state](const fs::path &imageSetFilepath) {
+            cmd_state->imageSetFilepath = imageSetFilepath;
+        },
+        "Path to Dune2 ICON.ICN file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "ICON_SET",
+        [cmd_state](const fs::path &iconSetFilepath) {
+            cmd_state->iconSetFilepath = iconSetFilepath;
+        },
+        "Path to Dune2 ICON.MAP file"
+    )->required()->check(nr::existingAsset(app_state));
+
+    cmd->add_option_function<fs::path>(
+        "MAPS",
+        [cmd_state](const fs::path &mapsFilepath) {
+            cmd_state->mapsFilepath = mapsFilepath;
+        },
+        "Path to a .json file produced by 'maps generate'"
+    )->required()->check(CLI::ExistingFile);
+
+    cmd->callback([cmd, cmd_state, &app_state] {
+        nr::dune2::Palette palette;
+        nr::load(app_state, palette, cmd_state->paletteFilepath);
+
+        nr::dune2::ImageSet images;
+        nr::load(app_state, images, cmd_state->imageSetFilepath, nr::dune2::ImageSet::LoadPolicy::Lazy);
+
+        nr::dune2::IconSet icons;
+        nr::load(app_state, icons, cmd_state->iconSetFilepath);
+
+        const auto maps = load_maps(cmd_state->mapsFilepath);
+        if (maps.empty()) {
+            return;
+        }
+
+        // The table is computed once, then each map costs a lookup per cell.
+        auto &executor = nr::getExecutor(app_state);
+        const auto lut = nr::dune2::createLandscapeLUT(
+            icons,
+            nr::dune2::computeIconColorStats(icons, nr::dune2::computeTileColorStats(images, executor)),
+            palette,
+            cmd_state->lutColor
+        );
+
+        std::vector<nr::dune2::Map::Minimap> surfaces;
+        for (const auto &map: maps) {
+            surfaces.emplace_back(map, lut);
+        }
+
+        render_mosaic(
+            app_state,
+            surfaces,
+            palette,
+            cmd_state->columns,
+            nr::dune2::Map::Height,
+            cmd_state->outputFilepath
+        );
+    });
+
+    return cmd;
+}
+
+} // namespace
+
+CLI::App_p
+createMapsCommands(AppState &app_state) {
+    auto cmd = std::make_shared<App>();
+
+    cmd->name("maps");
+    cmd->description("Map commands");
+    cmd->require_subcommand(1);
+    cmd->add_subcommand(create_generate_command(app_state));
+    cmd->add_subcommand(create_render_command(app_state));
+    cmd->add_subcommand(create_minimap_command(app_state));
+
+    return cmd;
+}
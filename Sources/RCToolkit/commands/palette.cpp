@@ -24,6 +24,7 @@ CLI::App_p
 create_create_command(AppState &app_state) {
     struct CmdState {
         bool pretty{false};
+        nr::GzipOptions gzip;
         fs::path inputFilepath;
         std::optional<fs::path> outputFilepath;
     };
@@ -50,26 +51,29 @@ create_create_command(AppState &app_state) {
         "Specify the output file"
     );
 
+    nr::addGzipOptions(*cmd, cmd_state->gzip);
+
     cmd->add_option_function<fs::path>(
         "PAL_FILE_PATH",
         [cmd_state](const fs::path &filepath) {
             cmd_state->inputFilepath = filepath;
         },
         "Path to Dune2 .pal file"
-    )->check(CLI::ExistingFile)->required();
+    )->check(nr::existingAsset(app_state))->required();
 
     cmd->callback([cmd, cmd_state, &app_state] {
         nr::dune2::Palette pal;
 
-        pal.loadFromPAL(cmd_state->inputFilepath);
+        pal.loadFromPAL(*nr::openAsset(app_state, cmd_state->inputFilepath));
         const auto json = pal.toJSON();
 
-        if (cmd_state->outputFilepath) {
-            std::ofstream ofs(cmd_state->outputFilepath.value());
-            nr::flushJSON(json, cmd_state->pretty, ofs);
-        } else {
-            nr::flushJSON(json, cmd_state->pretty, std::cout);
-        }
+        nr::writeJSON(
+            app_state,
+            json,
+            cmd_state->pretty,
+            cmd_state->gzip,
+            cmd_state->outputFilepath
+        );
     });
     return cmd;
 }
@@ -102,11 +106,11 @@ create_extract_command(AppState &app_state) {
             cmd_state->inputFilepath = filepath;
         },
         "Path to Dune2 .pal or .json palette file"
-    )->check(CLI::ExistingFile)->required();
+    )->check(nr::existingAsset(app_state))->required();
 
     cmd->callback([cmd, cmd_state, &app_state] {
         nr::dune2::Palette pal;
-        nr::load(pal, cmd_state->inputFilepath);
+        nr::load(app_state, pal, cmd_state->inputFilepath);
         pal.toBMP().store(cmd_state->outputFilepath);
     });
 
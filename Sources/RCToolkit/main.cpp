@@ -1,33 +1,150 @@
 #include <app.hpp>
 
+#include <Dune2/memory.hpp>
+#include <Dune2/trace.hpp>
+
 #include <fmt/format.h>
 
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+
 CLI::App_p createPaletteCommands(nr::AppState &);
 CLI::App_p createTilesetCommands(nr::AppState &);
 CLI::App_p createIconsetCommands(nr::AppState &);
+CLI::App_p createMapsCommands(nr::AppState &);
+CLI::App_p createAnimationCommands(nr::AppState &);
+CLI::App_p createAudioCommands(nr::AppState &);
+CLI::App_p createCorpusCommands(nr::AppState &);
+CLI::App_p createCatalogCommands(nr::AppState &);
+
+namespace {
+void
+print_memory_report(const nr::dune2::memory::Report &report, std::ostream &output) {
+    const auto mib = [](std::size_t bytes) { return bytes/(1024.*1024.); };
+
+    if (report.accounting) {
+        for (const auto &subsystem: report.subsystems) {
+            output << fmt::format(
+                "{:<16} {:>10} allocations {:>12.3f} MiB\n",
+                subsystem.name,
+                subsystem.allocationCount,
+                mib(subsystem.allocatedBytes)
+            );
+        }
+        output << fmt::format("peak heap        {:>12.3f} MiB\n", mib(report.peakHeapBytes));
+    } else {
+        output << "allocations are not counted, build with -DMEMORY_STATS=ON\n";
+    }
+    output << fmt::format("peak RSS         {:>12.3f} MiB\n", mib(report.peakRSS));
+}
+} // namespace
 
 int
 main(int argc, char const *argv[]) {
     App app{"Manage Dune2 resources file"};
     nr::AppState app_state;
+    std::optional<std::filesystem::path> trace_filepath;
+    std::optional<std::filesystem::path> memory_stats_filepath;
+    bool memory_stats{false};
 
-    app.add_flag(
+    app.add_flag_function(
         "-v,--verbose",
-        app_state.verbose,
+        [&](auto count) {
+            app_state.verbose = count;
+            // Phase timings are printed on verbose output.
+            nr::dune2::trace::enable();
+        },
         "Produce verbose output"
     );
 
+    app.add_option(
+        "-j,--jobs",
+        app_state.jobs,
+        "Number of threads used by the commands (default to one per core)"
+    );
+
+    app.add_option_function<std::filesystem::path>(
+        "--catalog",
+        [&](const std::filesystem::path &filepath) {
+            app_state.catalogFilepath = filepath;
+        },
+        "Resolve input files missing on disk through the given catalog"
+    )->check(CLI::ExistingFile);
+
+    app.add_option_function<std::filesystem::path>(
+        "--trace",
+        [&](const std::filesystem::path &filepath) {
+            trace_filepath = filepath;
+            nr::dune2::trace::enable();
+        },
+        "Write a Chrome trace of the command to the given file"
+    );
+
+    app.add_flag_function(
+        "--memory-stats",
+        [&](auto count) {
+            memory_stats = (count != 0);
+            if (memory_stats) {
+                nr::dune2::memory::enable();
+            }
+        },
+        "Print allocations per subsystem and peak memory at exit"
+    );
+
+    app.add_option_function<std::filesystem::path>(
+        "--memory-stats-json",
+        [&](const std::filesystem::path &filepath) {
+            memory_stats_filepath = filepath;
+            nr::dune2::memory::enable();
+        },
+        "Write allocations per subsystem and peak memory to the given file"
+    );
+
     app.require_subcommand(1);
 
     app.add_subcommand(createPaletteCommands(app_state));
     app.add_subcommand(createTilesetCommands(app_state));
     app.add_subcommand(createIconsetCommands(app_state));
+    app.add_subcommand(createMapsCommands(app_state));
+    app.add_subcommand(createAnimationCommands(app_state));
+    app.add_subcommand(createAudioCommands(app_state));
+    app.add_subcommand(createCorpusCommands(app_state));
+    app.add_subcommand(createCatalogCommands(app_state));
 
+    auto status = 0;
     try {
         app.parse((argc), (argv));
     } catch (const CLI::Error &e) {
-        return app.exit(e);
+        status = app.exit(e);
+    }
+
+    if (trace_filepath) {
+        std::ofstream ofs(*trace_filepath);
+        nr::flushJSON(nr::dune2::trace::toJSON(), false, ofs);
+    }
+    if (app_state.verbose > 0) {
+        for (const auto &phase: nr::dune2::trace::getPhases()) {
+            std::cerr << fmt::format(
+                "{:<16} {:>8} {:>12.3f} ms\n",
+                phase.name,
+                phase.count,
+                phase.duration.count()/1000.
+            );
+        }
+    }
+
+    if (memory_stats || memory_stats_filepath) {
+        const auto report = nr::dune2::memory::getReport();
+        if (memory_stats_filepath) {
+            std::ofstream ofs(*memory_stats_filepath);
+            nr::flushJSON(report.toJSON(), false, ofs);
+        }
+        if (memory_stats) {
+            print_memory_report(report, std::cerr);
+        }
     }
 
-    return 0;
+    return status;
 }
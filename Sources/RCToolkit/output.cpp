@@ -0,0 +1,121 @@
+#include "output.hpp"
+
+#include <Dune2/trace.hpp>
+
+#include <fstream>
+#include <iostream>
+
+namespace nr {
+namespace fs = std::filesystem;
+
+namespace {
+
+class DirectoryOutput : public Output {
+public:
+    explicit DirectoryOutput(const fs::path &directory)
+        : directory_{directory} {
+    }
+
+public:
+    using Output::store;
+    virtual void store(
+        const std::string &name,
+        std::size_t,
+        const DataWriter &write
+    ) override {
+        nr::dune2::trace::Span span("output.write");
+
+        const auto filepath = directory_/name;
+        fs::create_directories(filepath.parent_path());
+
+        std::ofstream output(filepath, std::ofstream::binary);
+        write(output);
+    }
+
+private:
+    fs::path directory_;
+};
+
+class TarOutput : public Output {
+public:
+    explicit TarOutput(const fs::path &filepath)
+        : file_{filepath == "-"
+            ? nullptr
+            : std::make_unique<std::ofstream>(filepath, std::ofstream::binary)}
+        , tar_{file_ ? *file_ : std::cout} {
+    }
+
+public:
+    using Output::store;
+    virtual void store(
+        const std::string &name,
+        std::size_t size,
+        const DataWriter &write
+    ) override {
+        nr::dune2::trace::Span span("output.write");
+
+        tar_.append(name, size, write);
+    }
+
+private:
+    std::unique_ptr<std::ofstream> file_;
+    dune2::TarWriter tar_;
+};
+
+} // namespace
+
+void
+Output::store(const std::string &name, const dune2::BMP &bmp) {
+    store(name, bmp.getFileSize(), [&](std::ostream &output) {
+        bmp.store(output);
+    });
+}
+
+void
+Output::store(
+    const std::string &name,
+    const dune2::Surface &surface,
+    const dune2::Palette &palette,
+    const ImageFormat &format
+) {
+    if (format.scale > 1) {
+        const auto scaled = dune2::scaleSurface(surface, format.scale, format.scaleFilter);
+        auto unscaled_format = format;
+        unscaled_format.scale = 1;
+        store(name, scaled, palette, unscaled_format);
+        return;
+    }
+
+    switch (format.type) {
+    case ImageFormat::Type::PNG: {
+        if (surface.getWidth() == 0 || surface.getHeight() == 0) {
+            break;
+        }
+        dune2::PNG png(surface.getWidth(), surface.getHeight());
+        png.drawSurface(0, 0, surface);
+        const auto data = png.encode(palette, format.png);
+        store(name + ".png", data.size(), [&](std::ostream &output) {
+            output.write(data.data(), data.size());
+        });
+        break;
+    }
+    case ImageFormat::Type::BMP: {
+        dune2::BMP bmp(surface.getWidth(), surface.getHeight());
+        bmp.drawSurface(0, 0, surface, palette);
+        store(name + ".bmp", bmp);
+        break;
+    }
+    }
+}
+
+std::unique_ptr<Output>
+createDirectoryOutput(const fs::path &directory) {
+    return std::make_unique<DirectoryOutput>(directory);
+}
+
+std::unique_ptr<Output>
+createTarOutput(const fs::path &filepath) {
+    return std::make_unique<TarOutput>(filepath);
+}
+
+} // namespace nr
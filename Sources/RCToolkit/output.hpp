@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Dune2/bmp.hpp>
+#include <Dune2/palette.hpp>
+#include <Dune2/png.hpp>
+#include <Dune2/scale.hpp>
+#include <Dune2/surface.hpp>
+#include <Dune2/tar.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace nr {
+
+/// ### struct `nr::ImageFormat`
+/// The file format and scale of the images produced by the extract commands.
+struct ImageFormat {
+    enum class Type {
+        BMP,
+        PNG,
+    };
+    Type type{Type::BMP};
+    dune2::PNG::Options png;
+    std::size_t scale{1};
+    dune2::ScaleFilter scaleFilter{dune2::ScaleFilter::Nearest};
+};
+
+/// ### class `nr::Output`
+/// Destination of the files produced by the extract commands.
+class Output {
+public:
+    using DataWriter = dune2::TarWriter::DataWriter;
+
+public:
+    virtual ~Output() = default;
+
+public:
+    /// ### method `nr::Output.store`
+    /// Store a file.
+    /// #### Parameters
+    /// - `const std::string &name` - the file name
+    /// - `std::size_t size` - the exact number of bytes `write` will produce
+    /// - `const DataWriter &write` - a function writing the file data
+    virtual void store(const std::string &name, std::size_t size, const DataWriter &) = 0;
+
+    /// ### method `nr::Output.store`
+    /// Store a bitmap.
+    /// #### Parameters
+    /// - `const std::string &name` - the file name
+    /// - `const dune2::BMP &bmp` - the bitmap
+    void store(const std::string &name, const dune2::BMP &);
+
+    /// ### method `nr::Output.store`
+    /// Store a surface in the given image format, scaled first if the format
+    /// has a scale. The file extension of the format is appended to the
+    /// name. _PNG_ can not hold an image without pixels, such a surface is
+    /// not stored in this format.
+    /// #### Parameters
+    /// - `const std::string &name` - the file name without extension
+    /// - `const dune2::Surface &surface` - the surface
+    /// - `const dune2::Palette &palette` - the palette
+    /// - `const ImageFormat &format` - the image format
+    void store(
+        const std::string &name,
+        const dune2::Surface &,
+        const dune2::Palette &,
+        const ImageFormat &
+    );
+};
+
+/// ### function `nr::createDirectoryOutput`
+/// Create an `Output` writing one file per entry in the given directory.
+std::unique_ptr<Output> createDirectoryOutput(const std::filesystem::path &);
+
+/// ### function `nr::createTarOutput`
+/// Create an `Output` streaming all entries into a single uncompressed tar
+/// archive. If the given path is `-`, the archive is written on the standard
+/// output.
+std::unique_ptr<Output> createTarOutput(const std::filesystem::path &);
+
+} // namespace nr